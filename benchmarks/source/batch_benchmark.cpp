@@ -0,0 +1,172 @@
+#include "benchmarks.hpp"
+
+#include <ftl/math_batch.hpp>
+#include <ftl/random.hpp>
+
+#include <float.h>
+#include <string.h>
+
+using namespace fabric;
+using namespace ftl;
+
+// NOTE: Measures the memory bandwidth the batch kernels reach on count matrices and 4 * count points, next to a
+//       memcpy of the matrix array. The bytes counted are the inputs read plus the outputs written. ftl::multiply
+//       has to match mat4::operator* exactly, the point transforms are compared with a reference computed in f64.
+
+namespace {
+    // Unit roundoff of f32.
+    static constexpr f64 roundoff = FLT_EPSILON * 0.5;
+
+    // Worst transform error accepted, in units of the rounding error bound of a 4 term dot product.
+    static constexpr f64 transform_tolerance = 8.0;
+
+    static constexpr u64 points_per_matrix = 4;
+
+    // The multiply output is aligned to a cache line, so ftl::multiply can stream it with AVX as well.
+    static constexpr u64 output_alignment = 64;
+
+    template <typename T>
+    FBINLINE T absolute(T v) {
+        return v < 0 ? -v : v;
+    }
+
+    // Best of a few runs, the first one also pays for cold caches.
+    template <typename F>
+    f64 best_seconds(F&& run) {
+        f64 best = 0.0;
+        for (u32 i = 0; i < 3; i++) {
+            f64 start = benchmark_time();
+            run();
+            f64 elapsed = benchmark_time() - start;
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+        return best;
+    }
+
+    f64 report(const char* name, u64 bytes, f64 seconds, f64 baseline) {
+        f64 rate = (f64)bytes / seconds * 1e-9;
+        if (baseline > 0.0) {
+            FBINFO("  %-20s %7.2f GB/s  %5.1f%% of memcpy", name, rate, 100.0 * rate / baseline);
+        } else {
+            FBINFO("  %-20s %7.2f GB/s", name, rate);
+        }
+        return rate;
+    }
+
+    mat4* aligned(void* block) {
+        return (mat4*)(((u64)block + output_alignment - 1) & ~(output_alignment - 1));
+    }
+
+    // Each component's error over 4u (|x m0| + |y m4| + |z m8| + |m12|), written so NaN counts as the worst.
+    f64 transform_error(const mat4& matrix, const vec3f& point, const vec3f& result) {
+        const f32* m = matrix.mat;
+        f64 x = point.x, y = point.y, z = point.z;
+        f64 worst = 0.0;
+        for (u32 c = 0; c < 3; c++) {
+            f64 reference = x * m[c] + y * m[4 + c] + z * m[8 + c] + (f64)m[12 + c];
+            f64 bound = absolute(x * m[c]) + absolute(y * m[4 + c]) + absolute(z * m[8 + c]) + absolute((f64)m[12 + c]);
+            bound *= 4.0 * roundoff;
+
+            f64 error = absolute((f64)result.vec[c] - reference);
+            error = bound > 0.0 ? error / bound : error;
+            worst = error <= worst ? worst : error;
+        }
+        return worst;
+    }
+
+    b8 check_points(const char* name, const mat4& matrix, const vec3f* in, const vec3f* out, u64 count) {
+        for (u64 i = 0; i < count; i++) {
+            f64 error = transform_error(matrix, in[i], out[i]);
+            if (!(error <= transform_tolerance)) {
+                FBERROR("%s: Point %llu (%.9g %.9g %.9g) is off by %.3f, over the tolerance of %.1f.", name, i, in[i].x, in[i].y, in[i].z, error, transform_tolerance);
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+b8 batch_benchmark(u64 count) {
+#if FBSIMD_AVX
+    FBINFO("Batch kernels on %llu matrices and %llu points, AVX paths.", count, count * points_per_matrix);
+#elif FBSIMD_SSE2
+    FBINFO("Batch kernels on %llu matrices and %llu points, SSE paths.", count, count * points_per_matrix);
+#else
+    FBINFO("Batch kernels on %llu matrices and %llu points, scalar paths (FB_SIMD_DISABLED).", count, count * points_per_matrix);
+#endif
+
+    u64 matrix_bytes = count * sizeof(mat4);
+    u64 point_count = count * points_per_matrix;
+    u64 point_bytes = point_count * sizeof(vec3f);
+
+    mat4* a = (mat4*)memory::fballocate(matrix_bytes, memory::MEMORY_TAG_ARRAY);
+    mat4* b = (mat4*)memory::fballocate(matrix_bytes, memory::MEMORY_TAG_ARRAY);
+    void* result_block = memory::fballocate(matrix_bytes + output_alignment, memory::MEMORY_TAG_ARRAY);
+    mat4* result = aligned(result_block);
+    mat4* expected = (mat4*)memory::fballocate(matrix_bytes, memory::MEMORY_TAG_ARRAY);
+
+    vec3f* points = (vec3f*)memory::fballocate(point_bytes, memory::MEMORY_TAG_ARRAY);
+    vec3f* transformed = (vec3f*)memory::fballocate(point_bytes, memory::MEMORY_TAG_ARRAY);
+
+    f32* soa = (f32*)memory::fballocate(point_count * 6 * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+    vec3_soa soa_in = {soa, soa + point_count, soa + point_count * 2};
+    vec3_soa soa_out = {soa + point_count * 3, soa + point_count * 4, soa + point_count * 5};
+
+    // Fixed seed, so a failure reproduces with the same count.
+    rng random(0x62617463);
+    random.fill(a[0].mat, count * 16, -1.0f, 1.0f);
+    random.fill(b[0].mat, count * 16, -1.0f, 1.0f);
+    random.fill(&points[0].x, point_count * 3, -100.0f, 100.0f);
+    for (u64 i = 0; i < point_count; i++) {
+        soa_in.x[i] = points[i].x;
+        soa_in.y[i] = points[i].y;
+        soa_in.z[i] = points[i].z;
+    }
+
+    mat4 transform = a[0];
+    b8 success = true;
+
+    f64 seconds = best_seconds([&] { memcpy(result, a, matrix_bytes); });
+    f64 baseline = report("memcpy", matrix_bytes * 2, seconds, 0.0);
+
+    seconds = best_seconds([&] { transform_points(transform, points, transformed, point_count); });
+    report("transform_points", point_bytes * 2, seconds, baseline);
+    success &= check_points("transform_points", transform, points, transformed, point_count);
+
+    seconds = best_seconds([&] { transform_points(transform, soa_in, soa_out, point_count); });
+    report("transform_points soa", point_bytes * 2, seconds, baseline);
+    for (u64 i = 0; i < point_count; i++) {
+        transformed[i] = vec3f(soa_out.x[i], soa_out.y[i], soa_out.z[i]);
+    }
+    success &= check_points("transform_points soa", transform, points, transformed, point_count);
+
+    seconds = best_seconds([&] {
+        for (u64 i = 0; i < count; i++) {
+            expected[i] = a[i] * b[i];
+        }
+    });
+    report("mat4 operator*", matrix_bytes * 3, seconds, baseline);
+
+    seconds = best_seconds([&] { multiply(a, b, result, count); });
+    report("multiply", matrix_bytes * 3, seconds, baseline);
+
+    if (memcmp(result, expected, matrix_bytes) != 0) {
+        for (u64 i = 0; i < count; i++) {
+            if (memcmp(&result[i], &expected[i], sizeof(mat4)) != 0) {
+                FBERROR("multiply: Matrix %llu differs from mat4::operator*.", i);
+                break;
+            }
+        }
+        success = false;
+    }
+
+    memory::fbfree(a, matrix_bytes, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(b, matrix_bytes, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(result_block, matrix_bytes + output_alignment, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(expected, matrix_bytes, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(points, point_bytes, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(transformed, point_bytes, memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(soa, point_count * 6 * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+
+    return success;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <fabric.hpp>
+
+// Each benchmark checks the results it timed against a reference and returns false when they disagree.
+// count is the number of items processed per measurement.
+b8 matrix_benchmark(u64 count);
+b8 ecs_benchmark(u64 count);
+b8 intersection_benchmark(u64 count);
+b8 batch_benchmark(u64 count);
+b8 bvh_benchmark(u64 count);
+b8 packing_benchmark(u64 count);
+
+// Seconds since an arbitrary point. The engine clock belongs to the platform layer, which isn't started here.
+f64 benchmark_time();
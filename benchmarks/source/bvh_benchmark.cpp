@@ -0,0 +1,272 @@
+#include "benchmarks.hpp"
+
+#include <ftl/bvh.hpp>
+#include <ftl/random.hpp>
+
+#include <math.h>
+
+using namespace fabric;
+using namespace ftl;
+
+// NOTE: Builds a bvh over count random boxes, serially and with one thread per processor, and times frustum,
+//       box and ray queries against it, then refits it after every box moved a little. The first queries of
+//       each kind are compared with a brute force pass over all boxes, before and after the refit.
+
+namespace {
+    static constexpr u32 frustum_queries = 1000;
+    static constexpr u32 box_queries = 100000;
+    static constexpr u32 ray_queries = 100000;
+    static constexpr u32 checked_queries = 16;
+
+    // Boxes fill a 1000 unit cube about 10 units apart, so a frustum sees a few thousand of them.
+    static constexpr f32 world_extent = 500.0f;
+    static constexpr f32 query_extent = 10.0f;
+    static constexpr f32 max_move = 1.0f;
+
+    // Largest accepted difference in t between the bvh and the brute force pass, relative to t past 1.
+    static constexpr f32 t_tolerance = 1e-4f;
+
+    struct queries {
+        frustum* frusta;
+        aabb* boxes;
+        ray* rays;
+    };
+
+    // Best of a few runs, the first one also pays for cold caches.
+    template <typename F>
+    f64 best_seconds(F&& run) {
+        f64 best = 0.0;
+        for (u32 i = 0; i < 3; i++) {
+            f64 start = benchmark_time();
+            run();
+            f64 elapsed = benchmark_time() - start;
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+        return best;
+    }
+
+    vec3f random_point(rng& random, f32 extent) {
+        return vec3f(random.range(-extent, extent), random.range(-extent, extent), random.range(-extent, extent));
+    }
+
+    void fill_boxes(rng& random, aabb* boxes, u32 count) {
+        for (u32 i = 0; i < count; i++) {
+            vec3f center = random_point(random, world_extent);
+            vec3f extent(random.range(0.5f, 2.5f), random.range(0.5f, 2.5f), random.range(0.5f, 2.5f));
+            boxes[i] = {center - extent, center + extent};
+        }
+    }
+
+    void fill_queries(rng& random, queries& q) {
+        mat4 projection = perspective(FB_PI / 3.0f, 16.0f / 9.0f, 0.1f, 200.0f);
+        for (u32 i = 0; i < frustum_queries; i++) {
+            vec3f eye = random_point(random, world_extent);
+            vec3f target = eye + random_point(random, 1.0f);
+            q.frusta[i] = extract_frustum(look_at(eye, target, vec3f(0.0f, 1.0f, 0.0f)) * projection);
+        }
+
+        for (u32 i = 0; i < box_queries; i++) {
+            vec3f center = random_point(random, world_extent);
+            q.boxes[i] = {center - vec3f(query_extent), center + vec3f(query_extent)};
+        }
+
+        for (u32 i = 0; i < ray_queries; i++) {
+            q.rays[i] = {random_point(random, world_extent), random_point(random, 1.0f)};
+        }
+    }
+
+    b8 overlaps(const aabb& a, const aabb& b) {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    // Slab test, the ray may start inside.
+    f32 ray_box(const ray& r, const aabb& box) {
+        f32 t_near = 0.0f;
+        f32 t_far = FB_INFINITY;
+        for (u32 k = 0; k < 3; k++) {
+            f32 inv = 1.0f / r.direction.vec[k];
+            f32 t0 = (box.min.vec[k] - r.origin.vec[k]) * inv;
+            f32 t1 = (box.max.vec[k] - r.origin.vec[k]) * inv;
+            t_near = fmax(t_near, fmin(t0, t1));
+            t_far = fmin(t_far, fmax(t0, t1));
+        }
+        return t_near <= t_far ? t_near : FB_INFINITY;
+    }
+
+    // found results of query number stamp are in results. Every box must be reported exactly when visible says so.
+    template <typename F>
+    b8 check_set(const char* name, u32 query, const u32* results, u32 found, u32* marks, const aabb* boxes, u32 count, F&& visible) {
+        u32 stamp = query + 1;
+        for (u32 i = 0; i < found; i++) {
+            if (marks[results[i]] == stamp) {
+                FBERROR("%s: Query %u reported box %u twice.", name, query, results[i]);
+                return false;
+            }
+            marks[results[i]] = stamp;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            b8 expected = visible(boxes[i]);
+            if (expected != (marks[i] == stamp)) {
+                FBERROR("%s: Query %u %s box %u.", name, query, expected ? "missed" : "wrongly reported", i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    b8 check(const bvh& tree, const aabb* boxes, u32 count, const queries& q, u32* results, u32* marks, const char* when) {
+        for (u32 i = 0; i < count; i++) {
+            marks[i] = 0;
+        }
+
+        for (u32 i = 0; i < checked_queries; i++) {
+            const frustum& f = q.frusta[i];
+            u32 found = tree.cull(f, results, count);
+            if (!check_set("cull", i, results, found, marks, boxes, count, [&](const aabb& box) { return is_visible(f, box); })) {
+                FBERROR("cull: Wrong results %s.", when);
+                return false;
+            }
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            marks[i] = 0;
+        }
+
+        for (u32 i = 0; i < checked_queries; i++) {
+            const aabb& query = q.boxes[i];
+            u32 found = tree.overlap(query, results, count);
+            if (!check_set("overlap", i, results, found, marks, boxes, count, [&](const aabb& box) { return overlaps(box, query); })) {
+                FBERROR("overlap: Wrong results %s.", when);
+                return false;
+            }
+        }
+
+        for (u32 i = 0; i < checked_queries; i++) {
+            const ray& r = q.rays[i];
+            ray_hit expected = {FB_INFINITY, invalid_u32};
+            for (u32 p = 0; p < count; p++) {
+                f32 t = ray_box(r, boxes[p]);
+                if (t < expected.t) {
+                    expected = {t, p};
+                }
+            }
+
+            ray_hit hit = tree.intersect(r);
+            f32 difference = hit.t > expected.t ? hit.t - expected.t : expected.t - hit.t;
+            b8 agrees = hit.index == expected.index ||
+                        (hit.index != invalid_u32 && expected.index != invalid_u32 && difference <= t_tolerance * fmax(expected.t, 1.0f));
+            if (!agrees) {
+                FBERROR("intersect: Ray %u hit box %u at t = %.9g %s, the nearest is box %u at t = %.9g.", i, hit.index, hit.t, when, expected.index, expected.t);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void report_queries(const char* name, u32 query_count, f64 seconds, u64 results, const char* per_query) {
+        FBINFO("    %-10s %10.0f queries/s  %8.2f %s", name, (f64)query_count / seconds, (f64)results / (f64)query_count, per_query);
+    }
+
+    void time_queries(const bvh& tree, const queries& q, u32* results, u32 max_results, const char* when) {
+        u64 culled = 0;
+        f64 seconds = best_seconds([&] {
+            culled = 0;
+            for (u32 i = 0; i < frustum_queries; i++) {
+                culled += tree.cull(q.frusta[i], results, max_results);
+            }
+        });
+        FBINFO("  queries %s:", when);
+        report_queries("cull", frustum_queries, seconds, culled, "boxes per query");
+
+        u64 overlapping = 0;
+        seconds = best_seconds([&] {
+            overlapping = 0;
+            for (u32 i = 0; i < box_queries; i++) {
+                overlapping += tree.overlap(q.boxes[i], results, max_results);
+            }
+        });
+        report_queries("overlap", box_queries, seconds, overlapping, "boxes per query");
+
+        u64 hits = 0;
+        seconds = best_seconds([&] {
+            hits = 0;
+            for (u32 i = 0; i < ray_queries; i++) {
+                hits += tree.intersect(q.rays[i]).index != invalid_u32;
+            }
+        });
+        report_queries("intersect", ray_queries, seconds, hits, "hits per ray");
+    }
+}  // namespace
+
+b8 bvh_benchmark(u64 count) {
+    if (count == 0 || count > 0x7fffffff) {
+        FBERROR("bvh: %llu boxes is out of range.", count);
+        return false;
+    }
+
+    u32 box_count = (u32)count;
+    FBINFO("bvh over %u boxes.", box_count);
+
+    aabb* boxes = (aabb*)memory::fballocate(box_count * sizeof(aabb), memory::MEMORY_TAG_ARRAY);
+    u32* results = (u32*)memory::fballocate(box_count * sizeof(u32), memory::MEMORY_TAG_ARRAY);
+    u32* marks = (u32*)memory::fballocate(box_count * sizeof(u32), memory::MEMORY_TAG_ARRAY);
+
+    queries q = {};
+    q.frusta = (frustum*)memory::fballocate(frustum_queries * sizeof(frustum), memory::MEMORY_TAG_ARRAY);
+    q.boxes = (aabb*)memory::fballocate(box_queries * sizeof(aabb), memory::MEMORY_TAG_ARRAY);
+    q.rays = (ray*)memory::fballocate(ray_queries * sizeof(ray), memory::MEMORY_TAG_ARRAY);
+
+    // Fixed seed, so a failure reproduces with the same count.
+    rng random(0x62766821);
+    fill_boxes(random, boxes, box_count);
+    fill_queries(random, q);
+
+    bvh tree;
+    b8 success = true;
+
+    bvh_build_config serial_config;
+    serial_config.thread_count = 1;
+    f64 serial = best_seconds([&] { success &= tree.build(boxes, box_count, serial_config); });
+
+    f64 parallel = best_seconds([&] { success &= tree.build(boxes, box_count); });
+
+    FBINFO("  build      %8.1f ms  %6.2f Mboxes/s", serial * 1000.0, (f64)box_count / serial * 1e-6);
+    FBINFO("  parallel   %8.1f ms  %6.2f Mboxes/s  %5.2fx", parallel * 1000.0, (f64)box_count / parallel * 1e-6, serial / parallel);
+    FBINFO("  %u nodes, %.1f MiB", tree.get_node_count(), (f64)tree.get_node_count() * sizeof(bvh_node) / (1024.0 * 1024.0));
+
+    if (!success) {
+        FBERROR("bvh: The build failed.");
+    }
+
+    success = success && check(tree, boxes, box_count, q, results, marks, "after the build");
+    if (success) {
+        time_queries(tree, q, results, box_count, "after the build");
+    }
+
+    // Every box moves by up to max_move along each axis.
+    for (u32 i = 0; i < box_count; i++) {
+        vec3f offset = random_point(random, max_move);
+        boxes[i] = {boxes[i].min + offset, boxes[i].max + offset};
+    }
+
+    f64 refit = best_seconds([&] { tree.refit(boxes); });
+    FBINFO("  refit      %8.1f ms  %6.2f Mboxes/s", refit * 1000.0, (f64)box_count / refit * 1e-6);
+
+    success = success && check(tree, boxes, box_count, q, results, marks, "after the refit");
+    if (success) {
+        time_queries(tree, q, results, box_count, "after the refit");
+    }
+
+    tree.destroy();
+
+    memory::fbfree(boxes, box_count * sizeof(aabb), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(results, box_count * sizeof(u32), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(marks, box_count * sizeof(u32), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(q.frusta, frustum_queries * sizeof(frustum), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(q.boxes, box_queries * sizeof(aabb), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(q.rays, ray_queries * sizeof(ray), memory::MEMORY_TAG_ARRAY);
+
+    return success;
+}
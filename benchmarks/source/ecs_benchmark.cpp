@@ -0,0 +1,118 @@
+#include "benchmarks.hpp"
+
+#include <ecs/world.hpp>
+
+using namespace fabric;
+
+// NOTE: Builds a world of count entities with a position and a velocity, a quarter of them with a health as well,
+//       and times creating them, integrating positions serially and in parallel, moving half of them to another
+//       archetype and destroying them. Positions hold small integers, so the results are checked exactly.
+
+namespace {
+    static constexpr u32 integrate_passes = 3;
+
+    struct position {
+        f32 x, y, z;
+    };
+
+    struct velocity {
+        f32 x, y, z;
+    };
+
+    struct health {
+        i32 points;
+    };
+
+    struct tagged {};
+
+    void integrate(position& p, const velocity& v) {
+        p.x += v.x;
+        p.y += v.y;
+        p.z += v.z;
+    }
+
+    f64 elapsed_ms(f64 start) {
+        return (benchmark_time() - start) * 1000.0;
+    }
+}  // namespace
+
+b8 ecs_benchmark(u64 count) {
+    FBINFO("ecs on %llu entities.", count);
+
+    ecs::world world;
+    if (!world.create()) {
+        return false;
+    }
+
+    ecs::entity* entities = (ecs::entity*)memory::fballocate(count * sizeof(ecs::entity), memory::MEMORY_TAG_ARRAY);
+    b8 success = true;
+
+    f64 start = benchmark_time();
+    for (u64 i = 0; i < count; i++) {
+        entities[i] = world.create_entity();
+        world.add<position>(entities[i], {(f32)i, 0.0f, 0.0f});
+        world.add<velocity>(entities[i], {1.0f, 2.0f, 3.0f});
+        if (i % 4 == 0) {
+            world.add<health>(entities[i], {100});
+        }
+    }
+    FBINFO("  create           %8.2f ms", elapsed_ms(start));
+
+    // Best of a few passes, the first one also pays for cold caches.
+    f64 serial_ms = 0.0;
+    f64 parallel_ms = 0.0;
+    for (u32 pass = 0; pass < integrate_passes; pass++) {
+        start = benchmark_time();
+        world.each<position, const velocity>(integrate);
+        f64 ms = elapsed_ms(start);
+        serial_ms = (pass == 0 || ms < serial_ms) ? ms : serial_ms;
+
+        start = benchmark_time();
+        world.parallel_each<position, const velocity>(integrate);
+        ms = elapsed_ms(start);
+        parallel_ms = (pass == 0 || ms < parallel_ms) ? ms : parallel_ms;
+    }
+    FBINFO("  each             %8.2f ms", serial_ms);
+    FBINFO("  parallel_each    %8.2f ms  %5.2fx", parallel_ms, serial_ms / parallel_ms);
+
+    const f32 steps = (f32)(integrate_passes * 2);
+    for (u64 i = 0; i < count; i++) {
+        const position* p = world.get<position>(entities[i]);
+        if (!p || p->x != (f32)i + steps || p->y != 2.0f * steps || p->z != 3.0f * steps) {
+            FBERROR("ecs: Entity %llu ended up in the wrong place.", i);
+            success = false;
+            break;
+        }
+    }
+
+    start = benchmark_time();
+    for (u64 i = 0; i < count; i += 2) {
+        world.add<tagged>(entities[i]);
+    }
+    FBINFO("  add to half      %8.2f ms", elapsed_ms(start));
+
+    u64 tagged_count = 0;
+    world.each_chunk<tagged, const position>([&](u32 chunk_count, const ecs::entity*, tagged*, const position*) {
+        tagged_count += chunk_count;
+    });
+    if (tagged_count != (count + 1) / 2) {
+        FBERROR("ecs: %llu entities were tagged, expected %llu.", tagged_count, (count + 1) / 2);
+        success = false;
+    }
+
+    start = benchmark_time();
+    for (u64 i = 0; i < count; i++) {
+        world.destroy_entity(entities[i]);
+    }
+    FBINFO("  destroy          %8.2f ms", elapsed_ms(start));
+
+    if (world.get_entity_count() != 0) {
+        FBERROR("ecs: %u entities are left after destroying all of them.", world.get_entity_count());
+        success = false;
+    }
+
+    memory::fbfree(entities, count * sizeof(ecs::entity), memory::MEMORY_TAG_ARRAY);
+    world.destroy();
+
+    return success;
+}
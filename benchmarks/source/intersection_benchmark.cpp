@@ -0,0 +1,413 @@
+#include "benchmarks.hpp"
+
+#include <ftl/intersection.hpp>
+#include <ftl/random.hpp>
+
+#include <float.h>
+#include <math.h>
+
+using namespace fabric;
+using namespace ftl;
+
+// NOTE: Times count rays against batches of boxes, spheres and triangles, and as a packet against one box, and
+//       compares the hits with a reference computed in f64. The scene is checked again scaled by 1e-4 and 1e4,
+//       the rejection of parallel rays and degenerate triangles has to hold at any scale. Rays grazing an edge
+//       or a tangent are too close to call in f32 and are only counted.
+
+namespace {
+    static constexpr u32 primitive_count = 1024;
+    static constexpr u64 max_checked_rays = 8192;
+
+    // Candidates this close to flipping between a hit and a miss, relative to the scene, leave their ray out.
+    static constexpr f64 marginal = 1e-4;
+    // Rays closer to a triangle's plane than this sine of the angle, or closer to a sphere's tangent than this
+    // fraction of the discriminant, lose too many bits of t in f32 and leave their ray out as well.
+    static constexpr f64 grazing = 1e-2;
+    // Largest accepted difference in t, relative to t past 1.
+    static constexpr f64 t_tolerance = 1e-4;
+
+    static constexpr f32 scales[] = {1.0f, 1e-4f, 1e4f};
+
+    struct scene {
+        f32* floats;
+        u64 float_count;
+        u64 ray_count;
+
+        aabb_soa boxes;
+        sphere_soa spheres;
+        triangle_soa triangles;
+        ray_soa packet;
+        ray* rays;
+        aabb packet_box;
+    };
+
+    struct reference_hit {
+        f64 t;
+        u32 index;
+        b8 marginal;
+    };
+
+    struct check_stats {
+        u64 checked;
+        u64 skipped;
+        u64 hits;
+        u64 failed_ray;
+        b8 failed;
+    };
+
+    FBINLINE f64 absolute(f64 v) {
+        return v < 0 ? -v : v;
+    }
+
+    f32* carve(f32*& next, u64 count) {
+        f32* result = next;
+        next += count;
+        return result;
+    }
+
+    void create_scene(scene& s, u64 ray_count) {
+        s.ray_count = ray_count;
+        s.float_count = primitive_count * (6 + 4 + 9) + ray_count * 6;
+        s.floats = (f32*)memory::fballocate(s.float_count * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+        s.rays = (ray*)memory::fballocate(ray_count * sizeof(ray), memory::MEMORY_TAG_ARRAY);
+
+        f32* next = s.floats;
+        s.boxes = {carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count),
+                   carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count)};
+        s.spheres = {carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count)};
+        s.triangles = {carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count),
+                       carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count),
+                       carve(next, primitive_count), carve(next, primitive_count), carve(next, primitive_count)};
+        s.packet = {carve(next, ray_count), carve(next, ray_count), carve(next, ray_count),
+                    carve(next, ray_count), carve(next, ray_count), carve(next, ray_count)};
+    }
+
+    void destroy_scene(scene& s) {
+        memory::fbfree(s.floats, s.float_count * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+        memory::fbfree(s.rays, s.ray_count * sizeof(ray), memory::MEMORY_TAG_ARRAY);
+    }
+
+    // Primitives spread over a 100 unit cube, and rays from around it aimed near one of them so most rays hit
+    // something. The same seed gives the same scene at every scale.
+    void fill_scene(scene& s, f32 scale) {
+        rng random(0x72617973);
+
+        for (u32 i = 0; i < primitive_count; i++) {
+            vec3f center(random.range(-50.0f, 50.0f), random.range(-50.0f, 50.0f), random.range(-50.0f, 50.0f));
+
+            s.boxes.center_x[i] = center.x * scale;
+            s.boxes.center_y[i] = center.y * scale;
+            s.boxes.center_z[i] = center.z * scale;
+            s.boxes.extent_x[i] = random.range(0.1f, 3.0f) * scale;
+            s.boxes.extent_y[i] = random.range(0.1f, 3.0f) * scale;
+            s.boxes.extent_z[i] = random.range(0.1f, 3.0f) * scale;
+
+            s.spheres.x[i] = center.x * scale;
+            s.spheres.y[i] = center.y * scale;
+            s.spheres.z[i] = center.z * scale;
+            s.spheres.radius[i] = random.range(0.1f, 3.0f) * scale;
+
+            s.triangles.v0_x[i] = center.x * scale;
+            s.triangles.v0_y[i] = center.y * scale;
+            s.triangles.v0_z[i] = center.z * scale;
+            s.triangles.edge1_x[i] = random.range(-4.0f, 4.0f) * scale;
+            s.triangles.edge1_y[i] = random.range(-4.0f, 4.0f) * scale;
+            s.triangles.edge1_z[i] = random.range(-4.0f, 4.0f) * scale;
+            s.triangles.edge2_x[i] = random.range(-4.0f, 4.0f) * scale;
+            s.triangles.edge2_y[i] = random.range(-4.0f, 4.0f) * scale;
+            s.triangles.edge2_z[i] = random.range(-4.0f, 4.0f) * scale;
+        }
+
+        for (u64 n = 0; n < s.ray_count; n++) {
+            vec3f origin(random.range(-60.0f, 60.0f), random.range(-60.0f, 60.0f), random.range(-60.0f, 60.0f));
+            u32 target = random.next_bounded(primitive_count);
+            vec3f direction(s.boxes.center_x[target] / scale + random.range(-2.0f, 2.0f) - origin.x,
+                            s.boxes.center_y[target] / scale + random.range(-2.0f, 2.0f) - origin.y,
+                            s.boxes.center_z[target] / scale + random.range(-2.0f, 2.0f) - origin.z);
+
+            s.rays[n] = {origin * scale, direction * scale};
+            s.packet.origin_x[n] = s.rays[n].origin.x;
+            s.packet.origin_y[n] = s.rays[n].origin.y;
+            s.packet.origin_z[n] = s.rays[n].origin.z;
+            s.packet.direction_x[n] = s.rays[n].direction.x;
+            s.packet.direction_y[n] = s.rays[n].direction.y;
+            s.packet.direction_z[n] = s.rays[n].direction.z;
+        }
+
+        s.packet_box = {vec3f(-20.0f, -10.0f, -30.0f) * scale, vec3f(10.0f, 25.0f, 5.0f) * scale};
+    }
+
+    void keep(reference_hit& best, f64 t, u32 index) {
+        if (t < best.t) {
+            best.t = t;
+            best.index = index;
+        }
+    }
+
+    // Slab test, the ray may start inside.
+    void reference_box(const ray& r, const f64* center, const f64* extent, u32 index, reference_hit& best) {
+        const f64 origin[3] = {r.origin.x, r.origin.y, r.origin.z};
+        const f64 direction[3] = {r.direction.x, r.direction.y, r.direction.z};
+
+        f64 t_near = 0.0;
+        f64 t_far = DBL_MAX;
+        for (u32 k = 0; k < 3; k++) {
+            if (direction[k] == 0.0) {
+                f64 outside = absolute(origin[k] - center[k]) - extent[k];
+                best.marginal |= absolute(outside) <= marginal * extent[k];
+                if (outside > 0.0) {
+                    return;
+                }
+                continue;
+            }
+
+            f64 t0 = (center[k] - extent[k] - origin[k]) / direction[k];
+            f64 t1 = (center[k] + extent[k] - origin[k]) / direction[k];
+            t_near = fmax(t_near, fmin(t0, t1));
+            t_far = fmin(t_far, fmax(t0, t1));
+        }
+
+        best.marginal |= absolute(t_far - t_near) <= marginal * fmax(absolute(t_far), 1.0);
+        if (t_near <= t_far) {
+            keep(best, t_near, index);
+        }
+    }
+
+    reference_hit reference_boxes(const ray& r, const aabb_soa& boxes) {
+        reference_hit best = {DBL_MAX, invalid_u32, false};
+        for (u32 i = 0; i < primitive_count; i++) {
+            const f64 center[3] = {boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]};
+            const f64 extent[3] = {boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]};
+            reference_box(r, center, extent, i, best);
+        }
+        return best;
+    }
+
+    reference_hit reference_spheres(const ray& r, const sphere_soa& spheres) {
+        reference_hit best = {DBL_MAX, invalid_u32, false};
+        f64 dx = r.direction.x, dy = r.direction.y, dz = r.direction.z;
+        f64 a = dx * dx + dy * dy + dz * dz;
+
+        for (u32 i = 0; i < primitive_count; i++) {
+            f64 ox = (f64)r.origin.x - spheres.x[i];
+            f64 oy = (f64)r.origin.y - spheres.y[i];
+            f64 oz = (f64)r.origin.z - spheres.z[i];
+            f64 radius_sq = (f64)spheres.radius[i] * spheres.radius[i];
+
+            f64 b = ox * dx + oy * dy + oz * dz;
+            f64 c = ox * ox + oy * oy + oz * oz - radius_sq;
+            f64 discriminant = b * b - a * c;
+
+            // Tangent rays, and origins on the surface, where the entry and exit points swap.
+            best.marginal |= absolute(discriminant) <= grazing * a * radius_sq || absolute(c) <= marginal * radius_sq;
+            if (discriminant < 0.0) {
+                continue;
+            }
+
+            f64 root = sqrt(discriminant);
+            f64 t = (-b - root) / a;
+            t = t < 0.0 ? (root - b) / a : t;
+            if (t >= 0.0) {
+                keep(best, t, i);
+            }
+        }
+        return best;
+    }
+
+    reference_hit reference_triangles(const ray& r, const triangle_soa& triangles) {
+        reference_hit best = {DBL_MAX, invalid_u32, false};
+        f64 d[3] = {r.direction.x, r.direction.y, r.direction.z};
+        f64 d_length = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+        for (u32 i = 0; i < primitive_count; i++) {
+            f64 e1[3] = {triangles.edge1_x[i], triangles.edge1_y[i], triangles.edge1_z[i]};
+            f64 e2[3] = {triangles.edge2_x[i], triangles.edge2_y[i], triangles.edge2_z[i]};
+            f64 s[3] = {(f64)r.origin.x - triangles.v0_x[i], (f64)r.origin.y - triangles.v0_y[i], (f64)r.origin.z - triangles.v0_z[i]};
+
+            f64 p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+            f64 det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+
+            // The kernel rejects |det| under FLT_EPSILON of |d||e1||e2|, which grazing covers.
+            f64 scale = d_length * sqrt(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * sqrt(e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+            f64 relative_det = absolute(det) / scale;
+            if (relative_det == 0.0) {
+                continue;
+            }
+
+            f64 q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+            f64 u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+            f64 v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+            f64 t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+            if (t <= 0.0) {
+                continue;
+            }
+
+            f64 w = 1.0 - u - v;
+            b8 edge = absolute(u) <= marginal || absolute(v) <= marginal || absolute(w) <= marginal;
+            b8 inside = u >= 0.0 && v >= 0.0 && w >= 0.0;
+            b8 parallel = relative_det < grazing;
+            best.marginal |= edge || (inside && parallel);
+            if (inside && !parallel) {
+                keep(best, t, i);
+            }
+        }
+        return best;
+    }
+
+    // Hits on different primitives agree when their distances do, for rays that pass through two at once.
+    b8 agrees(const ray_hit& hit, const reference_hit& reference) {
+        if (hit.index == invalid_u32 || reference.index == invalid_u32) {
+            return hit.index == reference.index;
+        }
+        return absolute((f64)hit.t - reference.t) <= t_tolerance * fmax(reference.t, 1.0);
+    }
+
+    void record(check_stats& stats, const ray_hit& hit, const reference_hit& reference, u64 n) {
+        if (reference.marginal) {
+            stats.skipped++;
+            return;
+        }
+
+        stats.checked++;
+        stats.hits += reference.index != invalid_u32;
+        if (!stats.failed && !agrees(hit, reference)) {
+            stats.failed = true;
+            stats.failed_ray = n;
+        }
+    }
+
+    // Best of a few runs, the first one also pays for cold caches.
+    template <typename F>
+    f64 rays_per_second(u64 count, F&& run) {
+        f64 best = 0.0;
+        for (u32 i = 0; i < 3; i++) {
+            f64 start = benchmark_time();
+            run();
+            f64 elapsed = benchmark_time() - start;
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+        return (f64)count / best;
+    }
+
+    b8 report_check(const char* name, f32 scale, const check_stats& stats, const scene& s, const ray_hit* hits) {
+        if (stats.failed) {
+            const ray& r = s.rays[stats.failed_ray];
+            FBERROR("%s: Ray %llu at scale %g disagrees with the reference, it found %u at t = %.9g. The ray:", name, stats.failed_ray, scale,
+                    hits[stats.failed_ray].index, hits[stats.failed_ray].t);
+            FBERROR("  origin %.9g %.9g %.9g direction %.9g %.9g %.9g", r.origin.x, r.origin.y, r.origin.z, r.direction.x, r.direction.y, r.direction.z);
+            return false;
+        }
+
+        if (stats.hits == 0) {
+            FBERROR("%s: None of the %llu rays checked at scale %g hit anything.", name, stats.checked, scale);
+            return false;
+        }
+
+        if (scale == 1.0f) {
+            FBINFO("  %-10s %5.1f%% of the rays hit, %llu grazing rays left out", "", 100.0 * (f64)stats.hits / (f64)stats.checked, stats.skipped);
+        }
+        return true;
+    }
+
+    template <typename Q, typename R>
+    b8 check_batch(const char* name, f32 scale, const scene& s, u64 checked, ray_hit* hits, Q&& query, R&& reference) {
+        check_stats stats = {};
+        for (u64 n = 0; n < checked; n++) {
+            if (scale != 1.0f) {
+                hits[n] = query(s.rays[n]);
+            }
+            record(stats, hits[n], reference(s.rays[n]), n);
+        }
+        return report_check(name, scale, stats, s, hits);
+    }
+
+    b8 check_packet(f32 scale, const scene& s, u64 checked, const f32* t, ray_hit* hits) {
+        const aabb& box = s.packet_box;
+        const f64 center[3] = {((f64)box.min.x + box.max.x) * 0.5, ((f64)box.min.y + box.max.y) * 0.5, ((f64)box.min.z + box.max.z) * 0.5};
+        const f64 extent[3] = {((f64)box.max.x - box.min.x) * 0.5, ((f64)box.max.y - box.min.y) * 0.5, ((f64)box.max.z - box.min.z) * 0.5};
+
+        check_stats stats = {};
+        for (u64 n = 0; n < checked; n++) {
+            reference_hit reference = {DBL_MAX, invalid_u32, false};
+            reference_box(s.rays[n], center, extent, 0, reference);
+
+            hits[n] = {t[n], t[n] == FB_INFINITY ? invalid_u32 : 0};
+            record(stats, hits[n], reference, n);
+        }
+        return report_check("packet", scale, stats, s, hits);
+    }
+}  // namespace
+
+b8 intersection_benchmark(u64 count) {
+#if FBSIMD_AVX
+    FBINFO("Intersections of %llu rays with %u primitives each, AVX paths.", count, primitive_count);
+#elif FBSIMD_SSE2
+    FBINFO("Intersections of %llu rays with %u primitives each, SSE paths.", count, primitive_count);
+#else
+    FBINFO("Intersections of %llu rays with %u primitives each, scalar paths (FB_SIMD_DISABLED).", count, primitive_count);
+#endif
+
+    scene s = {};
+    create_scene(s, count);
+
+    ray_hit* hits = (ray_hit*)memory::fballocate(count * sizeof(ray_hit), memory::MEMORY_TAG_ARRAY);
+    f32* packet_t = (f32*)memory::fballocate(count * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+    u64 checked = count < max_checked_rays ? count : max_checked_rays;
+    b8 success = true;
+
+    auto boxes = [&](const ray& r) { return intersect_aabbs(r, s.boxes, primitive_count); };
+    auto spheres = [&](const ray& r) { return intersect_spheres(r, s.spheres, primitive_count); };
+    auto triangles = [&](const ray& r) { return intersect_triangles(r, s.triangles, primitive_count); };
+    auto reference_box_batch = [&](const ray& r) { return reference_boxes(r, s.boxes); };
+    auto reference_sphere_batch = [&](const ray& r) { return reference_spheres(r, s.spheres); };
+    auto reference_triangle_batch = [&](const ray& r) { return reference_triangles(r, s.triangles); };
+
+    for (f32 scale : scales) {
+        fill_scene(s, scale);
+
+        // Timings only depend on the data at the first scale, the others are only checked.
+        if (scale == 1.0f) {
+            f64 rate = rays_per_second(count, [&] {
+                for (u64 n = 0; n < count; n++) {
+                    hits[n] = boxes(s.rays[n]);
+                }
+            });
+            FBINFO("  %-10s %8.3f Mrays/s  %8.1f Mtests/s", "aabbs", rate * 1e-6, rate * primitive_count * 1e-6);
+        }
+        success &= check_batch("aabbs", scale, s, checked, hits, boxes, reference_box_batch);
+
+        if (scale == 1.0f) {
+            f64 rate = rays_per_second(count, [&] {
+                for (u64 n = 0; n < count; n++) {
+                    hits[n] = spheres(s.rays[n]);
+                }
+            });
+            FBINFO("  %-10s %8.3f Mrays/s  %8.1f Mtests/s", "spheres", rate * 1e-6, rate * primitive_count * 1e-6);
+        }
+        success &= check_batch("spheres", scale, s, checked, hits, spheres, reference_sphere_batch);
+
+        if (scale == 1.0f) {
+            f64 rate = rays_per_second(count, [&] {
+                for (u64 n = 0; n < count; n++) {
+                    hits[n] = triangles(s.rays[n]);
+                }
+            });
+            FBINFO("  %-10s %8.3f Mrays/s  %8.1f Mtests/s", "triangles", rate * 1e-6, rate * primitive_count * 1e-6);
+        }
+        success &= check_batch("triangles", scale, s, checked, hits, triangles, reference_triangle_batch);
+
+        if (scale == 1.0f) {
+            f64 rate = rays_per_second(count, [&] { intersect_rays(s.packet, (u32)count, s.packet_box, packet_t); });
+            FBINFO("  %-10s %8.3f Mrays/s", "packet", rate * 1e-6);
+        } else {
+            intersect_rays(s.packet, (u32)count, s.packet_box, packet_t);
+        }
+        success &= check_packet(scale, s, checked, packet_t, hits);
+    }
+
+    memory::fbfree(hits, count * sizeof(ray_hit), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(packet_t, count * sizeof(f32), memory::MEMORY_TAG_ARRAY);
+    destroy_scene(s);
+
+    return success;
+}
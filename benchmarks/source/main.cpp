@@ -0,0 +1,54 @@
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    struct benchmark {
+        const char* name;
+        b8 (*run)(u64 count);
+        u64 default_count;
+    };
+
+    static const benchmark benchmarks[] = {
+        {"matrix", matrix_benchmark, 1000000},
+        {"ecs", ecs_benchmark, 1000000},
+        {"intersection", intersection_benchmark, 100000},
+        {"batch", batch_benchmark, 1000000},
+        {"bvh", bvh_benchmark, 1000000},
+        {"packing", packing_benchmark, 1000000},
+    };
+}  // namespace
+
+f64 benchmark_time() {
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Usage: benchmarks [name [count]]. Without a name every benchmark runs. Returns 1 when any of them failed.
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : nullptr;
+    u64 count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+
+    b8 found = false;
+    b8 success = true;
+    for (const benchmark& b : benchmarks) {
+        if (name && strcmp(name, b.name) != 0) {
+            continue;
+        }
+
+        found = true;
+        FBINFO("Running the %s benchmark...", b.name);
+        if (!b.run(count ? count : b.default_count)) {
+            FBERROR("The %s benchmark failed.", b.name);
+            success = false;
+        }
+    }
+
+    if (!found) {
+        FBERROR("There is no benchmark called %s.", name);
+        return 1;
+    }
+
+    return success ? 0 : 1;
+}
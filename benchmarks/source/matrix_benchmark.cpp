@@ -0,0 +1,331 @@
+#include "benchmarks.hpp"
+
+#include <ftl/math.hpp>
+#include <ftl/random.hpp>
+
+#include <float.h>
+
+using namespace fabric;
+using namespace ftl;
+
+// NOTE: Times the SIMD mat4 operations on random matrices and compares every result with a reference computed in
+//       f64. Errors are measured against the rounding error bound of each operation, so the tolerances hold for
+//       any input: the product's error is bounded by |A||B| and the inverse's by the condition number of A. The
+//       scalar timings come from the same references computed in f32.
+
+namespace {
+    // Unit roundoff of f32.
+    static constexpr f64 roundoff = FLT_EPSILON * 0.5;
+
+    // Worst errors accepted, in units of the bounds above.
+    static constexpr f64 multiply_tolerance = 8.0;
+    static constexpr f64 inverse_tolerance = 64.0;
+
+    // Past this condition number an f32 inverse keeps less than 2 correct digits, such matrices are only counted.
+    static constexpr f64 max_condition = 1.0 / (roundoff * 64.0);
+
+    struct matrix_set {
+        mat4* a;
+        mat4* b;
+        mat4* result;
+        u64 count;
+    };
+
+    struct error_stats {
+        f64 worst;
+        u64 worst_index;
+        u64 skipped;
+    };
+
+    template <typename T>
+    FBINLINE T absolute(T v) {
+        return v < 0 ? -v : v;
+    }
+
+    template <typename T>
+    void multiply_reference(const f32* a, const f32* b, T* out) {
+        for (u32 i = 0; i < 4; i++) {
+            for (u32 j = 0; j < 4; j++) {
+                T sum = 0;
+                for (u32 k = 0; k < 4; k++) {
+                    sum += (T)a[i * 4 + k] * (T)b[k * 4 + j];
+                }
+                out[i * 4 + j] = sum;
+            }
+        }
+    }
+
+    // Gauss-Jordan elimination with partial pivoting. Returns false when the matrix is singular.
+    template <typename T>
+    b8 inverse_reference(const f32* m, T* out) {
+        T a[16];
+        for (u32 i = 0; i < 16; i++) {
+            a[i] = (T)m[i];
+            out[i] = (i % 5 == 0) ? (T)1 : (T)0;
+        }
+
+        for (u32 c = 0; c < 4; c++) {
+            u32 pivot = c;
+            for (u32 r = c + 1; r < 4; r++) {
+                if (absolute(a[r * 4 + c]) > absolute(a[pivot * 4 + c])) {
+                    pivot = r;
+                }
+            }
+
+            if (a[pivot * 4 + c] == 0) {
+                return false;
+            }
+
+            if (pivot != c) {
+                for (u32 j = 0; j < 4; j++) {
+                    T t = a[c * 4 + j];
+                    a[c * 4 + j] = a[pivot * 4 + j];
+                    a[pivot * 4 + j] = t;
+
+                    t = out[c * 4 + j];
+                    out[c * 4 + j] = out[pivot * 4 + j];
+                    out[pivot * 4 + j] = t;
+                }
+            }
+
+            T rcp = (T)1 / a[c * 4 + c];
+            for (u32 j = 0; j < 4; j++) {
+                a[c * 4 + j] *= rcp;
+                out[c * 4 + j] *= rcp;
+            }
+
+            for (u32 r = 0; r < 4; r++) {
+                T factor = a[r * 4 + c];
+                if (r == c || factor == 0) {
+                    continue;
+                }
+
+                for (u32 j = 0; j < 4; j++) {
+                    a[r * 4 + j] -= factor * a[c * 4 + j];
+                    out[r * 4 + j] -= factor * out[c * 4 + j];
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Largest absolute row sum.
+    template <typename T>
+    f64 norm(const T* m) {
+        f64 result = 0.0;
+        for (u32 i = 0; i < 4; i++) {
+            f64 sum = 0.0;
+            for (u32 j = 0; j < 4; j++) {
+                sum += absolute((f64)m[i * 4 + j]);
+            }
+            result = sum > result ? sum : result;
+        }
+        return result;
+    }
+
+    void record(error_stats& stats, f64 error, u64 index) {
+        // Written so NaN counts as the worst error.
+        if (!(error <= stats.worst)) {
+            stats.worst = error;
+            stats.worst_index = index;
+        }
+    }
+
+    // Each element's error over its bound (|A||B|)ij * 4u, the forward error bound of a 4 term dot product.
+    error_stats check_multiply(const matrix_set& set) {
+        error_stats stats = {};
+        for (u64 n = 0; n < set.count; n++) {
+            const f32* a = set.a[n].mat;
+            const f32* b = set.b[n].mat;
+
+            f64 reference[16];
+            multiply_reference(a, b, reference);
+
+            for (u32 i = 0; i < 4; i++) {
+                for (u32 j = 0; j < 4; j++) {
+                    f64 bound = 0.0;
+                    for (u32 k = 0; k < 4; k++) {
+                        bound += absolute((f64)a[i * 4 + k] * (f64)b[k * 4 + j]);
+                    }
+                    bound *= 4.0 * roundoff;
+
+                    f64 error = absolute((f64)set.result[n].mat[i * 4 + j] - reference[i * 4 + j]);
+                    record(stats, bound > 0.0 ? error / bound : error, n);
+                }
+            }
+        }
+        return stats;
+    }
+
+    error_stats check_transpose(const matrix_set& set) {
+        error_stats stats = {};
+        for (u64 n = 0; n < set.count; n++) {
+            for (u32 i = 0; i < 4; i++) {
+                for (u32 j = 0; j < 4; j++) {
+                    if (set.result[n].mat[i * 4 + j] != set.a[n].mat[j * 4 + i]) {
+                        record(stats, 1.0, n);
+                    }
+                }
+            }
+        }
+        return stats;
+    }
+
+    // Normwise relative error over its bound cond(A) * u.
+    error_stats check_inverse(const matrix_set& set) {
+        error_stats stats = {};
+        for (u64 n = 0; n < set.count; n++) {
+            f64 reference[16];
+            if (!inverse_reference(set.a[n].mat, reference)) {
+                stats.skipped++;
+                continue;
+            }
+
+            f64 reference_norm = norm(reference);
+            f64 condition = norm(set.a[n].mat) * reference_norm;
+            if (condition > max_condition) {
+                stats.skipped++;
+                continue;
+            }
+
+            f64 difference[16];
+            for (u32 i = 0; i < 16; i++) {
+                difference[i] = (f64)set.result[n].mat[i] - reference[i];
+            }
+
+            record(stats, norm(difference) / (reference_norm * condition * roundoff), n);
+        }
+        return stats;
+    }
+
+    // Best of a few runs, the first one also pays for cold caches and page faults.
+    template <typename F>
+    f64 time_per_item(u64 count, F&& run) {
+        f64 best = 0.0;
+        for (u32 i = 0; i < 3; i++) {
+            f64 start = benchmark_time();
+            run();
+            f64 elapsed = benchmark_time() - start;
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+        return best * 1e9 / (f64)count;
+    }
+
+    b8 report(const char* name, f64 simd_ns, f64 scalar_ns, const error_stats& stats, f64 tolerance, const matrix_set& set) {
+        FBINFO("  %-15s %7.2f ns  scalar %7.2f ns  %5.2fx  worst error %.3f", name, simd_ns, scalar_ns, scalar_ns / simd_ns, stats.worst);
+        if (stats.skipped) {
+            FBINFO("  %-15s %llu singular or ill-conditioned matrices left out", "", stats.skipped);
+        }
+
+        if (!(stats.worst <= tolerance)) {
+            const f32* m = set.a[stats.worst_index].mat;
+            FBERROR("%s: matrix %llu is off by %.3f, over the tolerance of %.1f. Its rows:", name, stats.worst_index, stats.worst, tolerance);
+            for (u32 i = 0; i < 4; i++) {
+                FBERROR("  %.9g %.9g %.9g %.9g", m[i * 4 + 0], m[i * 4 + 1], m[i * 4 + 2], m[i * 4 + 3]);
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    // Rows 0-2 keep their linear part with w = 0 and row 3 becomes a translation.
+    void make_affine(mat4* matrices, u64 count) {
+        for (u64 n = 0; n < count; n++) {
+            f32* m = matrices[n].mat;
+            m[3] = 0.0f;
+            m[7] = 0.0f;
+            m[11] = 0.0f;
+            m[15] = 1.0f;
+        }
+    }
+}  // namespace
+
+b8 matrix_benchmark(u64 count) {
+#if FBSIMD_AVX
+    FBINFO("mat4 on %llu random matrices, AVX paths.", count);
+#elif FBSIMD_SSE2
+    FBINFO("mat4 on %llu random matrices, SSE paths.", count);
+#else
+    FBINFO("mat4 on %llu random matrices, scalar paths (FB_SIMD_DISABLED).", count);
+#endif
+
+    matrix_set set = {};
+    set.count = count;
+    set.a = (mat4*)memory::fballocate(count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    set.b = (mat4*)memory::fballocate(count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    set.result = (mat4*)memory::fballocate(count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    f32* scalar = (f32*)memory::fballocate(count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+
+    // Fixed seed, so a failure reproduces with the same count.
+    rng random(0x6d617434);
+    random.fill(set.a[0].mat, count * 16, -1.0f, 1.0f);
+    random.fill(set.b[0].mat, count * 16, -1.0f, 1.0f);
+
+    b8 success = true;
+    f64 simd_ns;
+    f64 scalar_ns;
+
+    simd_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            set.result[n] = set.a[n] * set.b[n];
+        }
+    });
+    scalar_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            multiply_reference(set.a[n].mat, set.b[n].mat, scalar + n * 16);
+        }
+    });
+    success &= report("multiply", simd_ns, scalar_ns, check_multiply(set), multiply_tolerance, set);
+
+    simd_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            set.result[n] = set.a[n];
+            set.result[n].transpose();
+        }
+    });
+    scalar_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            for (u32 i = 0; i < 16; i++) {
+                scalar[n * 16 + i] = set.a[n].mat[(i % 4) * 4 + i / 4];
+            }
+        }
+    });
+    success &= report("transpose", simd_ns, scalar_ns, check_transpose(set), 0.0, set);
+
+    simd_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            set.result[n] = set.a[n];
+            set.result[n].inverse();
+        }
+    });
+    scalar_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            inverse_reference(set.a[n].mat, scalar + n * 16);
+        }
+    });
+    success &= report("inverse", simd_ns, scalar_ns, check_inverse(set), inverse_tolerance, set);
+
+    make_affine(set.a, count);
+
+    simd_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            set.result[n] = set.a[n];
+            set.result[n].inverse_affine();
+        }
+    });
+    scalar_ns = time_per_item(count, [&] {
+        for (u64 n = 0; n < count; n++) {
+            inverse_reference(set.a[n].mat, scalar + n * 16);
+        }
+    });
+    success &= report("inverse_affine", simd_ns, scalar_ns, check_inverse(set), inverse_tolerance, set);
+
+    memory::fbfree(set.a, count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(set.b, count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(set.result, count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(scalar, count * sizeof(mat4), memory::MEMORY_TAG_ARRAY);
+
+    return success;
+}
@@ -0,0 +1,246 @@
+#include "benchmarks.hpp"
+
+#include <ftl/packing.hpp>
+#include <ftl/random.hpp>
+
+#include <float.h>
+#include <math.h>
+
+using namespace fabric;
+using namespace ftl;
+
+// NOTE: Times the packing kernels on count random values and checks that the worst round trip error stays within
+//       the bounds documented in packing.hpp. Half floats are drawn from the normal, subnormal and overflowing
+//       ranges, and unit vectors and tangent frames start with the axes, where octahedral folding has its seams.
+
+namespace {
+    // Half floats: half an ulp of the 11 bit significand, and half the 2^-24 step of the subnormals.
+    static constexpr f64 f16_relative_bound = 1.0 / 2048.0;
+    static constexpr f64 f16_subnormal_bound = 1.0 / 33554432.0;
+    static constexpr f32 f16_min_normal = 1.0f / 16384.0f;
+    static constexpr f32 f16_max = 65504.0f;
+
+    static constexpr f64 max_angle_degrees = 0.005;
+
+    // The unpacked values are rounded to f32 as well, on top of the quantization error.
+    static constexpr f64 f32_slack = FLT_EPSILON;
+
+    struct error_stats {
+        f64 worst;
+        u64 worst_index;
+    };
+
+    template <typename T>
+    FBINLINE T absolute(T v) {
+        return v < 0 ? -v : v;
+    }
+
+    void record(error_stats& stats, f64 error, u64 index) {
+        // Written so NaN counts as the worst error.
+        if (!(error <= stats.worst)) {
+            stats.worst = error;
+            stats.worst_index = index;
+        }
+    }
+
+    // Best of a few runs, the first one also pays for cold caches and page faults.
+    template <typename F>
+    f64 time_per_item(u64 count, F&& run) {
+        f64 best = 0.0;
+        for (u32 i = 0; i < 3; i++) {
+            f64 start = benchmark_time();
+            run();
+            f64 elapsed = benchmark_time() - start;
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+        return best * 1e9 / (f64)count;
+    }
+
+    b8 report(const char* name, f64 pack_ns, f64 unpack_ns, const error_stats& stats, f64 bound, const char* unit) {
+        FBINFO("  %-12s pack %6.2f ns  unpack %6.2f ns  worst error %.3g%s (bound %.3g%s)", name, pack_ns, unpack_ns, stats.worst, unit, bound, unit);
+        if (!(stats.worst <= bound)) {
+            FBERROR("%s: Value %llu is off by %.3g%s, over the documented bound of %.3g%s.", name, stats.worst_index, stats.worst, unit, bound, unit);
+            return false;
+        }
+        return true;
+    }
+
+    // Angle between two vectors in degrees. atan2 keeps its precision for nearly parallel vectors, unlike acos.
+    f64 angle_degrees(const vec3f& a, const vec3f& b) {
+        f64 ax = a.x, ay = a.y, az = a.z;
+        f64 bx = b.x, by = b.y, bz = b.z;
+        f64 cx = ay * bz - az * by;
+        f64 cy = az * bx - ax * bz;
+        f64 cz = ax * by - ay * bx;
+        return atan2(sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz) * (180.0 / 3.14159265358979323846);
+    }
+
+    vec3f random_unit(rng& random) {
+        for (;;) {
+            vec3f v(random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f));
+            f32 length_sq = dot(v, v);
+            if (length_sq > 1e-4f && length_sq <= 1.0f) {
+                return v * (1.0f / fbsqrt(length_sq));
+            }
+        }
+    }
+
+    b8 check_f16(const f32* in, u64 count, u16* packed, f32* out) {
+        f64 pack_ns = time_per_item(count, [&] { pack_f16(in, packed, count); });
+        f64 unpack_ns = time_per_item(count, [&] { unpack_f16(packed, out, count); });
+
+        // Errors in units of the bound for the value's range, so one worst error covers both ranges.
+        error_stats stats = {};
+        for (u64 i = 0; i < count; i++) {
+            f64 magnitude = absolute((f64)in[i]);
+            if (magnitude >= 65520.0) {
+                // FB_INFINITY is only a large finite value, the kernels produce a real infinity.
+                b8 overflowed = isinf(out[i]) && (out[i] < 0.0f) == (in[i] < 0.0f);
+                record(stats, overflowed ? 0.0 : FB_INFINITY, i);
+                continue;
+            }
+
+            f64 bound = magnitude < f16_min_normal ? f16_subnormal_bound : f16_relative_bound * magnitude;
+            record(stats, absolute((f64)out[i] - in[i]) / bound, i);
+        }
+
+        return report("f16", pack_ns, unpack_ns, stats, 1.0, "");
+    }
+
+    template <typename T>
+    b8 check_norm(const char* name, const f32* in, u64 count, T* packed, f32* out, void (*pack)(const f32*, T*, u64),
+                  void (*unpack)(const T*, f32*, u64), f32 low, f64 bound) {
+        f64 pack_ns = time_per_item(count, [&] { pack(in, packed, count); });
+        f64 unpack_ns = time_per_item(count, [&] { unpack(packed, out, count); });
+
+        error_stats stats = {};
+        for (u64 i = 0; i < count; i++) {
+            f32 clamped = in[i] < low ? low : (in[i] > 1.0f ? 1.0f : in[i]);
+            record(stats, absolute((f64)out[i] - clamped), i);
+        }
+
+        return report(name, pack_ns, unpack_ns, stats, bound + f32_slack, "");
+    }
+
+    b8 check_octahedral(const vec3f* in, u64 count, i16* packed, vec3f* out) {
+        f64 pack_ns = time_per_item(count, [&] { pack_octahedral(in, packed, count); });
+        f64 unpack_ns = time_per_item(count, [&] { unpack_octahedral(packed, out, count); });
+
+        error_stats stats = {};
+        for (u64 i = 0; i < count; i++) {
+            record(stats, angle_degrees(in[i], out[i]), i);
+
+            f64 length = sqrt((f64)dot(out[i], out[i]));
+            if (!(absolute(length - 1.0) <= 4.0 * f32_slack)) {
+                FBERROR("octahedral: Vector %llu unpacked with length %.9g.", i, length);
+                return false;
+            }
+        }
+
+        return report("octahedral", pack_ns, unpack_ns, stats, max_angle_degrees, " deg");
+    }
+
+    b8 check_qtangent(const vec3f* normals, const vec4f* tangents, u64 count, i16* packed, vec3f* out_normals, vec4f* out_tangents) {
+        f64 pack_ns = time_per_item(count, [&] { pack_qtangent(normals, tangents, packed, count); });
+        f64 unpack_ns = time_per_item(count, [&] { unpack_qtangent(packed, out_normals, out_tangents, count); });
+
+        error_stats stats = {};
+        for (u64 i = 0; i < count; i++) {
+            vec3f tangent(tangents[i].x, tangents[i].y, tangents[i].z);
+            vec3f out_tangent(out_tangents[i].x, out_tangents[i].y, out_tangents[i].z);
+            record(stats, angle_degrees(normals[i], out_normals[i]), i);
+            record(stats, angle_degrees(tangent, out_tangent), i);
+
+            if (out_tangents[i].w != tangents[i].w) {
+                FBERROR("qtangent: Frame %llu unpacked with handedness %g instead of %g.", i, out_tangents[i].w, tangents[i].w);
+                return false;
+            }
+        }
+
+        return report("qtangent", pack_ns, unpack_ns, stats, max_angle_degrees, " deg");
+    }
+}  // namespace
+
+b8 packing_benchmark(u64 count) {
+    FBINFO("Packing round trips of %llu random values.", count);
+    if (count < 8) {
+        FBERROR("packing: Needs at least 8 values for the fixed cases.");
+        return false;
+    }
+
+    // Sized for the largest input and packed types, 4 f32 and 4 i16 per value.
+    f32* in = (f32*)memory::fballocate(count * sizeof(vec4f), memory::MEMORY_TAG_ARRAY);
+    f32* out = (f32*)memory::fballocate(count * sizeof(vec4f), memory::MEMORY_TAG_ARRAY);
+    vec3f* normals = (vec3f*)memory::fballocate(count * sizeof(vec3f), memory::MEMORY_TAG_ARRAY);
+    vec3f* out_normals = (vec3f*)memory::fballocate(count * sizeof(vec3f), memory::MEMORY_TAG_ARRAY);
+    void* packed = memory::fballocate(count * 4 * sizeof(i16), memory::MEMORY_TAG_ARRAY);
+
+    // Fixed seed, so a failure reproduces with the same count.
+    rng random(0x7061636b);
+    b8 success = true;
+
+    // A quarter each of normal values, subnormals, values up to the rounding limit of 65504 and overflows.
+    for (u64 i = 0; i < count; i++) {
+        f32 sign = (random.next_u32() & 1) ? -1.0f : 1.0f;
+        switch (i % 4) {
+            case 0:
+                in[i] = sign * ldexpf(random.range(1.0f, 2.0f), random.range(-14, 15));
+                break;
+            case 1:
+                in[i] = sign * random.range(0.0f, f16_min_normal);
+                break;
+            case 2:
+                in[i] = sign * random.range(f16_max * 0.5f, 65519.0f);
+                break;
+            default:
+                in[i] = sign * random.range(65536.0f, 1e6f);
+                break;
+        }
+    }
+    success &= check_f16(in, count, (u16*)packed, out);
+
+    // Past both ends of the ranges, to cover the clamping.
+    random.fill(in, count, -1.25f, 1.25f);
+    success &= check_norm("snorm8", in, count, (i8*)packed, out, pack_snorm8, unpack_snorm8, -1.0f, 1.0 / 254.0);
+    success &= check_norm("snorm16", in, count, (i16*)packed, out, pack_snorm16, unpack_snorm16, -1.0f, 1.0 / 65534.0);
+    success &= check_norm("unorm8", in, count, (u8*)packed, out, pack_unorm8, unpack_unorm8, 0.0f, 1.0 / 510.0);
+    success &= check_norm("unorm16", in, count, (u16*)packed, out, pack_unorm16, unpack_unorm16, 0.0f, 1.0 / 131070.0);
+
+    for (u64 i = 0; i < count; i++) {
+        normals[i] = random_unit(random);
+    }
+    for (u32 i = 0; i < 6; i++) {
+        vec3f axis(0.0f);
+        axis.vec[i / 2] = (i & 1) ? -1.0f : 1.0f;
+        normals[i] = axis;
+    }
+    success &= check_octahedral(normals, count, (i16*)packed, out_normals);
+
+    // Tangents orthogonal to the normals with both handednesses. The first frames are the axes, including the
+    // ones rotated by 180 degrees, where the quaternion's w is near zero and its sign carries the handedness.
+    vec4f* tangents = (vec4f*)in;
+    vec4f* out_tangents = (vec4f*)out;
+    for (u64 i = 0; i < count; i++) {
+        vec3f t = random_unit(random);
+        t = t - normals[i] * dot(t, normals[i]);
+        while (dot(t, t) < 1e-4f) {
+            t = random_unit(random);
+            t = t - normals[i] * dot(t, normals[i]);
+        }
+        t = t * (1.0f / fbsqrt(dot(t, t)));
+        tangents[i] = vec4f(t.x, t.y, t.z, (i & 1) ? -1.0f : 1.0f);
+    }
+    for (u32 i = 0; i < 8; i++) {
+        normals[i] = vec3f(0.0f, 0.0f, (i & 2) ? -1.0f : 1.0f);
+        tangents[i] = vec4f((i & 4) ? -1.0f : 1.0f, 0.0f, 0.0f, (i & 1) ? -1.0f : 1.0f);
+    }
+    success &= check_qtangent(normals, tangents, count, (i16*)packed, out_normals, out_tangents);
+
+    memory::fbfree(in, count * sizeof(vec4f), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(out, count * sizeof(vec4f), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(normals, count * sizeof(vec3f), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(out_normals, count * sizeof(vec3f), memory::MEMORY_TAG_ARRAY);
+    memory::fbfree(packed, count * 4 * sizeof(i16), memory::MEMORY_TAG_ARRAY);
+
+    return success;
+}
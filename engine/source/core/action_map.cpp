@@ -0,0 +1,389 @@
+#include "core/action_map.hpp"
+#include "core/input.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+#include "ftl/simd.hpp"
+#include "platform/filesystem.hpp"
+
+using namespace fabric;
+
+namespace {
+    static constexpr u32 max_inputs = input::button_code_base + input::BUTTON_MAX_COUNT;
+    static constexpr u32 term_words = 8;
+
+    // "FBAM"
+    static constexpr u32 map_magic = 0x4D414246U;
+    static constexpr u32 map_version = 1;
+
+    struct map_header {
+        u32 magic;
+        u32 version;
+        u32 binding_count;
+        u32 axis_count;
+    };
+
+    struct map_binding {
+        u16 action;
+        u8 slot;
+        u8 flags;
+        u16 code_count;
+        u16 codes[input::max_chord_size];
+        u16 reserved;
+    };
+
+    struct map_axis {
+        u16 axis;
+        u16 negative;
+        u16 positive;
+        u16 reserved;
+    };
+
+    STATIC_ASSERT(sizeof(map_binding) == 16, "Mapping file bindings are expected to be 16 bytes");
+
+    // The generic modifier standing in for a sided one, or 0.
+    u16 generic_modifier(u16 code) {
+        switch (code) {
+            case input::KEY_LSHIFT:
+            case input::KEY_RSHIFT:
+                return input::KEY_SHIFT;
+            case input::KEY_LCONTROL:
+            case input::KEY_RCONTROL:
+                return input::KEY_CONTROL;
+            case input::KEY_LALT:
+            case input::KEY_RALT:
+                return input::KEY_ALT;
+            default:
+                return 0;
+        }
+    }
+}  // namespace
+
+input::action_map::~action_map() {
+    destroy();
+}
+
+b8 input::action_map::create() {
+    destroy();
+
+    term_inputs = (u16*)memory::fballocate(sizeof(u16) * max_inputs, memory::MEMORY_TAG_APPLICATION);
+    term_masks = (u64*)memory::fballocate(sizeof(u64) * term_words * max_inputs, memory::MEMORY_TAG_APPLICATION);
+
+    memory::fbzero(bindings, sizeof(bindings));
+    for (u32 i = 0; i < max_action_axes; i++) {
+        axis_negative[i] = invalid_u32;
+        axis_positive[i] = invalid_u32;
+    }
+    memory::fbzero(active, sizeof(active));
+    memory::fbzero(previous, sizeof(previous));
+    dirty = true;
+
+    return true;
+}
+
+void input::action_map::destroy() {
+    if (term_inputs) {
+        memory::fbfree(term_inputs, sizeof(u16) * max_inputs, memory::MEMORY_TAG_APPLICATION);
+        memory::fbfree(term_masks, sizeof(u64) * term_words * max_inputs, memory::MEMORY_TAG_APPLICATION);
+    }
+
+    term_inputs = nullptr;
+    term_masks = nullptr;
+    term_count = 0;
+}
+
+b8 input::action_map::bind(u32 action, u32 slot, const u16* codes, u32 code_count, binding_flags flags) {
+    if (action >= max_actions || slot >= bindings_per_action) {
+        FBERROR("action_map::bind: Invalid action %u or slot %u.", action, slot);
+        return false;
+    }
+
+    if (code_count == 0 || code_count > max_chord_size) {
+        FBERROR("action_map::bind: Chords have between 1 and %u inputs, got %u.", max_chord_size, code_count);
+        return false;
+    }
+
+    for (u32 i = 0; i < code_count; i++) {
+        if (codes[i] >= max_inputs) {
+            FBERROR("action_map::bind: Invalid input code %u.", codes[i]);
+            return false;
+        }
+    }
+
+    binding& b = bindings[action][slot];
+    memory::fbcopy(b.codes, codes, sizeof(u16) * code_count);
+    b.code_count = (u8)code_count;
+    b.flags = flags;
+    dirty = true;
+
+    return true;
+}
+
+void input::action_map::unbind(u32 action, u32 slot) {
+    if (action >= max_actions || slot >= bindings_per_action) {
+        return;
+    }
+
+    bindings[action][slot].code_count = 0;
+    dirty = true;
+}
+
+b8 input::action_map::bind_axis(u32 axis, u32 negative_action, u32 positive_action) {
+    if (axis >= max_action_axes || negative_action >= max_actions || positive_action >= max_actions) {
+        FBERROR("action_map::bind_axis: Invalid axis %u or actions %u, %u.", axis, negative_action, positive_action);
+        return false;
+    }
+
+    axis_negative[axis] = negative_action;
+    axis_positive[axis] = positive_action;
+    return true;
+}
+
+f32 input::action_map::get_axis(u32 axis) const {
+    if (axis_negative[axis] == invalid_u32) {
+        return 0.0f;
+    }
+
+    return (f32)is_active(axis_positive[axis]) - (f32)is_active(axis_negative[axis]);
+}
+
+void input::action_map::compile() {
+    // Indexed by input, 8 words each, compacted to the inputs in use below.
+    u64* masks = (u64*)memory::fballocate(sizeof(u64) * term_words * max_inputs, memory::MEMORY_TAG_APPLICATION);
+
+    for (u32 i = 0; i < 4; i++) {
+        unused_lanes[i] = 0;
+    }
+
+    const u16 modifiers[] = {KEY_SHIFT, KEY_CONTROL, KEY_ALT};
+
+    for (u32 action = 0; action < max_actions; action++) {
+        for (u32 slot = 0; slot < bindings_per_action; slot++) {
+            // Slot 0 fills lanes 0-127 and slot 1 lanes 128-255, so an action is active when either half passes.
+            u32 lane = slot * max_actions + action;
+            u64 bit = 1ull << (lane & 63);
+            u32 word = lane >> 6;
+
+            const binding& b = bindings[action][slot];
+            if (b.code_count == 0) {
+                unused_lanes[word] |= bit;
+                continue;
+            }
+
+            b8 has_modifier[3] = {};
+            for (u32 i = 0; i < b.code_count; i++) {
+                u16 code = b.codes[i];
+                masks[code * term_words + word] |= bit;
+
+                u16 generic = code < button_code_base ? (generic_modifier(code) ? generic_modifier(code) : code) : 0;
+                for (u32 m = 0; m < 3; m++) {
+                    has_modifier[m] |= generic == modifiers[m];
+                }
+            }
+
+            if (b.flags & BINDING_EXACT_MODIFIERS) {
+                for (u32 m = 0; m < 3; m++) {
+                    if (!has_modifier[m]) {
+                        masks[modifiers[m] * term_words + 4 + word] |= bit;
+                    }
+                }
+            }
+        }
+    }
+
+    term_count = 0;
+    for (u32 input = 0; input < max_inputs; input++) {
+        const u64* source = masks + input * term_words;
+        u64 used = 0;
+        for (u32 i = 0; i < term_words; i++) {
+            used |= source[i];
+        }
+
+        if (used) {
+            term_inputs[term_count] = (u16)input;
+            memory::fbcopy(term_masks + term_count * term_words, source, sizeof(u64) * term_words);
+            term_count++;
+        }
+    }
+
+    memory::fbfree(masks, sizeof(u64) * term_words * max_inputs, memory::MEMORY_TAG_APPLICATION);
+    dirty = false;
+}
+
+void input::action_map::update() {
+    if (!term_inputs) {
+        return;
+    }
+
+    if (dirty) {
+        compile();
+    }
+
+    // Keys, with the generic modifiers filled in from the sided ones, then buttons.
+    u64 state[(max_inputs + 63) / 64];
+    const key_state& keys = get_key_state();
+    for (u32 i = 0; i < key_state::word_count; i++) {
+        state[i] = keys.data()[i];
+    }
+
+    u64 shift = (u64)(keys.test(KEY_LSHIFT) | keys.test(KEY_RSHIFT));
+    u64 control = (u64)(keys.test(KEY_LCONTROL) | keys.test(KEY_RCONTROL));
+    u64 alt = (u64)(keys.test(KEY_LALT) | keys.test(KEY_RALT));
+    state[0] |= (shift << KEY_SHIFT) | (control << KEY_CONTROL) | (alt << KEY_ALT);
+
+    u64 buttons = 0;
+    for (u32 i = 0; i < BUTTON_MAX_COUNT; i++) {
+        buttons |= (u64)is_button_down((input::buttons)i) << i;
+    }
+    state[button_code_base / 64] = buttons;
+
+    u64 failed[4];
+#if FBSIMD_AVX2
+    __m256i fail = _mm256_loadu_si256((const __m256i*)unused_lanes);
+    for (u32 t = 0; t < term_count; t++) {
+        u32 input = term_inputs[t];
+        __m256i down = _mm256_set1_epi64x(-(i64)((state[input >> 6] >> (input & 63)) & 1));
+        __m256i needs_down = _mm256_loadu_si256((const __m256i*)(term_masks + t * term_words));
+        __m256i needs_up = _mm256_loadu_si256((const __m256i*)(term_masks + t * term_words + 4));
+        fail = _mm256_or_si256(fail, _mm256_or_si256(_mm256_andnot_si256(down, needs_down), _mm256_and_si256(down, needs_up)));
+    }
+    _mm256_storeu_si256((__m256i*)failed, fail);
+#elif FBSIMD_SSE2
+    __m128i fail_low = _mm_loadu_si128((const __m128i*)unused_lanes);
+    __m128i fail_high = _mm_loadu_si128((const __m128i*)(unused_lanes + 2));
+    for (u32 t = 0; t < term_count; t++) {
+        u32 input = term_inputs[t];
+        const u64* masks = term_masks + t * term_words;
+        __m128i down = _mm_set1_epi64x(-(i64)((state[input >> 6] >> (input & 63)) & 1));
+        fail_low = _mm_or_si128(fail_low, _mm_or_si128(_mm_andnot_si128(down, _mm_loadu_si128((const __m128i*)masks)),
+                                                       _mm_and_si128(down, _mm_loadu_si128((const __m128i*)(masks + 4)))));
+        fail_high = _mm_or_si128(fail_high, _mm_or_si128(_mm_andnot_si128(down, _mm_loadu_si128((const __m128i*)(masks + 2))),
+                                                         _mm_and_si128(down, _mm_loadu_si128((const __m128i*)(masks + 6)))));
+    }
+    _mm_storeu_si128((__m128i*)failed, fail_low);
+    _mm_storeu_si128((__m128i*)(failed + 2), fail_high);
+#else
+    for (u32 i = 0; i < 4; i++) {
+        failed[i] = unused_lanes[i];
+    }
+    for (u32 t = 0; t < term_count; t++) {
+        u32 input = term_inputs[t];
+        const u64* masks = term_masks + t * term_words;
+        u64 down = 0 - ((state[input >> 6] >> (input & 63)) & 1);
+        for (u32 i = 0; i < 4; i++) {
+            failed[i] |= (masks[i] & ~down) | (masks[4 + i] & down);
+        }
+    }
+#endif
+
+    for (u32 i = 0; i < max_actions / 64; i++) {
+        previous[i] = active[i];
+        active[i] = ~failed[i] | ~failed[i + 2];
+    }
+}
+
+b8 input::action_map::load(const char* path) {
+    filesystem::file file;
+    if (!file.open(path, filesystem::FILE_MODE_READ, true)) {
+        FBERROR("action_map::load: Could not open %s.", path);
+        return false;
+    }
+
+    u8* contents = nullptr;
+    u64 size = 0;
+    b8 read = file.read(&contents, &size);
+    file.close();
+
+    const map_header* header = (const map_header*)contents;
+    b8 valid = read && size >= sizeof(map_header) && header->magic == map_magic && header->version == map_version &&
+               size >= sizeof(map_header) + sizeof(map_binding) * (u64)header->binding_count + sizeof(map_axis) * (u64)header->axis_count;
+    if (!valid) {
+        FBERROR("action_map::load: %s is not a version %u mapping file.", path, map_version);
+        if (contents) {
+            memory::fbfree(contents, size, memory::MEMORY_TAG_STRING);
+        }
+        return false;
+    }
+
+    memory::fbzero(bindings, sizeof(bindings));
+    for (u32 i = 0; i < max_action_axes; i++) {
+        axis_negative[i] = invalid_u32;
+        axis_positive[i] = invalid_u32;
+    }
+    dirty = true;
+
+    b8 result = true;
+    const map_binding* file_bindings = (const map_binding*)(contents + sizeof(map_header));
+    for (u32 i = 0; i < header->binding_count; i++) {
+        const map_binding& b = file_bindings[i];
+        result &= bind(b.action, b.slot, b.codes, b.code_count, (binding_flags)b.flags);
+    }
+
+    const map_axis* file_axes = (const map_axis*)(file_bindings + header->binding_count);
+    for (u32 i = 0; i < header->axis_count; i++) {
+        result &= bind_axis(file_axes[i].axis, file_axes[i].negative, file_axes[i].positive);
+    }
+
+    memory::fbfree(contents, size, memory::MEMORY_TAG_STRING);
+
+    if (!result) {
+        FBWARN("action_map::load: Some entries of %s were invalid and skipped.", path);
+    }
+    return true;
+}
+
+b8 input::action_map::save(const char* path) const {
+    map_header header = {map_magic, map_version, 0, 0};
+    for (u32 action = 0; action < max_actions; action++) {
+        for (u32 slot = 0; slot < bindings_per_action; slot++) {
+            header.binding_count += bindings[action][slot].code_count > 0;
+        }
+    }
+    for (u32 axis = 0; axis < max_action_axes; axis++) {
+        header.axis_count += axis_negative[axis] != invalid_u32;
+    }
+
+    u64 size = sizeof(map_header) + sizeof(map_binding) * header.binding_count + sizeof(map_axis) * header.axis_count;
+    u8* contents = (u8*)memory::fballocate(size, memory::MEMORY_TAG_STRING);
+    memory::fbcopy(contents, &header, sizeof(header));
+
+    map_binding* file_bindings = (map_binding*)(contents + sizeof(map_header));
+    for (u32 action = 0; action < max_actions; action++) {
+        for (u32 slot = 0; slot < bindings_per_action; slot++) {
+            const binding& b = bindings[action][slot];
+            if (b.code_count == 0) {
+                continue;
+            }
+
+            map_binding& out = *file_bindings++;
+            out.action = (u16)action;
+            out.slot = (u8)slot;
+            out.flags = b.flags;
+            out.code_count = b.code_count;
+            memory::fbcopy(out.codes, b.codes, sizeof(b.codes));
+        }
+    }
+
+    map_axis* file_axes = (map_axis*)file_bindings;
+    for (u32 axis = 0; axis < max_action_axes; axis++) {
+        if (axis_negative[axis] != invalid_u32) {
+            map_axis& out = *file_axes++;
+            out.axis = (u16)axis;
+            out.negative = (u16)axis_negative[axis];
+            out.positive = (u16)axis_positive[axis];
+        }
+    }
+
+    filesystem::file file;
+    b8 written = false;
+    if (file.open(path, filesystem::FILE_MODE_WRITE, true)) {
+        u64 bytes = 0;
+        written = file.write(contents, &bytes, size);
+        file.close();
+    }
+    memory::fbfree(contents, size, memory::MEMORY_TAG_STRING);
+
+    if (!written) {
+        FBERROR("action_map::save: Could not write %s.", path);
+    }
+    return written;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "defines.hpp"
+
+// NOTE: Actions are bound to up to two chords of keys and buttons each. Binding slots are compiled into 256
+//       lanes, one bit per (action, slot), and every key or button used by a binding gets two lane masks: the
+//       bindings needing it down and the bindings needing it up. Evaluating the map ORs one of the two masks per
+//       used input into a 256 bit failure mask, so all bindings are evaluated together and the cost only grows
+//       with the number of distinct inputs bound. Modifiers match either side: KEY_SHIFT, KEY_CONTROL and
+//       KEY_ALT in a chord are down while their left or right key is.
+
+namespace fabric::input {
+    static constexpr u32 max_actions = 128;
+    static constexpr u32 bindings_per_action = 2;
+    static constexpr u32 max_action_axes = 32;
+    static constexpr u32 max_chord_size = 4;
+    // Buttons are bound as button_code_base + button, keys as their key code.
+    static constexpr u16 button_code_base = 256;
+
+    enum binding_flags : u8 {
+        BINDING_NONE = 0,
+        // Shift, control and alt must be up unless they are part of the chord, so Ctrl+S doesn't also trigger S.
+        BINDING_EXACT_MODIFIERS = 0x1
+    };
+
+    struct binding {
+        u16 codes[max_chord_size];
+        u8 code_count;
+        binding_flags flags;
+    };
+
+    class FBAPI action_map {
+       public:
+        action_map() = default;
+        ~action_map();
+
+        b8 create();
+        void destroy();
+
+        // slot is 0 or 1, replacing what was bound there.
+        b8 bind(u32 action, u32 slot, const u16* codes, u32 code_count, binding_flags flags = BINDING_EXACT_MODIFIERS);
+        void unbind(u32 action, u32 slot);
+        // The axis reads -1 while only the negative action is active, 1 while only the positive one is.
+        b8 bind_axis(u32 axis, u32 negative_action, u32 positive_action);
+
+        // Binary mapping files, replacing every binding.
+        b8 load(const char* path);
+        b8 save(const char* path) const;
+
+        // Evaluates every action against the current input state. Called once a frame, before the queries.
+        void update();
+
+        b8 is_active(u32 action) const { return (active[action >> 6] >> (action & 63)) & 1; }
+        b8 was_triggered(u32 action) const { return ((active[action >> 6] & ~previous[action >> 6]) >> (action & 63)) & 1; }
+        b8 was_released(u32 action) const { return ((~active[action >> 6] & previous[action >> 6]) >> (action & 63)) & 1; }
+        f32 get_axis(u32 axis) const;
+
+       private:
+        void compile();
+
+       private:
+        binding bindings[max_actions][bindings_per_action] = {};
+        // Actions of each axis, invalid_u32 when unbound.
+        u32 axis_negative[max_action_axes] = {};
+        u32 axis_positive[max_action_axes] = {};
+
+        // Compiled lanes. term_masks holds 8 words per term: 4 for the lanes needing the input down, 4 for
+        // the lanes needing it up.
+        u16* term_inputs = nullptr;
+        u64* term_masks = nullptr;
+        u32 term_count = 0;
+        u64 unused_lanes[4] = {};
+        b8 dirty = true;
+
+        u64 active[max_actions / 64] = {};
+        u64 previous[max_actions / 64] = {};
+    };
+}  // namespace fabric::input
@@ -8,6 +8,21 @@ struct application_config {
     i16 posY;
     i16 client_width;
     i16 client_height;
+
+    // Records the events driving the session to this file when set.
+    const char* event_record_path = nullptr;
+    // Replays a recorded session from this file instead of reading the platform's input.
+    const char* event_replay_path = nullptr;
+
+    // Writes the log to this file too when set. Older logs are kept as <path>.1.lz4, <path>.2.lz4 and so on.
+    const char* log_file_path = nullptr;
+    // Starts a new log file once it would grow past this many bytes, 0 to never rotate by size.
+    u64 log_file_max_size = 16 * 1024 * 1024;
+    // Starts a new log file after this many seconds, 0 to never rotate by age.
+    u64 log_file_max_age = 0;
+    u32 log_file_max_rotated = 4;
+    // Keeps rotated files uncompressed, as <path>.1 and so on, when false.
+    b8 log_file_compress = true;
 };
 
 struct application {
@@ -1,6 +1,7 @@
 #include "core/application.hpp"
 #include "core/engine.hpp"
 #include "core/event.hpp"
+#include "core/event_trace.hpp"
 #include "core/input.hpp"
 #include "core/logger.hpp"
 #include "core/memory.hpp"
@@ -55,6 +56,7 @@ b8 fabric::initialize(application& app) {
     u64 memory_system_memory_requirement;
     u64 logger_system_memory_requirement;
     u64 event_system_memory_requirement;
+    u64 event_trace_system_memory_requirement;
     u64 input_system_memory_requirement;
     u64 platform_system_memory_requirement;
     u64 renderer_system_memory_requirement;
@@ -63,12 +65,15 @@ b8 fabric::initialize(application& app) {
         memory::initialize(memory_system_memory_requirement, nullptr);
         internal_systems_memory_requirement += memory_system_memory_requirement;
 
-        logger::initialize(logger_system_memory_requirement, nullptr);
+        logger::initialize(logger_system_memory_requirement, nullptr, app.config);
         internal_systems_memory_requirement += logger_system_memory_requirement;
 
         event::initialize(event_system_memory_requirement, nullptr);
         internal_systems_memory_requirement += event_system_memory_requirement;
 
+        event_trace::initialize(event_trace_system_memory_requirement, nullptr, app.config);
+        internal_systems_memory_requirement += event_trace_system_memory_requirement;
+
         input::initialize(input_system_memory_requirement, nullptr);
         internal_systems_memory_requirement += input_system_memory_requirement;
 
@@ -89,7 +94,7 @@ b8 fabric::initialize(application& app) {
             return false;
         }
 
-        if (!logger::initialize(logger_system_memory_requirement, state->internal_systems.allocate(logger_system_memory_requirement))) {
+        if (!logger::initialize(logger_system_memory_requirement, state->internal_systems.allocate(logger_system_memory_requirement), app.config)) {
             FBERROR("An error ocurred during logger system initialization.");
             state->current_status = application_status::terminating;
             return false;
@@ -107,6 +112,12 @@ b8 fabric::initialize(application& app) {
             return false;
         }
 
+        if (!event_trace::initialize(event_trace_system_memory_requirement, state->internal_systems.allocate(event_trace_system_memory_requirement), app.config)) {
+            FBERROR("An error ocurred during event trace system initialization.");
+            state->current_status = application_status::terminating;
+            return false;
+        }
+
         if (!platform::initialize(platform_system_memory_requirement, state->internal_systems.allocate(platform_system_memory_requirement), state->window)) {
             FBERROR("An error ocurred during platform system initialization.");
             state->current_status = application_status::terminating;
@@ -143,17 +154,29 @@ b8 fabric::update(application& app) {
     state->last_time = clock.mark();
     // f64 running_time = 0.0;
     f64 target_frame_seconds = 1.0 / 60.0;
+    u64 frame = 0;
 
     while (state->current_status != application_status::terminating) {
-        if (!platform::update(state->window)) {
-            FBERROR("An error ocurred during platform update.");
-            state->current_status = application_status::terminating;
-            return false;
+        if (event_trace::is_replaying()) {
+            event_trace::replay_frame(frame);
+        } else {
+            event_trace::begin_capture(frame);
+            b8 updated = platform::update(state->window);
+            event_trace::end_capture();
+
+            if (!updated) {
+                FBERROR("An error ocurred during platform update.");
+                state->current_status = application_status::terminating;
+                return false;
+            }
         }
 
+        // Delivers what the message pump posted, coalesced.
+        event::dispatch();
+
         if (state->current_status == application_status::running) {
             f64 current_time = clock.mark();
-            f64 delta = (current_time - state->last_time);
+            f64 delta = event_trace::frame_timestep(frame, current_time - state->last_time);
             f64 frame_start_time = platform::get_absolute_time();
 
             if (app.begin_frame) {
@@ -197,6 +220,8 @@ b8 fabric::update(application& app) {
 
             state->last_time = current_time;
         }
+
+        frame++;
     }
 
     return true;
@@ -212,6 +237,7 @@ void fabric::terminate(application& app) {
         event::checkout(event::KEY_PRESSED, 0, on_key);
         event::checkout(event::RESIZED, 0, on_resize);
 
+        event_trace::terminate();
         input::terminate();
         renderer::terminate();
         event::terminate();
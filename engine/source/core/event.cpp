@@ -1,29 +1,239 @@
 #include "core/event.hpp"
 #include "core/logger.hpp"
 #include "core/memory.hpp"
-#include "ftl/darray.hpp"
+#include "ftl/mpsc_queue.hpp"
+#include "platform/platform.hpp"
 
 using namespace fabric;
 
 namespace {
-    // If this isn't enough...
-    static constexpr u16 max_message_codes = 16384U;
+    // Codes that can have listeners or a coalescing policy. If this isn't enough...
+    static constexpr u32 max_registered_codes = 512U;
+    // Open addressed, at most half full. Power of two.
+    static constexpr u32 code_table_size = max_registered_codes * 2;
+    static constexpr u16 no_entry = 0xFFFF;
+    // Events posted per frame before post falls back to sending them right away.
+    static constexpr u32 max_posted_events = 1024U;
+    // Bytes of typed payloads too large for a context that can be posted per frame.
+    static constexpr u32 max_payload_bytes = 16384U;
+    // Events other threads can post between two dispatches. Power of two.
+    static constexpr u32 max_inbox_events = 1024U;
 
     struct registered_event {
         void* listener;
         on_event_pfn callback;
+        i32 priority;
     };
 
     struct event_code_entry {
-        ftl::darray<registered_event> events;
+        // The listeners are pool[first, first + listener_count). A range is never modified in place, so a send
+        // walking it is unaffected by checkin and checkout.
+        u32 first;
+        u32 listener_count;
+        // Queue slot of the event this code coalesces into, invalid_u32 when nothing is queued.
+        u32 posted;
+        u16 code;
+        event::coalesce_policy policy;
     };
 
+    struct posted_event {
+        u16 code;
+        // Registry entry of the code, no_entry if it had none when posted.
+        u16 entry;
+        void* sender;
+        event::context context;
+    };
+
+    struct event_queue {
+        posted_event events[max_posted_events];
+        u32 count;
+
+        // Copies of the large typed payloads referenced by events, released with them.
+        u8 payloads[max_payload_bytes];
+        u64 payload_size;
+    };
+
+    struct retired_block {
+        void* block;
+        u64 size;
+    };
+
+    // NOTE: Codes map to dense entries through a small hash table, and the listeners of every code share one
+    //       pool. Changing a code's listeners appends a new range at the end of the pool and leaves the old one
+    //       as garbage, which is compacted away once it outweighs the live ranges and no send is in progress.
     struct system_state {
-        event_code_entry entries[max_message_codes];
+        u16 code_table[code_table_size];
+        event_code_entry entries[max_registered_codes];
+        u32 entry_count;
+
+        registered_event* pool;
+        u32 pool_count;
+        u32 pool_capacity;
+        u32 pool_garbage;
+
+        // Posts go to queues[current] while the other one is being dispatched.
+        event_queue queues[2];
+        u32 current;
+
+        // Drained by the main thread only.
+        ftl::mpsc_queue<posted_event, max_inbox_events> posted_from_threads;
+        u64 main_thread;
+
+        on_event_trace_pfn trace_hook;
+
+        // Nested sends in progress. Pools replaced meanwhile are freed once it drops to 0.
+        u32 send_depth;
+        retired_block* retired;
+        u32 retired_count;
+        u32 retired_capacity;
     };
 
     static system_state* state;
 
+    FBINLINE u32 code_hash(u16 code) {
+        return ((u32)code * 2654435761u) & (code_table_size - 1);
+    }
+
+    event_code_entry* find_entry(u16 code) {
+        for (u32 slot = code_hash(code);; slot = (slot + 1) & (code_table_size - 1)) {
+            u16 index = state->code_table[slot];
+            if (index == no_entry) {
+                return nullptr;
+            }
+            if (state->entries[index].code == code) {
+                return &state->entries[index];
+            }
+        }
+    }
+
+    // Entries are never removed, a code keeps its entry once it had listeners or a policy.
+    event_code_entry* find_or_add_entry(u16 code) {
+        u32 slot = code_hash(code);
+        for (; state->code_table[slot] != no_entry; slot = (slot + 1) & (code_table_size - 1)) {
+            if (state->entries[state->code_table[slot]].code == code) {
+                return &state->entries[state->code_table[slot]];
+            }
+        }
+
+        if (state->entry_count == max_registered_codes) {
+            FBERROR("The event registry is full (%u codes).", max_registered_codes);
+            return nullptr;
+        }
+
+        event_code_entry& entry = state->entries[state->entry_count];
+        entry.first = 0;
+        entry.listener_count = 0;
+        entry.posted = invalid_u32;
+        entry.code = code;
+        entry.policy = event::COALESCE_NONE;
+        state->code_table[slot] = (u16)state->entry_count++;
+
+        return &entry;
+    }
+
+    void retire_block(void* block, u64 size) {
+        if (!block) {
+            return;
+        }
+
+        if (state->send_depth > 0) {
+            if (state->retired_count == state->retired_capacity) {
+                u32 capacity = state->retired_capacity ? state->retired_capacity * 2 : 16;
+                retired_block* retired = (retired_block*)memory::fballocate(sizeof(retired_block) * capacity, memory::MEMORY_TAG_EVENT);
+                if (state->retired) {
+                    memory::fbcopy(retired, state->retired, sizeof(retired_block) * state->retired_count);
+                    memory::fbfree(state->retired, sizeof(retired_block) * state->retired_capacity, memory::MEMORY_TAG_EVENT);
+                }
+                state->retired = retired;
+                state->retired_capacity = capacity;
+            }
+            state->retired[state->retired_count++] = {block, size};
+        } else {
+            memory::fbfree(block, size, memory::MEMORY_TAG_EVENT);
+        }
+    }
+
+    // Copies the live ranges into a new pool of the given capacity, packed in entry order.
+    void repack_pool(u32 capacity) {
+        registered_event* pool = (registered_event*)memory::fballocate(sizeof(registered_event) * capacity, memory::MEMORY_TAG_EVENT);
+
+        u32 count = 0;
+        for (u32 i = 0; i < state->entry_count; i++) {
+            event_code_entry& entry = state->entries[i];
+            memory::fbcopy(pool + count, state->pool + entry.first, sizeof(registered_event) * entry.listener_count);
+            entry.first = count;
+            count += entry.listener_count;
+        }
+
+        retire_block(state->pool, sizeof(registered_event) * state->pool_capacity);
+        state->pool = pool;
+        state->pool_count = count;
+        state->pool_capacity = capacity;
+        state->pool_garbage = 0;
+    }
+
+    // Returns the first of count new listener slots at the end of the pool.
+    u32 append_range(u32 count) {
+        if (state->pool_count + count > state->pool_capacity) {
+            u32 live = state->pool_count - state->pool_garbage;
+            u32 capacity = state->pool_capacity ? state->pool_capacity : 64;
+            while (capacity < (live + count) * 2) {
+                capacity *= 2;
+            }
+            repack_pool(capacity);
+        }
+
+        u32 first = state->pool_count;
+        state->pool_count += count;
+        return first;
+    }
+
+    void collect_garbage() {
+        if (state->send_depth == 0 && state->pool_garbage > 64 && state->pool_garbage * 2 > state->pool_count) {
+            repack_pool(state->pool_capacity);
+        }
+    }
+
+    b8 on_main_thread() {
+        return platform::get_current_thread_id() == state->main_thread;
+    }
+
+    b8 queue_event(u16 code, void* sender, const event::context& context) {
+        event_code_entry* entry = find_entry(code);
+        event_queue& queue = state->queues[state->current];
+        b8 coalesced = entry && entry->policy != event::COALESCE_NONE;
+
+        if (coalesced && entry->posted != invalid_u32) {
+            posted_event& queued = queue.events[entry->posted];
+            queued.sender = sender;
+
+            if (entry->policy == event::COALESCE_LAST) {
+                queued.context = context;
+            } else {
+                i32 sum = (i32)queued.context.data.i8[0] + (i32)context.data.i8[0];
+                queued.context.data.i8[0] = (i8)(sum < -128 ? -128 : (sum > 127 ? 127 : sum));
+            }
+
+            return true;
+        }
+
+        if (queue.count == max_posted_events) {
+            FBWARN("event::post: The event queue is full, sending event %u right away.", code);
+            return event::send(code, sender, context);
+        }
+
+        if (coalesced) {
+            entry->posted = queue.count;
+        }
+
+        posted_event& queued = queue.events[queue.count++];
+        queued.code = code;
+        queued.entry = entry ? (u16)(entry - state->entries) : no_entry;
+        queued.sender = sender;
+        queued.context = context;
+
+        return true;
+    }
 }  // namespace
 
 b8 event::initialize(u64& memory_requirement, void* memory) {
@@ -39,38 +249,80 @@ b8 event::initialize(u64& memory_requirement, void* memory) {
     state = (system_state*)memory;
     memory::fbzero(state, sizeof(system_state));
 
+    for (u32 i = 0; i < code_table_size; i++) {
+        state->code_table[i] = no_entry;
+    }
+
+    find_or_add_entry(event::MOUSE_MOVED)->policy = event::COALESCE_LAST;
+    find_or_add_entry(event::RESIZED)->policy = event::COALESCE_LAST;
+    find_or_add_entry(event::MOUSE_WHEEL)->policy = event::COALESCE_SUM_I8;
+
+    state->posted_from_threads.reset();
+    state->main_thread = platform::get_current_thread_id();
+
     FBINFO("Event system initialized.");
 
     return true;
 }
 
 void event::terminate() {
+    if (state) {
+        if (state->pool) {
+            memory::fbfree(state->pool, sizeof(registered_event) * state->pool_capacity, memory::MEMORY_TAG_EVENT);
+        }
+
+        if (state->retired) {
+            memory::fbfree(state->retired, sizeof(retired_block) * state->retired_capacity, memory::MEMORY_TAG_EVENT);
+        }
+    }
+
     state = nullptr;
 }
 
-b8 event::checkin(u16 code, void* listener, on_event_pfn on_event) {
+b8 event::checkin(u16 code, void* listener, on_event_pfn on_event, i32 priority) {
     if (!state) {
         FBERROR("Trying to register an event before the event system was initialized.");
         return false;
     }
 
-    if(state->entries[code].events.capacity() == 0) {
-        state->entries[code].events.reserve(1);
+    if (!on_main_thread()) {
+        FBERROR("event::checkin can only be called from the main thread.");
+        return false;
     }
 
-    u64 registered_count = state->entries[code].events.length();
+    event_code_entry* entry = find_or_add_entry(code);
+    if (!entry) {
+        return false;
+    }
 
-    for (u64 i = 0; i < registered_count; i++) {
-        if (state->entries[code].events[i].listener == listener) {
-            FBWARN("Trying to register the same listener again. Nothing will be done.");
+    for (u32 i = 0; i < entry->listener_count; i++) {
+        const registered_event& e = state->pool[entry->first + i];
+        if (e.listener == listener && e.callback == on_event) {
+            FBWARN("Trying to register the same listener and callback again. Nothing will be done.");
             return false;
         }
     }
 
-    registered_event event;
-    event.listener = listener;
-    event.callback = on_event;
-    state->entries[code].events.push(event);
+    // The pool may be repacked by the append, which moves the old range too.
+    u32 first = append_range(entry->listener_count + 1);
+    registered_event* old = state->pool + entry->first;
+
+    u32 position = 0;
+    while (position < entry->listener_count && old[position].priority >= priority) {
+        position++;
+    }
+
+    memory::fbcopy(state->pool + first, old, sizeof(registered_event) * position);
+    memory::fbcopy(state->pool + first + position + 1, old + position, sizeof(registered_event) * (entry->listener_count - position));
+    state->pool[first + position].listener = listener;
+    state->pool[first + position].callback = on_event;
+    state->pool[first + position].priority = priority;
+
+    state->pool_garbage += entry->listener_count;
+    entry->first = first;
+    entry->listener_count++;
+
+    collect_garbage();
 
     return true;
 }
@@ -81,16 +333,34 @@ b8 event::checkout(u16 code, void* listener, on_event_pfn on_event) {
         return false;
     }
 
-    if (state->entries[code].events.empty()) {
+    if (!on_main_thread()) {
+        FBERROR("event::checkout can only be called from the main thread.");
+        return false;
+    }
+
+    event_code_entry* entry = find_entry(code);
+
+    if (!entry || entry->listener_count == 0) {
         FBWARN("Trying to unregister an event that was not registered before. Nothing will be done.");
         return false;
     }
 
-    u64 registered_count = state->entries[code].events.length();
-    for (u64 i = 0; i < registered_count; i++) {
-        registered_event& e = state->entries[code].events[i];
+    for (u32 i = 0; i < entry->listener_count; i++) {
+        registered_event& e = state->pool[entry->first + i];
         if (e.listener == listener && e.callback == on_event) {
-            state->entries[code].events.pop(i);
+            u32 count = entry->listener_count;
+            u32 first = count > 1 ? append_range(count - 1) : 0;
+            if (count > 1) {
+                registered_event* old = state->pool + entry->first;
+                memory::fbcopy(state->pool + first, old, sizeof(registered_event) * i);
+                memory::fbcopy(state->pool + first + i, old + i + 1, sizeof(registered_event) * (count - i - 1));
+            }
+
+            state->pool_garbage += count;
+            entry->first = first;
+            entry->listener_count--;
+
+            collect_garbage();
             return true;
         }
     }
@@ -105,19 +375,146 @@ b8 event::send(u16 code, void* sender, event::context eventContext) {
         return false;
     }
 
-    if (state->entries[code].events.empty()) {
+    if (state->trace_hook && state->send_depth == 0) {
+        state->trace_hook(code, false, eventContext);
+    }
+
+    const event_code_entry* entry = find_entry(code);
+    if (!entry || entry->listener_count == 0) {
         return false;
     }
 
-    u64 registered_count = state->entries[code].events.length();
-    for (u64 i = 0; i < registered_count; i++) {
-        registered_event& e = state->entries[code].events[i];
+    // Listeners checked in or out by a callback only see events sent after this one.
+    const registered_event* listeners = state->pool + entry->first;
+    u32 registered_count = entry->listener_count;
+
+    b8 handled = false;
+    state->send_depth++;
+    for (u32 i = 0; i < registered_count; i++) {
+        const registered_event& e = listeners[i];
         if (e.callback(code, sender, e.listener, eventContext)) {
             // Message was handled, stop dispatching
-            return true;
+            handled = true;
+            break;
         }
     }
+    state->send_depth--;
 
-    // Nothing was found
-    return false;
-}
\ No newline at end of file
+    if (state->send_depth == 0) {
+        for (u32 i = 0; i < state->retired_count; i++) {
+            memory::fbfree(state->retired[i].block, state->retired[i].size, memory::MEMORY_TAG_EVENT);
+        }
+        state->retired_count = 0;
+        collect_garbage();
+    }
+
+    return handled;
+}
+
+b8 event::post(u16 code, void* sender, event::context eventContext) {
+    if (!state) {
+        FBERROR("Trying to post an event before the event system was initialized.");
+        return false;
+    }
+
+    if (!on_main_thread()) {
+        b8 pushed = state->posted_from_threads.push_with([&](posted_event& e) {
+            e.code = code;
+            e.sender = sender;
+            e.context = eventContext;
+        });
+        if (!pushed) {
+            FBWARN("event::post: The event inbox is full, event %u was dropped.", code);
+            return false;
+        }
+        return true;
+    }
+
+    if (state->trace_hook && state->send_depth == 0) {
+        state->trace_hook(code, true, eventContext);
+    }
+
+    return queue_event(code, sender, eventContext);
+}
+
+void event::set_coalescing(u16 code, coalesce_policy policy) {
+    if (!state) {
+        FBERROR("Trying to set an event coalescing policy before the event system was initialized.");
+        return;
+    }
+
+    event_code_entry* entry = find_or_add_entry(code);
+    if (entry) {
+        entry->policy = policy;
+    }
+}
+
+void event::dispatch() {
+    if (!state) {
+        return;
+    }
+
+    // Events from other threads join this frame's queue, after the ones posted on the main thread.
+    u64 inbox_end = state->posted_from_threads.get_push_count();
+    while (state->posted_from_threads.get_pop_count() < inbox_end) {
+        posted_event* incoming = state->posted_from_threads.front();
+        if (!incoming) {
+            break;
+        }
+        queue_event(incoming->code, incoming->sender, incoming->context);
+        state->posted_from_threads.pop();
+    }
+
+    event_queue& queue = state->queues[state->current];
+    state->current ^= 1;
+
+    // Coalescing restarts with the new queue, before any listener gets the chance to post.
+    for (u32 i = 0; i < queue.count; i++) {
+        if (queue.events[i].entry != no_entry) {
+            state->entries[queue.events[i].entry].posted = invalid_u32;
+        }
+    }
+
+    for (u32 i = 0; i < queue.count; i++) {
+        const posted_event& e = queue.events[i];
+        send(e.code, e.sender, e.context);
+    }
+
+    queue.count = 0;
+    queue.payload_size = 0;
+}
+
+void event::set_trace_hook(on_event_trace_pfn hook) {
+    if (state) {
+        state->trace_hook = hook;
+    }
+}
+
+b8 event::internal::post_payload(u16 code, void* sender, const void* data, u64 size, u64 alignment) {
+    if (!state) {
+        FBERROR("Trying to post an event before the event system was initialized.");
+        return false;
+    }
+
+    if (!on_main_thread()) {
+        FBERROR("event::post: Payloads over %u bytes can only be posted from the main thread.", (u32)sizeof(context));
+        return false;
+    }
+
+    event_queue& queue = state->queues[state->current];
+    u64 base = (u64)queue.payloads;
+    u64 offset = ((base + queue.payload_size + alignment - 1) & ~(alignment - 1)) - base;
+
+    context ctx = {};
+    if (offset + size > max_payload_bytes) {
+        FBWARN("event::post: The payload arena is full, sending event %u right away.", code);
+        ctx.data.u64[0] = (u64)data;
+        return send(code, sender, ctx);
+    }
+
+    memory::fbcopy(queue.payloads + offset, data, size);
+    queue.payload_size = offset + size;
+
+    ctx.data.u64[0] = base + offset;
+    return queue_event(code, sender, ctx);
+}
@@ -74,17 +74,130 @@ namespace fabric::event {
 
         MAX_CODES = 0xFF
     };
+
+    // How events posted with the same code during one frame are merged before dispatch.
+    enum coalesce_policy : u8 {
+        // Every posted event is delivered.
+        COALESCE_NONE = 0,
+        // Only the last posted event is delivered, in the queue position of the first one.
+        COALESCE_LAST,
+        // data.i8[0] of every posted event is added up, saturating, into the first one.
+        COALESCE_SUM_I8,
+    };
 }  // namespace fabric::event
 
 // Returns true if event was handled
 typedef b8 (*on_event_pfn)(u16 code, void* sender, void* listenerInst, fabric::event::context data);
+// Sees the events sent or posted on the main thread from outside of any listener.
+typedef void (*on_event_trace_pfn)(u16 code, b8 posted, const fabric::event::context& data);
 
 namespace fabric::event {
     b8 initialize(u64& memory_requirement, void* memory);
     void terminate();
 
-    FBAPI b8 checkin(u16 code, void* listener, on_event_pfn on_event);
+    // Main thread only, listeners included: a listener checked in or out while an event is being sent takes
+    // effect from the next send. Listeners with a higher priority are called first, equal priorities in the
+    // order they checked in.
+    FBAPI b8 checkin(u16 code, void* listener, on_event_pfn on_event, i32 priority = 0);
     FBAPI b8 checkout(u16 code, void* listener, on_event_pfn on_event);
     FBAPI b8 send(u16 code, void* sender, context eventContext);
 
+    // Queues the event until the next dispatch, merging it with the ones already queued for the same code as
+    // set_coalescing says. MOUSE_MOVED and RESIZED default to COALESCE_LAST, MOUSE_WHEEL to COALESCE_SUM_I8.
+    // Can be called from any thread: other threads go through a lock-free inbox, which drops the event and
+    // returns false when full.
+    FBAPI b8 post(u16 code, void* sender, context eventContext);
+    FBAPI void set_coalescing(u16 code, coalesce_policy policy);
+    // Sends every event posted before the call, in order, the ones from other threads last. Events posted by the
+    // listeners wait for the next one. The engine calls it once a frame, right after platform::update.
+    void dispatch();
+
+    // nullptr to stop tracing. Used by the event recorder.
+    void set_trace_hook(on_event_trace_pfn hook);
+}  // namespace fabric::event
+
+// NOTE: Typed events are plain structs naming their code, which should be outside of the reserved range:
+//
+//           struct resize_event {
+//               static constexpr u16 code = 0x100;
+//               u32 width, height;
+//           };
+//
+//       Listeners are member functions taking the payload, b8 game::on_resize(const resize_event& e), and check in
+//       with event::subscribe<&game::on_resize>(this, priority). The thunk calling them is generated at compile
+//       time, so the only indirect call left is the one into the thunk. Payloads of up to 16 bytes travel inside
+//       the context, larger ones by pointer: to the caller's copy for send, to a copy in the frame's payload arena
+//       for post. Typed events share codes, listeners, queues and coalescing with the untyped ones, so a code
+//       should only ever be used with one payload type.
+
+namespace fabric::event {
+    namespace internal {
+        template <typename E>
+        struct payload {
+            STATIC_ASSERT(__is_trivially_copyable(E), "Event payloads must be trivially copyable");
+
+            static constexpr b8 packed = sizeof(E) <= sizeof(context) && alignof(E) <= alignof(context);
+
+            static context pack(const E& value) {
+                context ctx = {};
+                if constexpr (packed) {
+                    *(E*)ctx.data.u8 = value;
+                } else {
+                    ctx.data.u64[0] = (u64)&value;
+                }
+                return ctx;
+            }
+
+            static const E& unpack(const context& ctx) {
+                if constexpr (packed) {
+                    return *(const E*)ctx.data.u8;
+                } else {
+                    return *(const E*)ctx.data.u64[0];
+                }
+            }
+        };
+
+        template <auto fn>
+        struct thunk;
+
+        template <typename T, typename E, b8 (T::*fn)(const E&)>
+        struct thunk<fn> {
+            using listener = T;
+            using event = E;
+
+            static b8 call(u16 code, void* sender, void* listener_inst, context ctx) {
+                return (((T*)listener_inst)->*fn)(payload<E>::unpack(ctx));
+            }
+        };
+
+        // Copies an unpacked payload into the current frame's arena and queues it. Main thread only.
+        FBAPI b8 post_payload(u16 code, void* sender, const void* data, u64 size, u64 alignment);
+    }  // namespace internal
+
+    template <auto fn>
+    b8 subscribe(typename internal::thunk<fn>::listener* listener, i32 priority = 0) {
+        using thunk = internal::thunk<fn>;
+        return checkin(thunk::event::code, listener, &thunk::call, priority);
+    }
+
+    template <auto fn>
+    b8 unsubscribe(typename internal::thunk<fn>::listener* listener) {
+        using thunk = internal::thunk<fn>;
+        return checkout(thunk::event::code, listener, &thunk::call);
+    }
+
+    template <typename E>
+    b8 send(const E& event, void* sender = nullptr) {
+        return send(E::code, sender, internal::payload<E>::pack(event));
+    }
+
+    // Payloads over 16 bytes can only be posted from the main thread.
+    template <typename E>
+    b8 post(const E& event, void* sender = nullptr) {
+        if constexpr (internal::payload<E>::packed) {
+            return post(E::code, sender, internal::payload<E>::pack(event));
+        } else {
+            return internal::post_payload(E::code, sender, &event, sizeof(E), alignof(E));
+        }
+    }
 }  // namespace fabric::event
\ No newline at end of file
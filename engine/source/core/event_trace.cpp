@@ -0,0 +1,295 @@
+#include "core/event_trace.hpp"
+#include "core/application.hpp"
+#include "core/event.hpp"
+#include "core/input.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+#include "platform/filesystem.hpp"
+#include "platform/platform.hpp"
+
+using namespace fabric;
+
+namespace {
+    // "FBET"
+    static constexpr u32 trace_magic = 0x54454246U;
+    static constexpr u32 trace_version = 1;
+    // Records buffered before they are written out.
+    static constexpr u32 max_buffered_records = 4096;
+
+    enum record_kind : u8 {
+        RECORD_SEND = 0,
+        RECORD_POST,
+        // context.data.f64[0] is the frame's timestep.
+        RECORD_FRAME
+    };
+
+    struct trace_header {
+        u32 magic;
+        u32 version;
+    };
+
+    struct trace_record {
+        u32 frame;
+        u16 code;
+        record_kind kind;
+        u8 reserved;
+        // Seconds since the recording started.
+        f64 time;
+        event::context context;
+    };
+
+    STATIC_ASSERT(sizeof(trace_record) == 32, "Trace records are expected to be 32 bytes");
+
+    struct system_state {
+        filesystem::file file;
+        b8 recording;
+        b8 replaying;
+        f64 start_time;
+
+        // Recording.
+        trace_record* buffer;
+        u32 buffered;
+        u64 frame;
+        u64 written;
+
+        // Replaying.
+        u8* contents;
+        u64 contents_size;
+        trace_record* records;
+        u64 record_count;
+        u64 next;
+        u64 last_frame;
+    };
+
+    static system_state* state;
+
+    void flush() {
+        if (state->buffered == 0) {
+            return;
+        }
+
+        u64 written = 0;
+        if (!state->file.write(state->buffer, &written, sizeof(trace_record) * state->buffered)) {
+            FBERROR("event_trace: Failed to write %u records, recording stopped.", state->buffered);
+            state->recording = false;
+        }
+
+        state->written += state->buffered;
+        state->buffered = 0;
+    }
+
+    void push_record(u16 code, record_kind kind, const event::context& data) {
+        if (state->buffered == max_buffered_records) {
+            flush();
+        }
+
+        trace_record& record = state->buffer[state->buffered++];
+        record.frame = (u32)state->frame;
+        record.code = code;
+        record.kind = kind;
+        record.reserved = 0;
+        record.time = platform::get_absolute_time() - state->start_time;
+        record.context = data;
+    }
+
+    void on_event(u16 code, b8 posted, const event::context& data) {
+        push_record(code, posted ? RECORD_POST : RECORD_SEND, data);
+    }
+
+    b8 begin_recording(const char* path) {
+        if (!state->file.open(path, filesystem::FILE_MODE_WRITE, true)) {
+            FBERROR("event_trace: Could not create %s.", path);
+            return false;
+        }
+
+        trace_header header = {trace_magic, trace_version};
+        u64 written = 0;
+        if (!state->file.write(&header, &written, sizeof(header))) {
+            FBERROR("event_trace: Could not write to %s.", path);
+            state->file.close();
+            return false;
+        }
+
+        state->buffer = (trace_record*)memory::fballocate(sizeof(trace_record) * max_buffered_records, memory::MEMORY_TAG_EVENT);
+        state->recording = true;
+        state->start_time = platform::get_absolute_time();
+
+        FBINFO("Recording events to %s.", path);
+        return true;
+    }
+
+    b8 begin_replay(const char* path) {
+        if (!state->file.open(path, filesystem::FILE_MODE_READ, true)) {
+            FBERROR("event_trace: Could not open %s.", path);
+            return false;
+        }
+
+        b8 read = state->file.read(&state->contents, &state->contents_size);
+        state->file.close();
+
+        const trace_header* header = (const trace_header*)state->contents;
+        if (!read || state->contents_size < sizeof(trace_header) || header->magic != trace_magic || header->version != trace_version) {
+            FBERROR("event_trace: %s is not a version %u event trace.", path, trace_version);
+            if (state->contents) {
+                memory::fbfree(state->contents, state->contents_size, memory::MEMORY_TAG_STRING);
+                state->contents = nullptr;
+            }
+            return false;
+        }
+
+        state->records = (trace_record*)(state->contents + sizeof(trace_header));
+        state->record_count = (state->contents_size - sizeof(trace_header)) / sizeof(trace_record);
+        state->last_frame = state->record_count > 0 ? state->records[state->record_count - 1].frame : 0;
+        state->replaying = true;
+        state->start_time = platform::get_absolute_time();
+
+        FBINFO("Replaying %llu records over %llu frames from %s.", state->record_count, state->last_frame + 1, path);
+        return true;
+    }
+
+    void replay(const trace_record& record) {
+        const event::context& data = record.context;
+
+        // Input goes through the input system, which keeps its state and sends or posts the event itself.
+        switch (record.code) {
+            case event::KEY_PRESSED:
+            case event::KEY_RELEASED:
+                input::process_key((input::keys)data.data.u16[0], record.code == event::KEY_PRESSED);
+                return;
+            case event::BUTTON_PRESSED:
+            case event::BUTTON_RELEASED:
+                input::process_button((input::buttons)data.data.u16[0], record.code == event::BUTTON_PRESSED);
+                return;
+            case event::MOUSE_MOVED:
+                input::process_mouse_move((i16)data.data.u16[0], (i16)data.data.u16[1]);
+                return;
+            case event::MOUSE_WHEEL:
+                input::process_mouse_wheel(data.data.i8[0]);
+                return;
+            default:
+                break;
+        }
+
+        if (record.kind == RECORD_POST) {
+            event::post(record.code, nullptr, data);
+        } else {
+            event::send(record.code, nullptr, data);
+        }
+    }
+}  // namespace
+
+b8 event_trace::initialize(u64& memory_requirement, void* memory, const application_config& config) {
+    memory_requirement = sizeof(system_state);
+    if (!memory) {
+        return true;
+    }
+
+    if (state) {
+        FBERROR("Event trace system was already initialized!");
+        return false;
+    }
+    state = (system_state*)memory;
+    memory::fbzero(state, sizeof(system_state));
+
+    if (config.event_replay_path) {
+        if (config.event_record_path) {
+            FBWARN("event_trace: Both recording and replaying were requested, only replaying.");
+        }
+        return begin_replay(config.event_replay_path);
+    }
+
+    if (config.event_record_path) {
+        return begin_recording(config.event_record_path);
+    }
+
+    return true;
+}
+
+void event_trace::terminate() {
+    if (!state) {
+        return;
+    }
+
+    if (state->buffer) {
+        event::set_trace_hook(nullptr);
+        flush();
+        state->file.close();
+        memory::fbfree(state->buffer, sizeof(trace_record) * max_buffered_records, memory::MEMORY_TAG_EVENT);
+        FBINFO("Recorded %llu records over %llu frames.", state->written, state->frame + 1);
+    }
+
+    if (state->contents) {
+        memory::fbfree(state->contents, state->contents_size, memory::MEMORY_TAG_STRING);
+    }
+
+    state = nullptr;
+}
+
+b8 event_trace::is_recording() {
+    return state && state->recording;
+}
+
+b8 event_trace::is_replaying() {
+    return state && state->replaying;
+}
+
+void event_trace::begin_capture(u64 frame) {
+    if (!is_recording()) {
+        return;
+    }
+
+    state->frame = frame;
+    event::set_trace_hook(on_event);
+}
+
+void event_trace::end_capture() {
+    if (state) {
+        event::set_trace_hook(nullptr);
+    }
+}
+
+b8 event_trace::replay_frame(u64 frame) {
+    if (!is_replaying()) {
+        return false;
+    }
+
+    while (state->next < state->record_count && state->records[state->next].frame <= frame) {
+        const trace_record& record = state->records[state->next++];
+        if (record.kind != RECORD_FRAME) {
+            replay(record);
+        }
+    }
+
+    if (frame > state->last_frame) {
+        f64 elapsed = platform::get_absolute_time() - state->start_time;
+        FBINFO("Replay finished: %llu frames in %.3f s, %.3f ms per frame.", frame, elapsed, elapsed * 1000.0 / (f64)(frame > 0 ? frame : 1));
+
+        state->replaying = false;
+        event::context data = {};
+        event::send(event::APPLICATION_QUIT, nullptr, data);
+        return false;
+    }
+
+    return true;
+}
+
+f64 event_trace::frame_timestep(u64 frame, f64 timestep) {
+    if (is_recording()) {
+        event::context data = {};
+        data.data.f64[0] = timestep;
+        state->frame = frame;
+        push_record(0, RECORD_FRAME, data);
+        return timestep;
+    }
+
+    if (is_replaying()) {
+        // The frame's events were delivered already, its timestep record is the last one before the cursor.
+        for (u64 i = state->next; i-- > 0 && state->records[i].frame == frame;) {
+            if (state->records[i].kind == RECORD_FRAME) {
+                return state->records[i].context.data.f64[0];
+            }
+        }
+    }
+
+    return timestep;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "defines.hpp"
+
+struct application_config;
+
+// NOTE: The recorder captures the events the platform produces each frame, sent or posted, along with the
+//       frame's timestep, into a binary file of 32 byte records. Replaying the file feeds the same events back on
+//       the same frames instead of pumping the platform, with input routed through the input system so its
+//       state matches too, and hands out the recorded timesteps. Events sent or posted by the application or its
+//       listeners are not recorded, they happen again on their own during the replay.
+
+namespace fabric::event_trace {
+    // Starts recording or replaying when the config names a file.
+    b8 initialize(u64& memory_requirement, void* memory, const application_config& config);
+    void terminate();
+
+    b8 is_recording();
+    b8 is_replaying();
+
+    // Recording: the events sent or posted between the two calls belong to the frame.
+    void begin_capture(u64 frame);
+    void end_capture();
+
+    // Replaying: delivers the frame's events. Sends APPLICATION_QUIT and returns false once the trace is over.
+    b8 replay_frame(u64 frame);
+
+    // Records the frame's timestep, or replaces it with the recorded one.
+    f64 frame_timestep(u64 frame, f64 timestep);
+}  // namespace fabric::event_trace
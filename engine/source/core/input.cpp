@@ -2,18 +2,19 @@
 #include "core/event.hpp"
 #include "core/logger.hpp"
 #include "core/memory.hpp"
+#include "platform/platform.hpp"
 
 using namespace fabric;
 
 namespace {
     struct keyboard {
-        b8 keys[input::keys::KEYS_MAX_COUNT];
+        input::key_state keys;
     };
 
     struct mouse {
         i16 x;
         i16 y;
-        b8 buttons[input::buttons::BUTTON_MAX_COUNT];
+        ftl::bitset<input::buttons::BUTTON_MAX_COUNT> buttons;
     };
 
     struct system_state {
@@ -21,9 +22,37 @@ namespace {
         keyboard keyboard_previous;
         mouse mouse_current;
         mouse mouse_previous;
+
+        // Ring of the frame's transitions, transition_count of them written since the last update.
+        input::transition transitions[input::max_frame_transitions];
+        u32 transition_count;
+        // Per frame, saturating.
+        u8 key_transition_counts[256];
+        u8 button_transition_counts[input::BUTTON_MAX_COUNT];
     };
 
     static system_state* state;
+
+    void push_transition(input::device source, u16 code, b8 pressed, u8& count) {
+        input::transition& t = state->transitions[state->transition_count++ & (input::max_frame_transitions - 1)];
+        t.time = platform::get_absolute_time();
+        t.code = code;
+        t.source = source;
+        t.pressed = pressed;
+
+        if (count < 255) {
+            count++;
+        }
+    }
+
+    // Transitions alternate, starting from the previous frame's state.
+    FBINLINE b8 pressed_within(u32 count, b8 was_down) {
+        return was_down ? count >= 2 : count >= 1;
+    }
+
+    FBINLINE b8 released_within(u32 count, b8 was_down) {
+        return was_down ? count >= 1 : count >= 2;
+    }
 }  // namespace
 
 b8 input::initialize(u64& memory_requirement, void* memory) {
@@ -50,14 +79,38 @@ void input::terminate() {
 
 void input::update(f64 timestep) {
     if (state) {
-        memory::fbcopy(&state->keyboard_previous, &state->keyboard_current, sizeof(keyboard));
-        memory::fbcopy(&state->mouse_previous, &state->mouse_current, sizeof(mouse));
+        state->keyboard_previous = state->keyboard_current;
+        state->mouse_previous = state->mouse_current;
+
+        state->transition_count = 0;
+        memory::fbzero(state->key_transition_counts, sizeof(state->key_transition_counts));
+        memory::fbzero(state->button_transition_counts, sizeof(state->button_transition_counts));
+    }
+}
+
+u32 input::get_transitions(transition* out_transitions, u32 max_count) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return 0;
     }
+
+    u32 end = state->transition_count;
+    u32 begin = end > max_frame_transitions ? end - max_frame_transitions : 0;
+    if (end - begin > max_count) {
+        begin = end - max_count;
+    }
+
+    for (u32 i = begin; i < end; i++) {
+        out_transitions[i - begin] = state->transitions[i & (max_frame_transitions - 1)];
+    }
+
+    return end - begin;
 }
 
 void input::process_key(keys key, b8 pressed) {
-    if (state->keyboard_current.keys[key] != pressed) {
-        state->keyboard_current.keys[key] = pressed;
+    if (state->keyboard_current.keys.test(key) != pressed) {
+        state->keyboard_current.keys.assign(key, pressed);
+        push_transition(DEVICE_KEYBOARD, key, pressed, state->key_transition_counts[key & 0xFF]);
 
         event::context context;
         context.data.u16[0] = key;
@@ -67,8 +120,9 @@ void input::process_key(keys key, b8 pressed) {
 }
 
 void input::process_button(buttons button, b8 pressed) {
-    if (state->mouse_current.buttons[button] != pressed) {
-        state->mouse_current.buttons[button] = pressed;
+    if (state->mouse_current.buttons.test(button) != pressed) {
+        state->mouse_current.buttons.assign(button, pressed);
+        push_transition(DEVICE_MOUSE, button, pressed, state->button_transition_counts[button]);
 
         event::context context;
         context.data.u16[0] = button;
@@ -86,7 +140,7 @@ void input::process_mouse_move(i16 x, i16 y) {
         context.data.u16[0] = x;
         context.data.u16[1] = y;
 
-        event::send(event::MOUSE_MOVED, nullptr, context);
+        event::post(event::MOUSE_MOVED, nullptr, context);
     }
 }
 
@@ -94,7 +148,7 @@ void input::process_mouse_wheel(i8 z_delta) {
     event::context context;
     context.data.u8[0] = z_delta;
 
-    event::send(event::MOUSE_WHEEL, nullptr, context);
+    event::post(event::MOUSE_WHEEL, nullptr, context);
 }
 
 b8 input::is_key_down(keys key) {
@@ -103,7 +157,7 @@ b8 input::is_key_down(keys key) {
         return false;
     }
 
-    return state->keyboard_current.keys[key] == true;
+    return state->keyboard_current.keys.test(key);
 }
 
 b8 input::is_key_up(keys key) {
@@ -112,7 +166,7 @@ b8 input::is_key_up(keys key) {
         return false;
     }
 
-    return state->keyboard_current.keys[key] == false;
+    return !state->keyboard_current.keys.test(key);
 }
 
 b8 input::was_key_down(keys key) {
@@ -121,7 +175,7 @@ b8 input::was_key_down(keys key) {
         return false;
     }
 
-    return state->keyboard_previous.keys[key] == true;
+    return state->keyboard_previous.keys.test(key);
 }
 
 b8 input::was_key_up(keys key) {
@@ -130,7 +184,75 @@ b8 input::was_key_up(keys key) {
         return false;
     }
 
-    return state->keyboard_previous.keys[key] == false;
+    return !state->keyboard_previous.keys.test(key);
+}
+
+b8 input::is_key_pressed(keys key) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return state->keyboard_current.keys.test(key) && !state->keyboard_previous.keys.test(key);
+}
+
+b8 input::is_key_released(keys key) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return !state->keyboard_current.keys.test(key) && state->keyboard_previous.keys.test(key);
+}
+
+const input::key_state& input::get_key_state() {
+    static const key_state empty;
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return empty;
+    }
+
+    return state->keyboard_current.keys;
+}
+
+b8 input::was_key_pressed_this_frame(keys key) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return pressed_within(state->key_transition_counts[key & 0xFF], state->keyboard_previous.keys.test(key));
+}
+
+b8 input::was_key_released_this_frame(keys key) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return released_within(state->key_transition_counts[key & 0xFF], state->keyboard_previous.keys.test(key));
+}
+
+u32 input::get_key_transition_count(keys key) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return 0;
+    }
+
+    return state->key_transition_counts[key & 0xFF];
+}
+
+void input::get_key_transitions(key_state& pressed, key_state& released) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        pressed.clear();
+        released.clear();
+        return;
+    }
+
+    key_state changed = state->keyboard_current.keys ^ state->keyboard_previous.keys;
+    pressed = changed & state->keyboard_current.keys;
+    released = changed & state->keyboard_previous.keys;
 }
 
 b8 input::is_button_down(buttons button) {
@@ -139,7 +261,7 @@ b8 input::is_button_down(buttons button) {
         return false;
     }
 
-    return state->mouse_current.buttons[button] == true;
+    return state->mouse_current.buttons.test(button);
 }
 
 b8 input::is_button_up(buttons button) {
@@ -148,7 +270,7 @@ b8 input::is_button_up(buttons button) {
         return false;
     }
 
-    return state->mouse_current.buttons[button] == false;
+    return !state->mouse_current.buttons.test(button);
 }
 
 b8 input::was_button_down(buttons button) {
@@ -157,7 +279,7 @@ b8 input::was_button_down(buttons button) {
         return false;
     }
 
-    return state->mouse_previous.buttons[button] == true;
+    return state->mouse_previous.buttons.test(button);
 }
 
 b8 input::was_button_up(buttons button) {
@@ -166,7 +288,34 @@ b8 input::was_button_up(buttons button) {
         return false;
     }
 
-    return state->mouse_previous.buttons[button] == false;
+    return !state->mouse_previous.buttons.test(button);
+}
+
+b8 input::was_button_pressed_this_frame(buttons button) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return pressed_within(state->button_transition_counts[button], state->mouse_previous.buttons.test(button));
+}
+
+b8 input::was_button_released_this_frame(buttons button) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return false;
+    }
+
+    return released_within(state->button_transition_counts[button], state->mouse_previous.buttons.test(button));
+}
+
+u32 input::get_button_transition_count(buttons button) {
+    if (!state) {
+        FBERROR("Trying to query for inputs before the input system was initialized.");
+        return 0;
+    }
+
+    return state->button_transition_counts[button];
 }
 
 void input::get_mouse_position(i32& x, i32& y) {
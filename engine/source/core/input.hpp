@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.hpp"
+#include "ftl/bitset.hpp"
 
 namespace fabric::input {
     enum buttons : u16 {
@@ -18,6 +19,7 @@ namespace fabric::input {
         DEFINE_KEY(TAB, 0x09),
         DEFINE_KEY(SHIFT, 0x10),
         DEFINE_KEY(CONTROL, 0x11),
+        DEFINE_KEY(ALT, 0x12),
 
         DEFINE_KEY(PAUSE, 0x13),
         DEFINE_KEY(CAPITAL, 0x14),
@@ -143,16 +145,55 @@ namespace fabric::input {
         KEYS_MAX_COUNT
     };
 
+    // One bit per key code, rounded up to a whole AVX2 register.
+    using key_state = ftl::bitset<256>;
+    STATIC_ASSERT(KEYS_MAX_COUNT <= 256, "Key codes must fit in input::key_state");
+
+    enum device : u8 {
+        DEVICE_KEYBOARD,
+        DEVICE_MOUSE
+    };
+
+    // A key or button going down or up.
+    struct transition {
+        // platform::get_absolute_time when the platform reported it.
+        f64 time;
+        // keys or buttons, depending on device.
+        u16 code;
+        device source;
+        b8 pressed;
+    };
+
+    // Transitions kept per frame. Older ones are overwritten when a frame has more, the counts stay exact.
+    static constexpr u32 max_frame_transitions = 256;
+
     b8 initialize(u64& memory_requirement, void* memory);
     void terminate();
 
+    // Ends the frame: the current state becomes the previous one and the transitions are cleared.
     void update(f64 timestep);
 
+    // The frame's transitions in the order they happened, so several presses between two frames aren't lost.
+    // Returns how many were written.
+    FBAPI u32 get_transitions(transition* out_transitions, u32 max_count);
+
     // Keyboard input
     FBAPI b8 is_key_down(keys key);
     FBAPI b8 is_key_up(keys key);
     FBAPI b8 was_key_down(keys key);
     FBAPI b8 was_key_up(keys key);
+    FBAPI b8 is_key_pressed(keys key);
+    FBAPI b8 is_key_released(keys key);
+
+    // Keys that went down/up since the previous frame. Use key_state::for_each_set to visit only those keys.
+    FBAPI void get_key_transitions(key_state& pressed, key_state& released);
+    // Every key at once. The platform only reports the sided modifiers, never KEY_SHIFT, KEY_CONTROL or KEY_ALT.
+    FBAPI const key_state& get_key_state();
+
+    // Also true for a key pressed and released again within the frame, which is_key_pressed misses.
+    FBAPI b8 was_key_pressed_this_frame(keys key);
+    FBAPI b8 was_key_released_this_frame(keys key);
+    FBAPI u32 get_key_transition_count(keys key);
 
     void process_key(keys key, b8 pressed);
 
@@ -162,6 +203,10 @@ namespace fabric::input {
     FBAPI b8 was_button_down(buttons button);
     FBAPI b8 was_button_up(buttons button);
 
+    FBAPI b8 was_button_pressed_this_frame(buttons button);
+    FBAPI b8 was_button_released_this_frame(buttons button);
+    FBAPI u32 get_button_transition_count(buttons button);
+
     // TODO: return vec2
     FBAPI void get_mouse_position(i32& x, i32& y);
     FBAPI void get_previous_mouse_position(i32& x, i32& y);
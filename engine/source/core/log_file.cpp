@@ -0,0 +1,253 @@
+#include "core/log_file.hpp"
+#include "core/memory.hpp"
+#include "ftl/atomic.hpp"
+#include "ftl/lz.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace fabric;
+
+namespace {
+    static constexpr u64 buffer_size = 64 * 1024;
+
+    // LZ4 frame with independent 1 MiB blocks and no checksums, the last byte is the descriptor's checksum.
+    static constexpr u8 frame_header[] = {0x04, 0x22, 0x4D, 0x18, 0x60, 0x60, 0x51};
+    static constexpr u64 frame_block_size = 1024 * 1024;
+    // Set on a block's size when it is stored uncompressed.
+    static constexpr u32 frame_block_raw = 0x80000000U;
+
+    void rotated_path(char* out, u64 capacity, const char* path, u32 index, b8 compressed) {
+        snprintf(out, capacity, compressed ? "%s.%u.lz4" : "%s.%u", path, index);
+    }
+}  // namespace
+
+logger::log_file::~log_file() {
+    destroy();
+}
+
+b8 logger::log_file::create(const log_file_config& file_config) {
+    if (strlen(file_config.path) >= sizeof(path) - 16) {
+        FBERROR("log_file::create: The path %s is too long.", file_config.path);
+        return false;
+    }
+
+    config = file_config;
+    strcpy(path, file_config.path);
+    config.path = path;
+
+    if (config.compress && config.max_rotated > 0) {
+        compress_input = (u8*)memory::fballocate(frame_block_size, memory::MEMORY_TAG_LOGGER);
+        compress_output = (u8*)memory::fballocate(ftl::lz_compress_bound(frame_block_size), memory::MEMORY_TAG_LOGGER);
+    }
+
+    // The previous session's log joins the rotated ones instead of being truncated, it may be all that's left of a crash.
+    if (config.max_rotated > 0 && filesystem::file::exists(path)) {
+        shift_files();
+    }
+
+    if (!file.open(path, filesystem::FILE_MODE_WRITE, true)) {
+        destroy();
+        return false;
+    }
+
+    file_size = 0;
+    opened_at = platform::get_absolute_time();
+
+    buffer = (char*)memory::fballocate(buffer_size, memory::MEMORY_TAG_LOGGER);
+    buffered = 0;
+
+    return true;
+}
+
+void logger::log_file::destroy() {
+    // Only the writer thread is left by now.
+    platform::thread_wait(compressor);
+
+    if (buffer) {
+        write_buffer();
+        file.close();
+        memory::fbfree(buffer, buffer_size, memory::MEMORY_TAG_LOGGER);
+        buffer = nullptr;
+    }
+
+    if (compress_input) {
+        memory::fbfree(compress_input, frame_block_size, memory::MEMORY_TAG_LOGGER);
+        memory::fbfree(compress_output, ftl::lz_compress_bound(frame_block_size), memory::MEMORY_TAG_LOGGER);
+        compress_input = nullptr;
+        compress_output = nullptr;
+    }
+}
+
+void logger::log_file::write(void* user_data, log_level level, const char* message, u64 length) {
+    log_file* f = (log_file*)user_data;
+    if (f->lock()) {
+        f->append(message, length);
+        f->unlock();
+    }
+}
+
+void logger::log_file::flush(void* user_data) {
+    log_file* f = (log_file*)user_data;
+    if (f->lock()) {
+        f->write_buffer();
+        f->unlock();
+    }
+}
+
+b8 logger::log_file::lock() {
+    // NOTE: Sinks run on the writer thread, but FATAL messages are written from the thread logging them once the
+    //       queue drained. Contention only happens then, so spinning is enough.
+    u64 id = platform::get_current_thread_id();
+    if (ftl::atomic_load(&owner, ftl::MEMORY_ORDER_RELAXED) == id) {
+        return false;
+    }
+
+    u64 expected = 0;
+    while (!ftl::atomic_compare_exchange(&owner, expected, id, ftl::MEMORY_ORDER_ACQUIRE, ftl::MEMORY_ORDER_RELAXED)) {
+        expected = 0;
+        ftl::cpu_pause();
+    }
+
+    return true;
+}
+
+void logger::log_file::unlock() {
+    ftl::atomic_store(&owner, (u64)0, ftl::MEMORY_ORDER_RELEASE);
+}
+
+void logger::log_file::append(const char* message, u64 length) {
+    if (!file.is_valid()) {
+        return;
+    }
+
+    f64 now = platform::get_absolute_time();
+    if (opened_at == 0.0) {
+        opened_at = now;
+    }
+
+    b8 too_large = config.max_size > 0 && file_size > 0 && file_size + length > config.max_size;
+    b8 too_old = config.max_age > 0 && opened_at > 0.0 && now - opened_at >= (f64)config.max_age;
+    if (too_large || too_old) {
+        rotate();
+        if (!file.is_valid()) {
+            return;
+        }
+    }
+
+    if (buffered + length > buffer_size) {
+        write_buffer();
+    }
+
+    if (length > buffer_size) {
+        u64 written = 0;
+        file.write(message, &written, length);
+    } else {
+        memcpy(buffer + buffered, message, length);
+        buffered += length;
+    }
+
+    file_size += length;
+}
+
+void logger::log_file::write_buffer() {
+    if (buffered == 0 || !file.is_valid()) {
+        return;
+    }
+
+    u64 written = 0;
+    file.write(buffer, &written, buffered);
+    buffered = 0;
+}
+
+void logger::log_file::rotate() {
+    write_buffer();
+    file.close();
+
+    if (config.max_rotated > 0) {
+        shift_files();
+    }
+
+    file.open(path, filesystem::FILE_MODE_WRITE, true);
+    file_size = 0;
+    opened_at = platform::get_absolute_time();
+}
+
+void logger::log_file::shift_files() {
+    // The previous file has to be compressed before the names move.
+    platform::thread_wait(compressor);
+
+    // Files stay uncompressed when compression is off or failed, so both names move along.
+    char from[sizeof(path) + 16];
+    char to[sizeof(path) + 16];
+    for (u32 compressed = 0; compressed < 2; compressed++) {
+        rotated_path(to, sizeof(to), path, config.max_rotated, compressed);
+        filesystem::remove(to);
+    }
+
+    for (u32 i = config.max_rotated - 1; i > 0; i--) {
+        for (u32 compressed = 0; compressed < 2; compressed++) {
+            rotated_path(from, sizeof(from), path, i, compressed);
+            rotated_path(to, sizeof(to), path, i + 1, compressed);
+            filesystem::rename(from, to);
+        }
+    }
+
+    rotated_path(to, sizeof(to), path, 1, false);
+    filesystem::rename(path, to);
+
+    if (config.compress) {
+        platform::thread_create(compress_main, this, compressor);
+    }
+}
+
+u32 logger::log_file::compress_main(void* params) {
+    log_file* f = (log_file*)params;
+
+    char source_path[sizeof(path) + 16];
+    char compressed_path[sizeof(path) + 16];
+    rotated_path(source_path, sizeof(source_path), f->path, 1, false);
+    rotated_path(compressed_path, sizeof(compressed_path), f->path, 1, true);
+
+    filesystem::file source;
+    filesystem::file compressed;
+    if (!source.open(source_path, filesystem::FILE_MODE_READ, true)) {
+        return 0;
+    }
+    if (!compressed.open(compressed_path, filesystem::FILE_MODE_WRITE, true)) {
+        source.close();
+        return 0;
+    }
+
+    u64 written = 0;
+    b8 success = compressed.write(frame_header, &written, sizeof(frame_header));
+
+    while (success) {
+        // Short reads report failure, the last block is the one that comes back smaller.
+        u64 size = 0;
+        source.read(f->compress_input, &size, frame_block_size);
+        if (size == 0) {
+            break;
+        }
+
+        u64 compressed_size = ftl::lz_compress(f->compress_input, size, f->compress_output, ftl::lz_compress_bound(frame_block_size));
+        const u8* block = f->compress_output;
+        u32 block_size = (u32)compressed_size;
+        if (compressed_size == 0 || compressed_size >= size) {
+            block = f->compress_input;
+            block_size = (u32)size | frame_block_raw;
+        }
+
+        success = compressed.write(&block_size, &written, sizeof(block_size)) && compressed.write(block, &written, block_size & ~frame_block_raw);
+    }
+
+    u32 end_mark = 0;
+    success = success && compressed.write(&end_mark, &written, sizeof(end_mark));
+
+    source.close();
+    compressed.close();
+
+    // Whichever copy is complete stays.
+    filesystem::remove(success ? source_path : compressed_path);
+    return 0;
+}
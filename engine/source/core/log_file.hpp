@@ -0,0 +1,69 @@
+#pragma once
+
+#include "defines.hpp"
+#include "core/logger.hpp"
+#include "platform/filesystem.hpp"
+#include "platform/platform.hpp"
+
+// NOTE: Log file sink. Lines are gathered in a 64 KiB buffer that is written out when it fills up and whenever the
+//       logger's writer runs out of lines, so bursts cost a single write and the file is complete once the queue
+//       is idle. When the file grows past its size or age limit, or already exists at startup, it is renamed to
+//       <path>.1 and older files move up one, up to max_rotated. Rotated files are then compressed on a background
+//       thread into LZ4 frames, <path>.1.lz4 and so on, which the lz4 command line tool opens. A file that failed
+//       to compress moves along uncompressed.
+
+namespace fabric::logger {
+    struct log_file_config {
+        const char* path;
+        // Bytes, 0 to never rotate by size.
+        u64 max_size;
+        // Seconds, 0 to never rotate by age.
+        u64 max_age;
+        // Rotated files kept, 0 to truncate the file instead.
+        u32 max_rotated;
+        b8 compress;
+    };
+
+    class log_file {
+       public:
+        log_file() = default;
+        ~log_file();
+
+        b8 create(const log_file_config& config);
+        void destroy();
+
+        // Sink callbacks for logger::add_sink, with the log_file as user data.
+        static void write(void* user_data, log_level level, const char* message, u64 length);
+        static void flush(void* user_data);
+
+       private:
+        b8 lock();
+        void unlock();
+
+        void append(const char* message, u64 length);
+        void write_buffer();
+        // Moves the file to <path>.1 and the older ones up, then compresses <path>.1 in the background.
+        void shift_files();
+        void rotate();
+
+        static u32 compress_main(void* params);
+
+       private:
+        log_file_config config = {};
+        char path[256] = {};
+        filesystem::file file;
+        u64 file_size = 0;
+        // 0 until the platform clock runs.
+        f64 opened_at = 0.0;
+
+        char* buffer = nullptr;
+        u64 buffered = 0;
+
+        // Thread writing to the file, lines logged while it holds the lock are dropped instead of deadlocking.
+        u64 owner = 0;
+
+        platform::thread compressor;
+        u8* compress_input = nullptr;
+        u8* compress_output = nullptr;
+    };
+}  // namespace fabric::logger
@@ -1,6 +1,9 @@
 #include "core/logger.hpp"
+#include "core/application.hpp"
 #include "core/asserts.hpp"
+#include "core/log_file.hpp"
 #include "core/memory.hpp"
+#include "ftl/mpsc_queue.hpp"
 #include "platform/platform.hpp"
 
 // TODO: Temporary
@@ -11,14 +14,359 @@
 using namespace fabric;
 
 namespace {
+    // Power of two.
+    static constexpr u32 max_queued_lines = 1024;
+    static constexpr u32 max_line_length = 240;
+    static constexpr u32 max_sinks = 8;
+    // How long a FATAL message waits for the queue to drain before it is written directly.
+    static constexpr u64 fatal_flush_timeout_ms = 250;
+    // The writer wakes up at least this often, in case a wake up signal was missed.
+    static constexpr u64 writer_idle_timeout_ms = 100;
+
+    // Formatted lines on the writer thread and on the direct paths.
+    static constexpr u32 max_formatted_length = 32000;
+
+    // Either formatted text in data, or with format set, the captured arguments: their kinds padded to 8 bytes,
+    // then the arguments as passed, then copies of the non-null string arguments in order. Text longer than an entry is
+    // split over consecutive entries, argument_count being the number of parts still following.
+    struct queued_line {
+        const char* format;
+        logger::log_level level;
+        u16 argument_count;
+        u16 length;
+        char data[max_line_length];
+    };
+
+    // Text per entry, leaving room for the terminator of single part lines.
+    static constexpr u32 max_part_length = max_line_length - 1;
+
+    STATIC_ASSERT(sizeof(queued_line) == 256, "Log queue entries are expected to be 256 bytes");
+
+    struct log_sink {
+        logger::log_sink_pfn write;
+        logger::log_flush_pfn flush;
+        void* user_data;
+    };
+
     struct system_state {
-        b8 initialized = false;  // TODO: Remove, just need something in here temporarily
+        ftl::mpsc_queue<queued_line, max_queued_lines> queue;
+
+        log_sink sinks[max_sinks];
+        u32 sink_count;
+        logger::log_file file;
+
+        b8 async;
+        logger::log_overflow_policy overflow_policy;
+        platform::thread writer;
+        u64 writer_id;
+        platform::semaphore wake;
+        // Shared with the writer thread.
+        u32 running;
+        u32 writer_sleeping;
+        // Lines written by the writer so far, compared against the queue's push count by flush.
+        u64 written;
+        // Lines dropped since the writer last reported it.
+        u64 dropped;
+
+        char formatted[max_formatted_length];
+        // Bytes of a split line gathered in formatted so far.
+        u32 assembled;
     };
 
     static system_state* state;
+
+    static const char* level_string[logger::LOG_LEVEL_COUNT] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: "};
+
+    void console_sink(void* user_data, logger::log_level level, const char* message, u64 length) {
+        if (level < logger::LOG_LEVEL_WARN) {
+            platform::console_write_error(message, level);
+        } else {
+            platform::console_write(message, level);
+        }
+    }
+
+    void write_to_sinks(logger::log_level level, const char* message, u64 length) {
+        // NOTE: Even if the logger system fails to initialize for some reason, this should still happen on the debug console.
+        if (!state || state->sink_count == 0) {
+            console_sink(nullptr, level, message, length);
+            return;
+        }
+
+        for (u32 i = 0; i < state->sink_count; i++) {
+            state->sinks[i].write(state->sinks[i].user_data, level, message, length);
+        }
+    }
+
+    void flush_sinks() {
+        if (!state) {
+            return;
+        }
+
+        for (u32 i = 0; i < state->sink_count; i++) {
+            if (state->sinks[i].flush) {
+                state->sinks[i].flush(state->sinks[i].user_data);
+            }
+        }
+    }
+
+    void wake_writer() {
+        ftl::atomic_fence();
+        if (ftl::atomic_load(&state->writer_sleeping, ftl::MEMORY_ORDER_RELAXED)) {
+            platform::semaphore_signal(state->wake);
+        }
+    }
+
+    // Appends a single conversion, spec being its text without length modifiers, through snprintf.
+    u32 format_argument(char* out, u32 capacity, const char* spec, char conversion, logger::internal::log_argument_kind kind, u64 argument, const char* string) {
+        using namespace logger::internal;
+
+        i64 value_signed = __builtin_bit_cast(i64, argument);
+        f64 value_float = __builtin_bit_cast(f64, argument);
+        i32 written = 0;
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                written = snprintf(out, capacity, spec, kind == LOG_ARGUMENT_FLOAT ? (i64)value_float : value_signed);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                written = snprintf(out, capacity, spec, kind == LOG_ARGUMENT_FLOAT ? (u64)value_float : argument);
+                break;
+            case 'c':
+                written = snprintf(out, capacity, spec, (i32)value_signed);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                written = snprintf(out, capacity, spec, kind == LOG_ARGUMENT_FLOAT ? value_float : kind == LOG_ARGUMENT_SIGNED ? (f64)value_signed : (f64)argument);
+                break;
+            case 's': {
+                written = snprintf(out, capacity, spec, kind != LOG_ARGUMENT_STRING ? "(?)" : string ? string : "(null)");
+                break;
+            }
+            case 'p':
+                written = snprintf(out, capacity, spec, (void*)argument);
+                break;
+            default:
+                break;
+        }
+
+        return written < 0 ? 0 : ((u32)written < capacity ? (u32)written : capacity - 1);
+    }
+
+    // Formats the line with its level prefix and newline, like log_output. strings holds the text of each string
+    // argument, which is the argument itself unless it was copied into a queue entry.
+    u32 format_line(char* out, u32 capacity, logger::log_level level, const char* format, const logger::internal::log_argument_kind* kinds, const u64* arguments, u32 argument_count, const char* const* strings) {
+        // Leaves room for the newline.
+        capacity -= 1;
+        u32 length = (u32)strlen(level_string[level]);
+        memcpy(out, level_string[level], length);
+
+        u32 next = 0;
+        const char* c = format;
+        while (*c && length < capacity - 1) {
+            if (*c != '%') {
+                out[length++] = *c++;
+                continue;
+            }
+
+            if (c[1] == '%') {
+                out[length++] = '%';
+                c += 2;
+                continue;
+            }
+
+            // Rebuilds the conversion with 64 bit length modifiers, * widths and precisions replaced by their values.
+            char spec[64];
+            u32 spec_length = 0;
+            spec[spec_length++] = *c++;
+            while (*c && spec_length < sizeof(spec) - 24) {
+                if (*c == '*') {
+                    i64 value = next < argument_count ? __builtin_bit_cast(i64, arguments[next++]) : 0;
+                    spec_length += snprintf(spec + spec_length, sizeof(spec) - spec_length, "%d", (i32)value);
+                    c++;
+                } else if (strchr("-+ #0123456789.", *c)) {
+                    spec[spec_length++] = *c++;
+                } else if (strchr("hljztL", *c)) {
+                    c++;
+                } else {
+                    break;
+                }
+            }
+
+            char conversion = *c;
+            if (!conversion) {
+                break;
+            }
+            c++;
+
+            if (strchr("diuxXo", conversion)) {
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = 'l';
+            }
+            spec[spec_length++] = conversion;
+            spec[spec_length] = '\0';
+
+            if (next < argument_count) {
+                length += format_argument(out + length, capacity - length, spec, conversion, kinds[next], arguments[next], strings[next]);
+                next++;
+            }
+        }
+
+        out[length++] = '\n';
+        out[length] = '\0';
+        return length;
+    }
+
+    u32 writer_main(void* params) {
+        while (true) {
+            queued_line* line = state->queue.front();
+            if (line) {
+                if (line->format) {
+                    const logger::internal::log_argument_kind* kinds = (const logger::internal::log_argument_kind*)line->data;
+                    const u64* arguments = (const u64*)(line->data + ((line->argument_count + 7) & ~7));
+
+                    const char* strings[logger::internal::max_log_arguments];
+                    const char* copy = (const char*)(arguments + line->argument_count);
+                    for (u32 i = 0; i < line->argument_count; i++) {
+                        strings[i] = nullptr;
+                        if (kinds[i] == logger::internal::LOG_ARGUMENT_STRING && arguments[i]) {
+                            strings[i] = copy;
+                            copy += strlen(copy) + 1;
+                        }
+                    }
+
+                    u32 length = format_line(state->formatted, max_formatted_length, line->level, line->format, kinds, arguments, line->argument_count, strings);
+                    write_to_sinks(line->level, state->formatted, length);
+                } else if (line->argument_count > 0 || state->assembled > 0) {
+                    u32 length = line->length < max_formatted_length - 1 - state->assembled ? line->length : max_formatted_length - 1 - state->assembled;
+                    memcpy(state->formatted + state->assembled, line->data, length);
+                    state->assembled += length;
+                    if (line->argument_count == 0) {
+                        state->formatted[state->assembled] = '\0';
+                        write_to_sinks(line->level, state->formatted, state->assembled);
+                        state->assembled = 0;
+                    }
+                } else {
+                    write_to_sinks(line->level, line->data, line->length);
+                }
+                state->queue.pop();
+                ftl::atomic_store(&state->written, state->written + 1, ftl::MEMORY_ORDER_RELEASE);
+                continue;
+            }
+
+            u64 dropped = ftl::atomic_exchange(&state->dropped, (u64)0);
+            if (dropped > 0) {
+                char message[128];
+                i32 length = snprintf(message, sizeof(message), "%s%llu log messages were dropped, the log queue was full.\n", level_string[logger::LOG_LEVEL_WARN], dropped);
+                write_to_sinks(logger::LOG_LEVEL_WARN, message, (u64)length);
+            }
+
+            flush_sinks();
+
+            if (!ftl::atomic_load(&state->running)) {
+                break;
+            }
+
+            // Producers check the flag after publishing, the fences make sure one of the two sides sees the other.
+            ftl::atomic_store(&state->writer_sleeping, (u32)1, ftl::MEMORY_ORDER_RELAXED);
+            ftl::atomic_fence();
+            if (!state->queue.front() && ftl::atomic_load(&state->running)) {
+                platform::semaphore_wait(state->wake, writer_idle_timeout_ms);
+            }
+            ftl::atomic_store(&state->writer_sleeping, (u32)0, ftl::MEMORY_ORDER_RELAXED);
+        }
+
+        return 0;
+    }
+
+    b8 start_writer() {
+        if (!platform::semaphore_create(0, state->wake)) {
+            return false;
+        }
+
+        ftl::atomic_store(&state->running, (u32)1);
+        if (!platform::thread_create(writer_main, nullptr, state->writer)) {
+            platform::semaphore_destroy(state->wake);
+            return false;
+        }
+
+        state->writer_id = state->writer.id;
+        state->async = true;
+        return true;
+    }
+
+    void stop_writer() {
+        ftl::atomic_store(&state->running, (u32)0);
+        platform::semaphore_signal(state->wake);
+        platform::thread_wait(state->writer);
+        platform::semaphore_destroy(state->wake);
+        state->writer_id = 0;
+        state->async = false;
+    }
+
+    // Calls fill(queued_line&, u32 part) on count consecutive entries.
+    template <typename F>
+    void enqueue(u32 count, F fill) {
+        while (!state->queue.push_span_with(count, fill)) {
+            if (state->overflow_policy == logger::LOG_OVERFLOW_DROP) {
+                ftl::atomic_fetch_add(&state->dropped, (u64)1);
+                return;
+            }
+
+            wake_writer();
+            platform::sleep(0);
+        }
+
+        wake_writer();
+    }
+
+    b8 is_async() {
+        // The writer thread logs directly so it never waits on itself.
+        return state && state->async && platform::get_current_thread_id() != state->writer_id;
+    }
+
+    void output(logger::log_level level, const char* message, u32 length) {
+        b8 async = is_async();
+
+        if (async && level != logger::LOG_LEVEL_FATAL) {
+            u32 parts = (length + max_part_length - 1) / max_part_length;
+            enqueue(parts, [&](queued_line& line, u32 part) {
+                u32 offset = part * max_part_length;
+                u32 part_length = length - offset < max_part_length ? length - offset : max_part_length;
+                line.format = nullptr;
+                line.level = level;
+                line.argument_count = (u16)(parts - 1 - part);
+                line.length = (u16)part_length;
+                memcpy(line.data, message + offset, part_length);
+                line.data[part_length] = '\0';
+            });
+            return;
+        }
+
+        // FATAL messages go out directly once the queue drained, or out of order if the writer is stuck: better
+        // than lost.
+        if (async) {
+            logger::flush(fatal_flush_timeout_ms);
+        }
+
+        write_to_sinks(level, message, (u64)length);
+
+        // Without the writer nothing else flushes, and FATAL messages have to reach the file before the crash.
+        if (!async || level == logger::LOG_LEVEL_FATAL) {
+            flush_sinks();
+        }
+    }
 }  // namespace
 
-b8 logger::initialize(u64& memory_requirement, void* memory) {
+b8 logger::initialize(u64& memory_requirement, void* memory, const application_config& config) {
     memory_requirement = sizeof(system_state);
     if(!memory) {
         return true;
@@ -31,11 +379,24 @@ b8 logger::initialize(u64& memory_requirement, void* memory) {
     state = (system_state*)memory;
     memory::fbzero(state, sizeof(system_state));
 
-    // TODO: Create log file
+    state->queue.reset();
+    state->overflow_policy = LOG_OVERFLOW_DROP;
+    add_sink(console_sink, nullptr);
+
+    if (config.log_file_path) {
+        log_file_config file_config = {config.log_file_path, config.log_file_max_size, config.log_file_max_age, config.log_file_max_rotated, config.log_file_compress};
+        if (state->file.create(file_config)) {
+            add_sink(log_file::write, &state->file, log_file::flush);
+        } else {
+            FBWARN("Could not create the log file %s, logging to the console only.", config.log_file_path);
+        }
+    }
 
     // NOTE: Eventually the logger will run on a different (fail-safe) process. This process will be launched from here.
 
-    state->initialized = true;
+    if (!start_writer()) {
+        FBWARN("Could not start the log writer thread, logging synchronously.");
+    }
 
     FBINFO("Logger system initialized.");
 
@@ -43,11 +404,16 @@ b8 logger::initialize(u64& memory_requirement, void* memory) {
 }
 
 void logger::terminate() {
-    // TODO: Cleanup logging/write queued entries.
+    if (state && state->async) {
+        stop_writer();
+    }
+
+    if (state) {
+        state->file.destroy();
+    }
 
     // NOTE: Eventually the logger will run on a different (fail-safe) process. This process will be shutdown from here.
     state = nullptr;
-    
 }
 
 void logger::report_assertion_failure(const char* expression, const char* message, const char* file, i32 line) {
@@ -55,26 +421,128 @@ void logger::report_assertion_failure(const char* expression, const char* messag
 }
 
 void logger::log_output(logger::log_level level, const char* message, ...) {
-    // NOTE: Even if the logger system fails to initialize for some reason, this should still happen on the debug console.
-    static const char* level_string[logger::LOG_LEVEL_COUNT] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: "};
-
-    b8 is_error = level < logger::LOG_LEVEL_WARN;
-
     constexpr i32 message_length = 32000;
-    char out_message[message_length];
-    memset(out_message, 0, sizeof(out_message));
+    char final_message[message_length];
+
+    i32 prefix_length = (i32)strlen(level_string[level]);
+    memcpy(final_message, level_string[level], prefix_length);
 
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    vsnprintf(out_message, message_length, message, arg_ptr);
+    i32 length = vsnprintf(final_message + prefix_length, message_length - prefix_length - 1, message, arg_ptr);
     va_end(arg_ptr);
 
-    char final_message[message_length];
-    sprintf(final_message, "%s%s\n", level_string[level], out_message);
+    length = prefix_length + (length < 0 ? 0 : (length < message_length - prefix_length - 1 ? length : message_length - prefix_length - 2));
+    final_message[length++] = '\n';
+    final_message[length] = '\0';
+
+    output(level, final_message, (u32)length);
+}
+
+void logger::internal::log_captured(log_level level, const char* format, const log_argument_kind* kinds, const u64* arguments, u32 argument_count) {
+    u32 kinds_size = (argument_count + 7) & ~7;
+    u32 size = kinds_size + argument_count * sizeof(u64);
+    u64 string_lengths[max_log_arguments];
+    for (u32 i = 0; i < argument_count; i++) {
+        if (kinds[i] == LOG_ARGUMENT_STRING && arguments[i]) {
+            string_lengths[i] = strlen((const char*)arguments[i]) + 1;
+            size += (u32)string_lengths[i];
+        }
+    }
+
+    if (!is_async() || level == LOG_LEVEL_FATAL || size > max_line_length) {
+        const char* strings[max_log_arguments];
+        for (u32 i = 0; i < argument_count; i++) {
+            strings[i] = kinds[i] == LOG_ARGUMENT_STRING ? (const char*)arguments[i] : nullptr;
+        }
+
+        char line[max_formatted_length];
+        u32 length = format_line(line, max_formatted_length, level, format, kinds, arguments, argument_count, strings);
+        output(level, line, length);
+        return;
+    }
+
+    enqueue(1, [&](queued_line& line, u32 part) {
+        line.format = format;
+        line.level = level;
+        line.argument_count = (u16)argument_count;
+        line.length = (u16)size;
+
+        memcpy(line.data, kinds, argument_count);
+        memcpy(line.data + kinds_size, arguments, argument_count * sizeof(u64));
+        u32 offset = kinds_size + argument_count * sizeof(u64);
+        for (u32 i = 0; i < argument_count; i++) {
+            if (kinds[i] == LOG_ARGUMENT_STRING && arguments[i]) {
+                memcpy(line.data + offset, (const char*)arguments[i], string_lengths[i]);
+                offset += (u32)string_lengths[i];
+            }
+        }
+    });
+}
+
+void logger::set_async(b8 enabled) {
+    if (!state || state->async == enabled) {
+        return;
+    }
 
-    if (is_error) {
-        platform::console_write_error(final_message, level);
+    if (enabled) {
+        start_writer();
     } else {
-        platform::console_write(final_message, level);
+        stop_writer();
     }
-}
\ No newline at end of file
+}
+
+void logger::set_overflow_policy(log_overflow_policy policy) {
+    if (state) {
+        state->overflow_policy = policy;
+    }
+}
+
+b8 logger::add_sink(log_sink_pfn sink, void* user_data, log_flush_pfn sink_flush) {
+    if (!state) {
+        return false;
+    }
+
+    if (state->sink_count == max_sinks) {
+        FBERROR("logger::add_sink: Only %u sinks are supported.", max_sinks);
+        return false;
+    }
+
+    flush(fatal_flush_timeout_ms);
+    state->sinks[state->sink_count++] = {sink, sink_flush, user_data};
+    return true;
+}
+
+void logger::remove_sink(log_sink_pfn sink, void* user_data) {
+    if (!state) {
+        return;
+    }
+
+    flush(fatal_flush_timeout_ms);
+    for (u32 i = 0; i < state->sink_count; i++) {
+        if (state->sinks[i].write == sink && state->sinks[i].user_data == user_data) {
+            state->sinks[i] = state->sinks[--state->sink_count];
+            return;
+        }
+    }
+}
+
+b8 logger::flush(u64 timeout_ms) {
+    if (!state || !state->async || platform::get_current_thread_id() == state->writer_id) {
+        return true;
+    }
+
+    u64 target = state->queue.get_push_count();
+    f64 deadline = platform::get_absolute_time() + (f64)timeout_ms * 0.001;
+
+    while (ftl::atomic_load(&state->written, ftl::MEMORY_ORDER_ACQUIRE) < target) {
+        if (platform::get_absolute_time() > deadline) {
+            return false;
+        }
+
+        wake_writer();
+        platform::sleep(0);
+    }
+
+    return true;
+}
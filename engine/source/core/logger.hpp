@@ -2,6 +2,8 @@
 
 #include "defines.hpp"
 
+struct application_config;
+
 #define LOG_WARN_ENABLED 1
 #define LOG_INFO_ENABLED 1
 #define LOG_DEBUG_ENABLED 1
@@ -10,6 +12,9 @@
 #define LOG_DEBUG_ENABLED 0
 #endif
 
+// Capture arguments and format on the writer thread, set to 0 to format on the calling thread instead.
+#define LOG_DEFERRED_ENABLED 1
+
 namespace fabric::logger {
     enum log_level {
         LOG_LEVEL_FATAL = 0,
@@ -20,29 +25,150 @@ namespace fabric::logger {
         LOG_LEVEL_COUNT
     };
 
-    b8 initialize(u64& memory_requirement, void* memory);
+    // What a thread logging into a full queue does.
+    enum log_overflow_policy : u8 {
+        // The message is dropped and counted, the writer reports how many were lost.
+        LOG_OVERFLOW_DROP = 0,
+        // The thread waits for the writer to make room.
+        LOG_OVERFLOW_BLOCK
+    };
+
+    // Receives every formatted line, newline included, on the writer thread while logging is asynchronous.
+    typedef void (*log_sink_pfn)(void* user_data, log_level level, const char* message, u64 length);
+    // Called when the writer runs out of lines and after FATAL messages, for sinks that buffer.
+    typedef void (*log_flush_pfn)(void* user_data);
+
+    // NOTE: Once initialized, the logger formats on the calling thread and queues the line for a background
+    //       writer thread that hands it to the sinks, the console one by default. FATAL messages and assertion
+    //       failures wait a bounded time for the queue to drain, then are written directly if it didn't.
+    //       Messages too long for a queue entry take several consecutive ones.
+
+    // Opens the log file sink when the config names a file.
+    b8 initialize(u64& memory_requirement, void* memory, const application_config& config);
     void terminate();
 
     FBAPI void log_output(fabric::logger::log_level level, const char* message, ...);
+
+    // Asynchronous by default. Turning it off drains the queue and stops the writer thread.
+    FBAPI void set_async(b8 enabled);
+    FBAPI void set_overflow_policy(log_overflow_policy policy);
+    // Sinks are meant to be set up at startup, not while other threads are logging.
+    FBAPI b8 add_sink(log_sink_pfn sink, void* user_data, log_flush_pfn sink_flush = nullptr);
+    FBAPI void remove_sink(log_sink_pfn sink, void* user_data);
+    // Waits until everything logged before the call was written, at most timeout_ms. Returns false on timeout.
+    FBAPI b8 flush(u64 timeout_ms);
 }  // namespace fabric::logger
 
-#define FBFATAL(message, ...) fabric::logger::log_output(fabric::logger::LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
-#define FBERROR(message, ...) fabric::logger::log_output(fabric::logger::LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
+// NOTE: Deferred logging stores the address of the format literal and the raw arguments, 8 bytes each, in the
+//       log queue. Strings are copied. The writer thread does the formatting, so a log call costs a copy and a
+//       push. Arguments must be integers, enums, floating point numbers, strings or pointers, which is checked
+//       when the call is compiled, and the format string is checked against them like printf's.
+namespace fabric::logger::internal {
+    static constexpr u32 max_log_arguments = 16;
+
+    enum log_argument_kind : u8 {
+        LOG_ARGUMENT_SIGNED = 0,
+        LOG_ARGUMENT_UNSIGNED,
+        LOG_ARGUMENT_FLOAT,
+        LOG_ARGUMENT_STRING,
+        LOG_ARGUMENT_POINTER
+    };
+
+    template <typename T, b8 = __is_enum(T)>
+    struct log_argument {
+        STATIC_ASSERT(sizeof(T) == 0, "Log arguments must be integers, enums, floating point numbers, strings or pointers");
+    };
+
+    template <typename T>
+    struct log_argument<T, true> : log_argument<__underlying_type(T)> {
+        static constexpr u64 pack(T value) { return log_argument<__underlying_type(T)>::pack((__underlying_type(T))value); }
+    };
+
+    template <typename T>
+    struct log_argument<T*, false> {
+        static constexpr log_argument_kind kind = LOG_ARGUMENT_POINTER;
+        static u64 pack(const T* value) { return (u64)value; }
+    };
+
+    template <>
+    struct log_argument<const char*, false> {
+        static constexpr log_argument_kind kind = LOG_ARGUMENT_STRING;
+        static u64 pack(const char* value) { return (u64)value; }
+    };
+
+    template <>
+    struct log_argument<char*, false> : log_argument<const char*, false> {};
+
+#define FBLOG_ARGUMENT(type, argument_kind, storage)                                      \
+    template <>                                                                          \
+    struct log_argument<type, false> {                                                   \
+        static constexpr log_argument_kind kind = argument_kind;                         \
+        static constexpr u64 pack(type value) { return __builtin_bit_cast(u64, (storage)value); } \
+    };
+
+    FBLOG_ARGUMENT(b8, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(char, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(i8, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(i16, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(i32, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(long, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(i64, LOG_ARGUMENT_SIGNED, i64)
+    FBLOG_ARGUMENT(u8, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(u16, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(u32, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(unsigned long, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(u64, LOG_ARGUMENT_UNSIGNED, u64)
+    FBLOG_ARGUMENT(f32, LOG_ARGUMENT_FLOAT, f64)
+    FBLOG_ARGUMENT(f64, LOG_ARGUMENT_FLOAT, f64)
+#undef FBLOG_ARGUMENT
+
+    // format must outlive the log queue, the macros only accept string literals.
+    FBAPI void log_captured(log_level level, const char* format, const log_argument_kind* kinds, const u64* arguments, u32 argument_count);
+
+    template <typename... Args>
+    FBINLINE void log_deferred(log_level level, const char* format, Args... args) {
+        STATIC_ASSERT(sizeof...(Args) <= max_log_arguments, "Too many log arguments");
+        static constexpr log_argument_kind kinds[sizeof...(Args) + 1] = {log_argument<Args>::kind..., LOG_ARGUMENT_SIGNED};
+        const u64 arguments[sizeof...(Args) + 1] = {log_argument<Args>::pack(args)..., 0};
+        log_captured(level, format, kinds, arguments, sizeof...(Args));
+    }
+
+    // Never called, only there for the compiler to check format strings against their arguments.
+#if defined(__GNUC__)
+    __attribute__((format(printf, 1, 2)))
+#endif
+    inline void check_format(const char* format, ...) {}
+}  // namespace fabric::logger::internal
+
+#if LOG_DEFERRED_ENABLED == 1
+#define FBLOG(level, message, ...)                                                         \
+    do {                                                                                   \
+        if (false) {                                                                       \
+            fabric::logger::internal::check_format(message, ##__VA_ARGS__);                \
+        }                                                                                  \
+        fabric::logger::internal::log_deferred(level, "" message, ##__VA_ARGS__);          \
+    } while (0)
+#else
+#define FBLOG(level, message, ...) fabric::logger::log_output(level, message, ##__VA_ARGS__)
+#endif
+
+#define FBFATAL(message, ...) FBLOG(fabric::logger::LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
+#define FBERROR(message, ...) FBLOG(fabric::logger::LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
 
 #if LOG_WARN_ENABLED == 1
-#define FBWARN(message, ...) fabric::logger::log_output(fabric::logger::LOG_LEVEL_WARN, message, ##__VA_ARGS__);
+#define FBWARN(message, ...) FBLOG(fabric::logger::LOG_LEVEL_WARN, message, ##__VA_ARGS__);
 #else
 #define FBWARN(message, ...)
 #endif
 
 #if LOG_INFO_ENABLED == 1
-#define FBINFO(message, ...) fabric::logger::log_output(fabric::logger::LOG_LEVEL_INFO, message, ##__VA_ARGS__);
+#define FBINFO(message, ...) FBLOG(fabric::logger::LOG_LEVEL_INFO, message, ##__VA_ARGS__);
 #else
 #define FBINFO(message, ...)
 #endif
 
 #if LOG_DEBUG_ENABLED == 1
-#define FBDEBUG(message, ...) fabric::logger::log_output(fabric::logger::LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
+#define FBDEBUG(message, ...) FBLOG(fabric::logger::LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
 #else
 #define FBDEBUG(message, ...)
 #endif
@@ -30,7 +30,10 @@ namespace {
         "MAT_INST   ",
         "RENDERER   ",
         "SCENE      ",
-        "COMPONENT  "};
+        "COMPONENT  ",
+        "SPATIAL    ",
+        "EVENT      ",
+        "LOGGER     "};
 
     static system_state* state;
 }  // namespace
@@ -133,7 +136,7 @@ void memory::log_memory_usage() {
         offset += length;
     }
 
-    FBINFO(buffer);
+    FBINFO("%s", buffer);
 }
 
 u64 memory::get_memory_allocation_count() {
@@ -19,6 +19,9 @@ namespace fabric::memory {
         MEMORY_TAG_RENDERER,
         MEMORY_TAG_SCENE,
         MEMORY_TAG_COMPONENT,
+        MEMORY_TAG_SPATIAL,
+        MEMORY_TAG_EVENT,
+        MEMORY_TAG_LOGGER,
         MEMORY_TAG_COUNT
     };
 
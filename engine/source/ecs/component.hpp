@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.hpp"
+
+namespace fabric::ecs {
+    // Upper bound on the component types a world can register, sized for the signature bitsets.
+    static constexpr u32 max_components = 128;
+
+    namespace internal {
+        // FNV-1a of the compiler's name for type_hash<T>, which contains T. Unlike a static counter this gives
+        // every module the same id for the same type, DLL boundaries included.
+        template <typename T>
+        constexpr u64 type_hash() {
+            const char* name = __PRETTY_FUNCTION__;
+
+            u64 hash = 0xCBF29CE484222325ull;
+            for (u32 i = 0; name[i] != '\0'; i++) {
+                hash ^= (u8)name[i];
+                hash *= 0x100000001B3ull;
+            }
+            return hash;
+        }
+
+        template <typename T>
+        struct bare {
+            using type = T;
+        };
+
+        template <typename T>
+        struct bare<const T> {
+            using type = T;
+        };
+    }  // namespace internal
+
+    // Components are plain data: they are moved between chunks with memcpy and never constructed or destroyed.
+    template <typename T>
+    struct component {
+        using type = typename internal::bare<T>::type;
+
+        STATIC_ASSERT(__is_trivially_copyable(type), "Components must be trivially copyable");
+        STATIC_ASSERT(sizeof(type) <= 1024, "Components larger than 1KiB belong in a separate allocation");
+        STATIC_ASSERT(alignof(type) <= 64, "Component arrays are only aligned to 64 bytes");
+
+        static constexpr u64 hash = internal::type_hash<type>();
+        static constexpr u32 size = sizeof(type);
+        static constexpr u32 alignment = alignof(type);
+    };
+}  // namespace fabric::ecs
@@ -0,0 +1,548 @@
+#include "ecs/world.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+#include "ftl/atomic.hpp"
+#include "platform/platform.hpp"
+
+using namespace fabric;
+using namespace fabric::ecs;
+
+namespace {
+    static constexpr u32 cache_line = 64;
+    static constexpr u32 component_slot_count = max_components * 2;
+    static constexpr u32 initial_archetype_capacity = 16;
+    static constexpr u32 initial_record_capacity = 1024;
+    static constexpr u32 max_thread_count = 64;
+    // Idle workers wake up this often to see whether the world is being destroyed.
+    static constexpr u64 worker_idle_timeout_ms = 100;
+
+    FBINLINE u32 align_up(u32 value, u32 alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Grows a memory::fballocate'd array to hold at least required elements.
+    template <typename T>
+    void grow(T*& array, u32& capacity, u32 required, u32 initial, u32 used) {
+        if (required <= capacity) {
+            return;
+        }
+
+        u32 new_capacity = capacity ? capacity : initial;
+        while (new_capacity < required) {
+            new_capacity *= 2;
+        }
+
+        T* grown = (T*)memory::fballocate(sizeof(T) * new_capacity, memory::MEMORY_TAG_COMPONENT);
+        if (array) {
+            memory::fbcopy(grown, array, sizeof(T) * used);
+            memory::fbfree(array, sizeof(T) * capacity, memory::MEMORY_TAG_COMPONENT);
+        }
+
+        array = grown;
+        capacity = new_capacity;
+    }
+
+    struct parallel_run {
+        internal::task_pfn task;
+        void* context;
+        u32 task_count;
+        u32 next_task;
+    };
+
+    void run_tasks(parallel_run& run) {
+        for (;;) {
+            u32 index = ftl::atomic_fetch_add(&run.next_task, 1u, ftl::MEMORY_ORDER_RELAXED);
+            if (index >= run.task_count) {
+                break;
+            }
+            run.task(run.context, index);
+        }
+    }
+}  // namespace
+
+// NOTE: The workers sleep on start between parallel queries. A query publishes its tasks in run, signals start
+//       once per worker it wants and works through the tasks itself. Every worker that woke up signals done when
+//       the counter ran out, so once the query collected all of them nobody touches run anymore.
+struct internal::worker_pool {
+    platform::thread threads[max_thread_count];
+    u32 thread_count;
+    platform::semaphore start;
+    platform::semaphore done;
+    parallel_run run;
+    u32 stopping;
+};
+
+namespace {
+    u32 pool_worker(void* params) {
+        internal::worker_pool& pool = *(internal::worker_pool*)params;
+
+        for (;;) {
+            if (!platform::semaphore_wait(pool.start, worker_idle_timeout_ms)) {
+                if (ftl::atomic_load(&pool.stopping)) {
+                    break;
+                }
+                continue;
+            }
+
+            if (ftl::atomic_load(&pool.stopping)) {
+                break;
+            }
+
+            run_tasks(pool.run);
+            platform::semaphore_signal(pool.done);
+        }
+
+        return 0;
+    }
+
+    // nullptr when not even the semaphores could be created, parallel queries then run on the calling thread.
+    internal::worker_pool* start_workers() {
+        internal::worker_pool* pool = (internal::worker_pool*)memory::fballocate(sizeof(internal::worker_pool), memory::MEMORY_TAG_JOB);
+        if (!platform::semaphore_create(0, pool->start)) {
+            memory::fbfree(pool, sizeof(internal::worker_pool), memory::MEMORY_TAG_JOB);
+            return nullptr;
+        }
+        if (!platform::semaphore_create(0, pool->done)) {
+            platform::semaphore_destroy(pool->start);
+            memory::fbfree(pool, sizeof(internal::worker_pool), memory::MEMORY_TAG_JOB);
+            return nullptr;
+        }
+
+        // The thread running a query works too.
+        u32 count = platform::get_processor_count();
+        count = count > max_thread_count ? max_thread_count : count;
+        for (u32 i = 1; i < count; i++) {
+            if (platform::thread_create(pool_worker, pool, pool->threads[pool->thread_count])) {
+                pool->thread_count++;
+            }
+        }
+
+        return pool;
+    }
+
+    void stop_workers(internal::worker_pool* pool) {
+        ftl::atomic_store(&pool->stopping, (u32)1);
+        for (u32 i = 0; i < pool->thread_count; i++) {
+            platform::semaphore_signal(pool->start);
+        }
+        for (u32 i = 0; i < pool->thread_count; i++) {
+            platform::thread_wait(pool->threads[i]);
+        }
+
+        platform::semaphore_destroy(pool->start);
+        platform::semaphore_destroy(pool->done);
+        memory::fbfree(pool, sizeof(internal::worker_pool), memory::MEMORY_TAG_JOB);
+    }
+}  // namespace
+
+world::~world() {
+    destroy();
+}
+
+b8 world::create() {
+    destroy();
+
+    for (u32 i = 0; i < component_slot_count; i++) {
+        component_slots[i] = invalid_u32;
+    }
+    component_count = 0;
+
+    // Entities without components live in the archetype with the empty signature, always at index 0.
+    signature empty;
+    create_archetype(empty);
+
+    pool = start_workers();
+    if (!pool) {
+        FBWARN("world::create: Could not start the worker threads, parallel queries will run on one thread.");
+    }
+
+    return true;
+}
+
+void world::destroy() {
+    if (pool) {
+        stop_workers(pool);
+        pool = nullptr;
+    }
+
+    for (u32 a = 0; a < archetype_count; a++) {
+        internal::archetype& arch = archetypes[a];
+        for (u32 c = 0; c < arch.chunk_count; c++) {
+            memory::fbfree(arch.chunks[c].allocation, chunk_size + cache_line, memory::MEMORY_TAG_COMPONENT);
+        }
+        if (arch.chunks) {
+            memory::fbfree(arch.chunks, sizeof(internal::chunk) * arch.chunk_array_capacity, memory::MEMORY_TAG_COMPONENT);
+        }
+    }
+
+    if (archetypes) {
+        memory::fbfree(archetypes, sizeof(internal::archetype) * archetype_capacity, memory::MEMORY_TAG_COMPONENT);
+    }
+    if (records) {
+        memory::fbfree(records, sizeof(internal::entity_record) * record_capacity, memory::MEMORY_TAG_COMPONENT);
+    }
+    if (tasks) {
+        memory::fbfree(tasks, sizeof(u32) * task_capacity, memory::MEMORY_TAG_COMPONENT);
+    }
+
+    archetypes = nullptr;
+    archetype_count = 0;
+    archetype_capacity = 0;
+    records = nullptr;
+    record_count = 0;
+    record_capacity = 0;
+    free_record = invalid_u32;
+    entity_count = 0;
+    tasks = nullptr;
+    task_capacity = 0;
+}
+
+/********** COMPONENTS **********/
+
+u32 world::register_component(u64 hash, u32 size, u32 alignment) {
+    u32 slot = (u32)(hash ^ (hash >> 32)) & (component_slot_count - 1);
+    while (component_slots[slot] != invalid_u32) {
+        if (components[component_slots[slot]].hash == hash) {
+            return component_slots[slot];
+        }
+        slot = (slot + 1) & (component_slot_count - 1);
+    }
+
+    if (component_count == max_components) {
+        FBERROR("world::register_component: More than %u component types.", max_components);
+        return invalid_u32;
+    }
+
+    u32 index = component_count++;
+    components[index] = {hash, size, alignment};
+    component_slots[slot] = index;
+    return index;
+}
+
+u32 world::find_component(u64 hash) const {
+    u32 slot = (u32)(hash ^ (hash >> 32)) & (component_slot_count - 1);
+    while (component_slots[slot] != invalid_u32) {
+        if (components[component_slots[slot]].hash == hash) {
+            return component_slots[slot];
+        }
+        slot = (slot + 1) & (component_slot_count - 1);
+    }
+    return invalid_u32;
+}
+
+b8 world::make_signature(const u32* ids, u32 count, signature& out_signature) {
+    out_signature = signature();
+    for (u32 i = 0; i < count; i++) {
+        if (ids[i] == invalid_u32) {
+            return false;
+        }
+        out_signature.set(ids[i]);
+    }
+    return true;
+}
+
+/********** ARCHETYPES **********/
+
+u32 world::find_archetype(const signature& components) {
+    for (u32 a = 0; a < archetype_count; a++) {
+        if (archetypes[a].components == components) {
+            return a;
+        }
+    }
+    return create_archetype(components);
+}
+
+u32 world::create_archetype(const signature& components) {
+    // Every array starts on its own cache line, the padding that costs is taken off the capacity up front.
+    u32 row_size = sizeof(entity);
+    u32 column_count = 1;
+    components.for_each_set([&](u64 c) {
+        row_size += this->components[c].size;
+        column_count++;
+    });
+
+    if (row_size + cache_line * column_count > chunk_size) {
+        FBERROR("world::create_archetype: Rows of %u bytes in %u arrays don't fit in a %u byte chunk.", row_size, column_count, chunk_size);
+        return invalid_u32;
+    }
+
+    grow(archetypes, archetype_capacity, archetype_count + 1, initial_archetype_capacity, archetype_count);
+
+    u32 index = archetype_count++;
+    internal::archetype& arch = archetypes[index];
+    arch.components = components;
+    arch.chunks = nullptr;
+    arch.chunk_count = 0;
+    arch.chunk_array_capacity = 0;
+    arch.entity_count = 0;
+    for (u32 i = 0; i < max_components; i++) {
+        arch.offsets[i] = internal::no_column;
+        arch.add_edges[i] = invalid_u32;
+        arch.remove_edges[i] = invalid_u32;
+    }
+
+    u32 capacity = (chunk_size - cache_line * column_count) / row_size;
+    for (;; capacity--) {
+        u32 offset = align_up(sizeof(entity) * capacity, cache_line);
+        components.for_each_set([&](u64 c) {
+            arch.offsets[c] = (u16)offset;
+            offset = align_up(offset + this->components[c].size * capacity, cache_line);
+        });
+        if (offset <= chunk_size) {
+            break;
+        }
+    }
+    arch.capacity = capacity;
+
+    return index;
+}
+
+u32 world::archetype_edge(u32 source, u32 component, b8 add) {
+    u32 edge = add ? archetypes[source].add_edges[component] : archetypes[source].remove_edges[component];
+    if (edge != invalid_u32) {
+        return edge;
+    }
+
+    signature components = archetypes[source].components;
+    components.assign(component, add);
+
+    // NOTE: find_archetype may move the archetype array.
+    u32 destination = find_archetype(components);
+    if (destination == invalid_u32) {
+        return invalid_u32;
+    }
+
+    if (add) {
+        archetypes[source].add_edges[component] = destination;
+        archetypes[destination].remove_edges[component] = source;
+    } else {
+        archetypes[source].remove_edges[component] = destination;
+        archetypes[destination].add_edges[component] = source;
+    }
+
+    return destination;
+}
+
+u32 world::push_row(u32 archetype, entity e) {
+    internal::archetype& arch = archetypes[archetype];
+
+    u32 row = arch.entity_count;
+    u32 c = row / arch.capacity;
+    if (c == arch.chunk_count) {
+        grow(arch.chunks, arch.chunk_array_capacity, arch.chunk_count + 1, 4, arch.chunk_count);
+
+        internal::chunk& created = arch.chunks[arch.chunk_count++];
+        created.allocation = memory::fballocate(chunk_size + cache_line, memory::MEMORY_TAG_COMPONENT);
+        created.data = (u8*)(((u64)created.allocation + cache_line - 1) & ~(u64)(cache_line - 1));
+        created.count = 0;
+    }
+
+    internal::chunk& target = arch.chunks[c];
+    ((entity*)target.data)[target.count] = e;
+    target.count++;
+    arch.entity_count++;
+
+    return row;
+}
+
+void world::remove_row(u32 archetype, u32 chunk, u32 row) {
+    internal::archetype& arch = archetypes[archetype];
+
+    u32 last = arch.entity_count - 1;
+    u32 last_chunk = last / arch.capacity;
+    u32 last_row = last % arch.capacity;
+
+    if (chunk != last_chunk || row != last_row) {
+        u8* to = arch.chunks[chunk].data;
+        u8* from = arch.chunks[last_chunk].data;
+
+        entity moved = ((entity*)from)[last_row];
+        ((entity*)to)[row] = moved;
+        arch.components.for_each_set([&](u64 c) {
+            u32 size = components[c].size;
+            memory::fbcopy(to + arch.offsets[c] + size * row, from + arch.offsets[c] + size * last_row, size);
+        });
+
+        records[moved.index].chunk = chunk;
+        records[moved.index].row = row;
+    }
+
+    arch.entity_count--;
+    if (--arch.chunks[last_chunk].count == 0 && arch.chunk_count > last_chunk + 1) {
+        // Keep the chunk that just emptied as the one spare, so an entity moving back and forth over a chunk
+        // boundary doesn't allocate every time.
+        memory::fbfree(arch.chunks[last_chunk + 1].allocation, chunk_size + cache_line, memory::MEMORY_TAG_COMPONENT);
+        arch.chunk_count--;
+    }
+}
+
+void world::move_entity(entity e, u32 destination) {
+    internal::entity_record& record = records[e.index];
+    u32 source = record.archetype;
+
+    u32 row = push_row(destination, e);
+    const internal::archetype& from = archetypes[source];
+    const internal::archetype& to = archetypes[destination];
+    u32 chunk = row / to.capacity;
+    row %= to.capacity;
+
+    // Copy what both have in common, which is everything in the smaller signature.
+    u8* dst = to.chunks[chunk].data;
+    const u8* src = from.chunks[record.chunk].data;
+    (from.components & to.components).for_each_set([&](u64 c) {
+        u32 size = components[c].size;
+        memory::fbcopy(dst + to.offsets[c] + size * row, src + from.offsets[c] + size * record.row, size);
+    });
+
+    remove_row(source, record.chunk, record.row);
+
+    record.archetype = destination;
+    record.chunk = chunk;
+    record.row = row;
+}
+
+/********** ENTITIES **********/
+
+entity world::create_entity() {
+    u32 index = free_record;
+    if (index != invalid_u32) {
+        free_record = records[index].row;
+    } else {
+        grow(records, record_capacity, record_count + 1, initial_record_capacity, record_count);
+        index = record_count++;
+        records[index].generation = 0;
+    }
+
+    entity e = {index, records[index].generation};
+    u32 row = push_row(0, e);
+
+    records[index].archetype = 0;
+    records[index].chunk = row / archetypes[0].capacity;
+    records[index].row = row % archetypes[0].capacity;
+    entity_count++;
+
+    return e;
+}
+
+void world::destroy_entity(entity e) {
+    if (!is_alive(e)) {
+        FBERROR("world::destroy_entity: Entity %u:%u is not alive.", e.index, e.generation);
+        return;
+    }
+
+    internal::entity_record& record = records[e.index];
+    remove_row(record.archetype, record.chunk, record.row);
+
+    record.archetype = invalid_u32;
+    record.generation++;
+    record.row = free_record;
+    free_record = e.index;
+    entity_count--;
+}
+
+b8 world::is_alive(entity e) const {
+    return e.index < record_count && records[e.index].archetype != invalid_u32 && records[e.index].generation == e.generation;
+}
+
+void* world::add_component(entity e, u32 component) {
+    if (component == invalid_u32) {
+        FBERROR("world::add_component: Invalid component, at most %u component types can be registered.", max_components);
+        return nullptr;
+    }
+
+    if (!is_alive(e)) {
+        FBERROR("world::add_component: Entity %u:%u is not alive.", e.index, e.generation);
+        return nullptr;
+    }
+
+    if (!archetypes[records[e.index].archetype].components.test(component)) {
+        u32 destination = archetype_edge(records[e.index].archetype, component, true);
+        if (destination == invalid_u32) {
+            return nullptr;
+        }
+        move_entity(e, destination);
+    }
+
+    return get_component(e, component);
+}
+
+void world::remove_component(entity e, u32 component) {
+    if (!is_alive(e)) {
+        FBERROR("world::remove_component: Entity %u:%u is not alive.", e.index, e.generation);
+        return;
+    }
+
+    // Components that were never registered can't be on the entity.
+    if (component == invalid_u32) {
+        return;
+    }
+
+    if (archetypes[records[e.index].archetype].components.test(component)) {
+        move_entity(e, archetype_edge(records[e.index].archetype, component, false));
+    }
+}
+
+void* world::get_component(entity e, u32 component) const {
+    if (component == invalid_u32 || !is_alive(e)) {
+        return nullptr;
+    }
+
+    const internal::entity_record& record = records[e.index];
+    const internal::archetype& arch = archetypes[record.archetype];
+    if (arch.offsets[component] == internal::no_column) {
+        return nullptr;
+    }
+
+    return arch.chunks[record.chunk].data + arch.offsets[component] + components[component].size * record.row;
+}
+
+/********** PARALLEL QUERIES **********/
+
+u32 world::gather_chunks(const signature& required) {
+    u32 count = 0;
+    for (u32 a = 0; a < archetype_count; a++) {
+        const internal::archetype& arch = archetypes[a];
+        if (arch.entity_count == 0 || !((arch.components & required) == required)) {
+            continue;
+        }
+
+        u32 used = (arch.entity_count + arch.capacity - 1) / arch.capacity;
+        grow(tasks, task_capacity, (count + used) * 2, 64, count * 2);
+        for (u32 c = 0; c < used; c++) {
+            tasks[count * 2] = a;
+            tasks[count * 2 + 1] = c;
+            count++;
+        }
+    }
+    return count;
+}
+
+void world::run_parallel(u32 task_count, internal::task_pfn task, void* context, u32 thread_count) {
+    if (task_count == 0) {
+        return;
+    }
+
+    u32 available = pool ? pool->thread_count + 1 : 1;
+    thread_count = thread_count ? thread_count : available;
+    thread_count = thread_count > available ? available : thread_count;
+    thread_count = thread_count > task_count ? task_count : thread_count;
+
+    if (thread_count == 1) {
+        parallel_run run = {task, context, task_count, 0};
+        run_tasks(run);
+        return;
+    }
+
+    // Published to the workers by the semaphore.
+    pool->run = {task, context, task_count, 0};
+    for (u32 i = 1; i < thread_count; i++) {
+        platform::semaphore_signal(pool->start);
+    }
+
+    run_tasks(pool->run);
+
+    for (u32 i = 1; i < thread_count; i++) {
+        while (!platform::semaphore_wait(pool->done, worker_idle_timeout_ms)) {
+        }
+    }
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ecs/component.hpp"
+#include "ftl/bitset.hpp"
+
+// NOTE: Entities with the same set of components share an archetype, whose components are stored SoA in 16KiB
+//       chunks: the entity ids first, then one 64 byte aligned array per component. Every chunk but the last of
+//       an archetype is full, so queries walk dense arrays. Adding or removing a component moves the entity to
+//       the neighbouring archetype, found through edges cached on first use. Structural changes (creating and
+//       destroying entities, adding and removing components) must not happen during a query, and invalidate
+//       pointers returned by get. Components that don't fit a chunk together can't be added to the same entity.
+
+namespace fabric::ecs {
+    // Handles are never reused as is: destroying an entity bumps the generation of its index.
+    struct entity {
+        u32 index = invalid_u32;
+        u32 generation = 0;
+
+        b8 operator==(const entity& other) const { return index == other.index && generation == other.generation; }
+        b8 operator!=(const entity& other) const { return !(*this == other); }
+    };
+
+    static constexpr u32 chunk_size = 16 * 1024;
+
+    using signature = ftl::bitset<max_components>;
+
+    namespace internal {
+        static constexpr u16 no_column = 0xFFFF;
+
+        struct chunk {
+            void* allocation;
+            // 64 byte aligned.
+            u8* data;
+            u32 count;
+        };
+
+        struct archetype {
+            signature components;
+            // Offset of each component's array inside a chunk, indexed by component, or no_column.
+            u16 offsets[max_components];
+            // Entities per chunk.
+            u32 capacity;
+
+            chunk* chunks;
+            u32 chunk_count;
+            u32 chunk_array_capacity;
+            u32 entity_count;
+
+            // Archetype reached by adding or removing a component, invalid_u32 until first used.
+            u32 add_edges[max_components];
+            u32 remove_edges[max_components];
+        };
+
+        struct entity_record {
+            // invalid_u32 for free indices, which are chained through row.
+            u32 archetype;
+            u32 chunk;
+            u32 row;
+            u32 generation;
+        };
+
+        struct component_info {
+            u64 hash;
+            u32 size;
+            u32 alignment;
+        };
+
+        template <u32... I>
+        struct indices {};
+
+        template <u32 N, u32... I>
+        struct make_indices : make_indices<N - 1, N - 1, I...> {};
+
+        template <u32... I>
+        struct make_indices<0, I...> {
+            using type = indices<I...>;
+        };
+
+        typedef void (*task_pfn)(void* context, u32 task);
+
+        struct worker_pool;
+    }  // namespace internal
+
+    class FBAPI world {
+       public:
+        world() = default;
+        ~world();
+
+        b8 create();
+        void destroy();
+
+        entity create_entity();
+        void destroy_entity(entity e);
+        b8 is_alive(entity e) const;
+        u32 get_entity_count() const { return entity_count; }
+
+        // Adding a component the entity already has overwrites it. nullptr when it can't be added, see add_component.
+        template <typename T>
+        T* add(entity e, const T& value = {}) {
+            T* storage = (T*)add_component(e, component_index<T>());
+            if (storage) {
+                *storage = value;
+            }
+            return storage;
+        }
+
+        template <typename T>
+        void remove(entity e) {
+            remove_component(e, component_index<T>());
+        }
+
+        template <typename T>
+        b8 has(entity e) const {
+            return get_component(e, find_component(component<T>::hash)) != nullptr;
+        }
+
+        // nullptr when the entity doesn't have the component.
+        template <typename T>
+        T* get(entity e) const {
+            return (T*)get_component(e, find_component(component<T>::hash));
+        }
+
+        // Calls fn(count, entities, T*... arrays) for every chunk holding all of T.
+        template <typename... T, typename F>
+        void each_chunk(F&& fn) {
+            u32 ids[] = {component_index<T>()...};
+            signature required;
+            if (!make_signature(ids, sizeof...(T), required)) {
+                return;
+            }
+
+            for (u32 a = 0; a < archetype_count; a++) {
+                const internal::archetype& arch = archetypes[a];
+                if (arch.entity_count == 0 || !((arch.components & required) == required)) {
+                    continue;
+                }
+
+                u32 offsets[sizeof...(T)];
+                for (u32 i = 0; i < sizeof...(T); i++) {
+                    offsets[i] = arch.offsets[ids[i]];
+                }
+
+                for (u32 c = 0; c < arch.chunk_count && arch.chunks[c].count > 0; c++) {
+                    invoke_chunk<T...>(fn, arch.chunks[c], offsets, typename internal::make_indices<sizeof...(T)>::type());
+                }
+            }
+        }
+
+        // Calls fn(T&... components) for every entity holding all of T.
+        template <typename... T, typename F>
+        void each(F&& fn) {
+            each_chunk<T...>([&](u32 count, const entity*, T*... arrays) {
+                for (u32 i = 0; i < count; i++) {
+                    fn(arrays[i]...);
+                }
+            });
+        }
+
+        // Same as each_chunk, with the chunks spread over the world's worker threads and the calling one, at most
+        // thread_count of them (0 for all). fn runs concurrently and must only touch the chunk it is given. Parallel
+        // queries on the same world can't run at the same time or inside one another.
+        template <typename... T, typename F>
+        void parallel_each_chunk(F&& fn, u32 thread_count = 0) {
+            u32 ids[] = {component_index<T>()...};
+            signature required;
+            if (!make_signature(ids, sizeof...(T), required)) {
+                return;
+            }
+            u32 task_count = gather_chunks(required);
+
+            struct context {
+                world* self;
+                F* fn;
+                u32 ids[sizeof...(T)];
+            };
+            context ctx = {this, &fn, {}};
+            for (u32 i = 0; i < sizeof...(T); i++) {
+                ctx.ids[i] = ids[i];
+            }
+
+            internal::task_pfn task = [](void* data, u32 index) {
+                context& c = *(context*)data;
+                const internal::archetype& arch = c.self->archetypes[c.self->tasks[index * 2]];
+
+                u32 offsets[sizeof...(T)];
+                for (u32 i = 0; i < sizeof...(T); i++) {
+                    offsets[i] = arch.offsets[c.ids[i]];
+                }
+                c.self->template invoke_chunk<T...>(*c.fn, arch.chunks[c.self->tasks[index * 2 + 1]], offsets, typename internal::make_indices<sizeof...(T)>::type());
+            };
+
+            run_parallel(task_count, task, &ctx, thread_count);
+        }
+
+        template <typename... T, typename F>
+        void parallel_each(F&& fn, u32 thread_count = 0) {
+            parallel_each_chunk<T...>([&](u32 count, const entity*, T*... arrays) {
+                for (u32 i = 0; i < count; i++) {
+                    fn(arrays[i]...);
+                }
+            }, thread_count);
+        }
+
+        // Type erased interface the templates above are built on. Components are identified by the index
+        // register_component hands out for their hash, invalid_u32 past max_components.
+        u32 register_component(u64 hash, u32 size, u32 alignment);
+        // invalid_u32 when the component was never registered.
+        u32 find_component(u64 hash) const;
+        // Returns the component's storage, uninitialized when the entity didn't have it yet. nullptr when the entity
+        // isn't alive, the component is invalid_u32 or the entity's components wouldn't fit a chunk with it.
+        void* add_component(entity e, u32 component);
+        void remove_component(entity e, u32 component);
+        void* get_component(entity e, u32 component) const;
+
+       private:
+        template <typename T>
+        u32 component_index() {
+            using info = component<T>;
+            return register_component(info::hash, info::size, info::alignment);
+        }
+
+        template <typename... T, typename F, u32... I>
+        static void invoke_chunk(F& fn, const internal::chunk& c, const u32* offsets, internal::indices<I...>) {
+            fn(c.count, (const entity*)c.data, (T*)(c.data + offsets[I])...);
+        }
+
+        // False when one of the ids is invalid_u32, no entity can have that component.
+        static b8 make_signature(const u32* ids, u32 count, signature& out_signature);
+
+        // These return invalid_u32 when the archetype's rows don't fit in a chunk.
+        u32 find_archetype(const signature& components);
+        u32 create_archetype(const signature& components);
+        u32 archetype_edge(u32 source, u32 component, b8 add);
+
+        // Appends a row to the archetype and returns its global row index.
+        u32 push_row(u32 archetype, entity e);
+        // Fills the hole with the archetype's last row.
+        void remove_row(u32 archetype, u32 chunk, u32 row);
+        void move_entity(entity e, u32 destination);
+
+        // Lists (archetype, chunk) pairs matching required in tasks and returns how many there are.
+        u32 gather_chunks(const signature& required);
+        void run_parallel(u32 task_count, internal::task_pfn task, void* context, u32 thread_count);
+
+       private:
+        internal::component_info components[max_components];
+        u32 component_count = 0;
+        // Open addressed map from component hash to index.
+        u32 component_slots[max_components * 2];
+
+        internal::archetype* archetypes = nullptr;
+        u32 archetype_count = 0;
+        u32 archetype_capacity = 0;
+
+        internal::entity_record* records = nullptr;
+        u32 record_count = 0;
+        u32 record_capacity = 0;
+        u32 free_record = invalid_u32;
+        u32 entity_count = 0;
+
+        // Scratch list for parallel queries.
+        u32* tasks = nullptr;
+        u32 task_capacity = 0;
+        // One thread per processor but the calling one, started by create.
+        internal::worker_pool* pool = nullptr;
+    };
+}  // namespace fabric::ecs
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/math.hpp"
+
+namespace ftl {
+    // 3x4 affine transform, the mat4 equivalent with the constant (0, 0, 0, 1) column dropped.
+    // NOTE: Each row holds one column of the equivalent mat4: rows[j] = (m[0][j], m[1][j], m[2][j], translation[j]).
+    //       Transforming a point is then 3 dot products with the w lane added, and the type stays 48 bytes.
+    //       Composition follows the mat4 convention: a * b applies a first, then b.
+    struct affine3 {
+        constexpr affine3() : mat{1.0f, 0.0f, 0.0f, 0.0f,
+                                  0.0f, 1.0f, 0.0f, 0.0f,
+                                  0.0f, 0.0f, 1.0f, 0.0f} {}
+
+        // Expects the last column of matrix to be (0, 0, 0, 1).
+        constexpr explicit affine3(const mat4& matrix) : mat{matrix.mat[0], matrix.mat[4], matrix.mat[8], matrix.mat[12],
+                                                             matrix.mat[1], matrix.mat[5], matrix.mat[9], matrix.mat[13],
+                                                             matrix.mat[2], matrix.mat[6], matrix.mat[10], matrix.mat[14]} {}
+
+        constexpr mat4 to_mat4() const {
+            mat4 result = mat4(1.0f);
+
+            for (u32 j = 0; j < 3; j++) {
+                result.mat[0 + j] = mat[j * 4 + 0];
+                result.mat[4 + j] = mat[j * 4 + 1];
+                result.mat[8 + j] = mat[j * 4 + 2];
+                result.mat[12 + j] = mat[j * 4 + 3];
+            }
+
+            return result;
+        }
+
+        constexpr affine3 operator*(const affine3& other) const {
+            affine3 result;
+
+#if FBSIMD_SSE2
+            if (!__builtin_is_constant_evaluated()) {
+                __m128 a0 = _mm_loadu_ps(mat + 0);
+                __m128 a1 = _mm_loadu_ps(mat + 4);
+                __m128 a2 = _mm_loadu_ps(mat + 8);
+                __m128 w_mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+                // Column j of the product is a's 3x3 part times column j of other, plus other's translation[j].
+                for (u32 j = 0; j < 12; j += 4) {
+                    __m128 b = _mm_loadu_ps(other.mat + j);
+                    __m128 r = _mm_and_ps(b, w_mask);
+                    r = internal::madd(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)), a0, r);
+                    r = internal::madd(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1)), a1, r);
+                    r = internal::madd(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2)), a2, r);
+                    _mm_storeu_ps(result.mat + j, r);
+                }
+
+                return result;
+            }
+#endif
+
+            for (u32 j = 0; j < 12; j += 4) {
+                const f32* b = other.mat + j;
+                for (u32 i = 0; i < 4; i++) {
+                    result.mat[j + i] = b[0] * mat[0 + i] + b[1] * mat[4 + i] + b[2] * mat[8 + i];
+                }
+                result.mat[j + 3] += b[3];
+            }
+
+            return result;
+        }
+
+        constexpr void inverse() {
+#if FBSIMD_SSE2
+            if (!__builtin_is_constant_evaluated()) {
+                __m128 c0 = _mm_loadu_ps(mat + 0);
+                __m128 c1 = _mm_loadu_ps(mat + 4);
+                __m128 c2 = _mm_loadu_ps(mat + 8);
+
+                // The stored rows are the columns of the 3x3 part, so the rows of its inverse are their cross
+                // products over the determinant. The w lanes of the cross products come out as 0.
+                __m128 r0 = internal::cross3(c1, c2);
+                __m128 r1 = internal::cross3(c2, c0);
+                __m128 r2 = internal::cross3(c0, c1);
+                __m128 rcp_det = _mm_div_ps(_mm_set1_ps(1.0f), internal::dot3(c0, r0));
+
+                r0 = _mm_mul_ps(r0, rcp_det);
+                r1 = _mm_mul_ps(r1, rcp_det);
+                r2 = _mm_mul_ps(r2, rcp_det);
+
+                // -translation * inverse(3x3)
+                __m128 t = _mm_setr_ps(mat[3], mat[7], mat[11], 0.0f);
+                __m128 r3 = _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+                r3 = internal::madd(_mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)), r1, r3);
+                r3 = internal::madd(_mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2)), r2, r3);
+                r3 = _mm_sub_ps(_mm_setzero_ps(), r3);
+
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                _mm_storeu_ps(mat + 0, r0);
+                _mm_storeu_ps(mat + 4, r1);
+                _mm_storeu_ps(mat + 8, r2);
+
+                return;
+            }
+#endif
+
+            const f32* m = mat;
+
+            // Rows of the inverse 3x3 part, written transposed into o.
+            f32 o[12] = {};
+            o[0] = m[5] * m[10] - m[6] * m[9];
+            o[4] = m[6] * m[8] - m[4] * m[10];
+            o[8] = m[4] * m[9] - m[5] * m[8];
+
+            f32 d = 1.0f / (m[0] * o[0] + m[1] * o[4] + m[2] * o[8]);
+
+            o[0] = d * o[0];
+            o[4] = d * o[4];
+            o[8] = d * o[8];
+            o[1] = d * (m[9] * m[2] - m[10] * m[1]);
+            o[5] = d * (m[10] * m[0] - m[8] * m[2]);
+            o[9] = d * (m[8] * m[1] - m[9] * m[0]);
+            o[2] = d * (m[1] * m[6] - m[2] * m[5]);
+            o[6] = d * (m[2] * m[4] - m[0] * m[6]);
+            o[10] = d * (m[0] * m[5] - m[1] * m[4]);
+
+            o[3] = -(m[3] * o[0] + m[7] * o[1] + m[11] * o[2]);
+            o[7] = -(m[3] * o[4] + m[7] * o[5] + m[11] * o[6]);
+            o[11] = -(m[3] * o[8] + m[7] * o[9] + m[11] * o[10]);
+
+            for (u32 i = 0; i < 12; i++) {
+                mat[i] = o[i];
+            }
+        }
+
+        constexpr vec3f transform_point(const vec3f& point) const {
+            const f32* p = point.vec;
+            return vec3f(p[0] * mat[0] + p[1] * mat[1] + p[2] * mat[2] + mat[3],
+                         p[0] * mat[4] + p[1] * mat[5] + p[2] * mat[6] + mat[7],
+                         p[0] * mat[8] + p[1] * mat[9] + p[2] * mat[10] + mat[11]);
+        }
+
+        // Ignores the translation.
+        constexpr vec3f transform_vector(const vec3f& vector) const {
+            const f32* v = vector.vec;
+            return vec3f(v[0] * mat[0] + v[1] * mat[1] + v[2] * mat[2],
+                         v[0] * mat[4] + v[1] * mat[5] + v[2] * mat[6],
+                         v[0] * mat[8] + v[1] * mat[9] + v[2] * mat[10]);
+        }
+
+        constexpr vec3f get_translation() const {
+            return vec3f(mat[3], mat[7], mat[11]);
+        }
+
+        union {
+            f32 mat[12];
+            vec4f rows[3];
+        };
+    };
+
+    STATIC_ASSERT(sizeof(affine3) == 48, "affine3 must stay 3x4 floats");
+
+    FBINLINE constexpr affine3 inverse(const affine3& transform) {
+        affine3 result = transform;
+        result.inverse();
+        return result;
+    }
+
+    // Same result as affine3(scale(s) * rotation(r) * translation(t)) without the matrix multiplies.
+    // r must be a unit quaternion.
+    FBINLINE constexpr affine3 compose(const vec3f& t, const quat& r, const vec3f& s) {
+        f32 w = r.vec[0], x = r.vec[1], y = r.vec[2], z = r.vec[3];
+        f32 x2 = x + x, y2 = y + y, z2 = z + z;
+        f32 xx = x * x2, yy = y * y2, zz = z * z2;
+        f32 xy = x * y2, xz = x * z2, yz = y * z2;
+        f32 wx = w * x2, wy = w * y2, wz = w * z2;
+
+        affine3 result;
+        f32* o = result.mat;
+
+        // Column j of the mat4 is (s.x * R[0][j], s.y * R[1][j], s.z * R[2][j], t[j]).
+        o[0] = s.vec[0] * (1.0f - yy - zz);
+        o[1] = s.vec[1] * (xy + wz);
+        o[2] = s.vec[2] * (xz - wy);
+        o[3] = t.vec[0];
+
+        o[4] = s.vec[0] * (xy - wz);
+        o[5] = s.vec[1] * (1.0f - xx - zz);
+        o[6] = s.vec[2] * (yz + wx);
+        o[7] = t.vec[1];
+
+        o[8] = s.vec[0] * (xz + wy);
+        o[9] = s.vec[1] * (yz - wx);
+        o[10] = s.vec[2] * (1.0f - xx - yy);
+        o[11] = t.vec[2];
+
+        return result;
+    }
+
+    // Inverse of compose for transforms without shear. A mirrored transform comes back with a negative s.x.
+    FBINLINE void decompose(const affine3& transform, vec3f& t, quat& r, vec3f& s) {
+        const f32* m = transform.mat;
+
+        t = transform.get_translation();
+
+        vec3f axis_x = vec3f(m[0], m[4], m[8]);
+        vec3f axis_y = vec3f(m[1], m[5], m[9]);
+        vec3f axis_z = vec3f(m[2], m[6], m[10]);
+
+        s = vec3f(axis_x.length(), axis_y.length(), axis_z.length());
+        if (dot(cross(axis_x, axis_y), axis_z) < 0.0f) {
+            s.vec[0] = -s.vec[0];
+        }
+
+        axis_x = axis_x / s.vec[0];
+        axis_y = axis_y / s.vec[1];
+        axis_z = axis_z / s.vec[2];
+
+        // Rows of the pure rotation, named as in compose.
+        f32 r00 = axis_x.vec[0], r01 = axis_x.vec[1], r02 = axis_x.vec[2];
+        f32 r10 = axis_y.vec[0], r11 = axis_y.vec[1], r12 = axis_y.vec[2];
+        f32 r20 = axis_z.vec[0], r21 = axis_z.vec[1], r22 = axis_z.vec[2];
+
+        // Pick the largest of w, x, y, z to divide by, which keeps the extraction stable.
+        f32 trace = r00 + r11 + r22;
+        if (trace > 0.0f) {
+            f32 k = 0.5f / fbsqrt(trace + 1.0f);
+            r = quat((r21 - r12) * k, (r02 - r20) * k, (r10 - r01) * k, 0.25f / k);
+        } else if (r00 > r11 && r00 > r22) {
+            f32 k = 0.5f / fbsqrt(1.0f + r00 - r11 - r22);
+            r = quat(0.25f / k, (r01 + r10) * k, (r02 + r20) * k, (r21 - r12) * k);
+        } else if (r11 > r22) {
+            f32 k = 0.5f / fbsqrt(1.0f + r11 - r00 - r22);
+            r = quat((r01 + r10) * k, 0.25f / k, (r12 + r21) * k, (r02 - r20) * k);
+        } else {
+            f32 k = 0.5f / fbsqrt(1.0f + r22 - r00 - r11);
+            r = quat((r02 + r20) * k, (r12 + r21) * k, 0.25f / k, (r10 - r01) * k);
+        }
+    }
+}  // namespace ftl
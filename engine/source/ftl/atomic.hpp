@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/simd.hpp"
+
+// NOTE: Thin wrappers over the compiler atomic builtins for plain integer and pointer members, so shared counters
+//       don't need std::atomic. Every access to a shared variable has to go through these.
+
+namespace ftl {
+    enum memory_order {
+        MEMORY_ORDER_RELAXED = __ATOMIC_RELAXED,
+        MEMORY_ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+        MEMORY_ORDER_RELEASE = __ATOMIC_RELEASE,
+        MEMORY_ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+        MEMORY_ORDER_SEQ_CST = __ATOMIC_SEQ_CST
+    };
+
+    template <typename T>
+    FBINLINE T atomic_load(const T* ptr, memory_order order = MEMORY_ORDER_SEQ_CST) {
+        return __atomic_load_n(ptr, order);
+    }
+
+    template <typename T>
+    FBINLINE void atomic_store(T* ptr, T value, memory_order order = MEMORY_ORDER_SEQ_CST) {
+        __atomic_store_n(ptr, value, order);
+    }
+
+    // Returns the previous value.
+    template <typename T>
+    FBINLINE T atomic_fetch_add(T* ptr, T value, memory_order order = MEMORY_ORDER_SEQ_CST) {
+        return __atomic_fetch_add(ptr, value, order);
+    }
+
+    template <typename T>
+    FBINLINE T atomic_exchange(T* ptr, T value, memory_order order = MEMORY_ORDER_SEQ_CST) {
+        return __atomic_exchange_n(ptr, value, order);
+    }
+
+    // On failure expected receives the current value.
+    template <typename T>
+    FBINLINE b8 atomic_compare_exchange(T* ptr, T& expected, T desired, memory_order success = MEMORY_ORDER_SEQ_CST, memory_order failure = MEMORY_ORDER_SEQ_CST) {
+        return __atomic_compare_exchange_n(ptr, &expected, desired, false, success, failure);
+    }
+
+    FBINLINE void atomic_fence(memory_order order = MEMORY_ORDER_SEQ_CST) {
+        __atomic_thread_fence(order);
+    }
+
+    // Hint for spin-wait loops.
+    FBINLINE void cpu_pause() {
+#if FBSIMD_SSE2
+        _mm_pause();
+#endif
+    }
+}  // namespace ftl
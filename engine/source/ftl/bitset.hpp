@@ -0,0 +1,210 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/simd.hpp"
+
+namespace ftl {
+    namespace internal {
+        // Word-wise bitwise kernels. 256 bits are processed per instruction with AVX2, 128 with SSE2.
+        // NOTE: Loads are unaligned since system states live at arbitrary offsets inside linear allocators.
+#if FBSIMD_AVX2
+#define BITSET_KERNEL_AVX2(intrinsic, a, b)                                                               \
+    for (; i + 4 <= count; i += 4) {                                                                      \
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));                                          \
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));                                          \
+        _mm256_storeu_si256((__m256i*)(out + i), intrinsic(va, vb));                                       \
+    }
+#else
+#define BITSET_KERNEL_AVX2(intrinsic, a, b)
+#endif
+
+#if FBSIMD_SSE2
+#define BITSET_KERNEL_SSE2(intrinsic, a, b)                                                               \
+    for (; i + 2 <= count; i += 2) {                                                                      \
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));                                             \
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));                                             \
+        _mm_storeu_si128((__m128i*)(out + i), intrinsic(va, vb));                                          \
+    }
+#else
+#define BITSET_KERNEL_SSE2(intrinsic, a, b)
+#endif
+
+#define BITSET_KERNEL(name, avx2_intrinsic, sse2_intrinsic, a, b, scalar_op)                         \
+    FBINLINE void name(u64* out, const u64* lhs, const u64* rhs, u64 count) {                         \
+        u64 i = 0;                                                                                    \
+        BITSET_KERNEL_AVX2(avx2_intrinsic, a, b)                                                      \
+        BITSET_KERNEL_SSE2(sse2_intrinsic, a, b)                                                      \
+        for (; i < count; i++) {                                                                      \
+            out[i] = scalar_op;                                                                       \
+        }                                                                                             \
+    }
+
+        BITSET_KERNEL(bitset_and, _mm256_and_si256, _mm_and_si128, lhs, rhs, lhs[i] & rhs[i])
+        BITSET_KERNEL(bitset_or, _mm256_or_si256, _mm_or_si128, lhs, rhs, lhs[i] | rhs[i])
+        BITSET_KERNEL(bitset_xor, _mm256_xor_si256, _mm_xor_si128, lhs, rhs, lhs[i] ^ rhs[i])
+        // NOTE: andnot intrinsics negate their first operand, so the operands are swapped here.
+        BITSET_KERNEL(bitset_and_not, _mm256_andnot_si256, _mm_andnot_si128, rhs, lhs, lhs[i] & ~rhs[i])
+
+#undef BITSET_KERNEL
+#undef BITSET_KERNEL_SSE2
+#undef BITSET_KERNEL_AVX2
+    }  // namespace internal
+
+    template <u64 N>
+    class bitset {
+       public:
+        static constexpr u64 word_count = (N + 63) / 64;
+        static constexpr u64 npos = invalid_u64;
+
+        bitset() { clear(); }
+
+        b8 test(u64 index) const {
+            return (words[index >> 6] >> (index & 63)) & 1;
+        }
+
+        void set(u64 index) {
+            words[index >> 6] |= (1ULL << (index & 63));
+        }
+
+        void reset(u64 index) {
+            words[index >> 6] &= ~(1ULL << (index & 63));
+        }
+
+        void assign(u64 index, b8 value) {
+            u64 mask = 1ULL << (index & 63);
+            u64& word = words[index >> 6];
+            word = value ? (word | mask) : (word & ~mask);
+        }
+
+        void clear() {
+            for (u64 i = 0; i < word_count; i++) {
+                words[i] = 0;
+            }
+        }
+
+        bitset<N> operator&(const bitset<N>& other) const {
+            bitset<N> result;
+            internal::bitset_and(result.words, words, other.words, word_count);
+            return result;
+        }
+
+        bitset<N> operator|(const bitset<N>& other) const {
+            bitset<N> result;
+            internal::bitset_or(result.words, words, other.words, word_count);
+            return result;
+        }
+
+        bitset<N> operator^(const bitset<N>& other) const {
+            bitset<N> result;
+            internal::bitset_xor(result.words, words, other.words, word_count);
+            return result;
+        }
+
+        // Bits set in this bitset but not in the other one (this & ~other).
+        bitset<N> and_not(const bitset<N>& other) const {
+            bitset<N> result;
+            internal::bitset_and_not(result.words, words, other.words, word_count);
+            return result;
+        }
+
+        bitset<N>& operator&=(const bitset<N>& other) {
+            internal::bitset_and(words, words, other.words, word_count);
+            return *this;
+        }
+
+        bitset<N>& operator|=(const bitset<N>& other) {
+            internal::bitset_or(words, words, other.words, word_count);
+            return *this;
+        }
+
+        bitset<N>& operator^=(const bitset<N>& other) {
+            internal::bitset_xor(words, words, other.words, word_count);
+            return *this;
+        }
+
+        bitset<N> operator~() const {
+            bitset<N> result;
+            for (u64 i = 0; i < word_count; i++) {
+                result.words[i] = ~words[i];
+            }
+            result.mask_tail();
+            return result;
+        }
+
+        b8 operator==(const bitset<N>& other) const {
+            u64 difference = 0;
+            for (u64 i = 0; i < word_count; i++) {
+                difference |= words[i] ^ other.words[i];
+            }
+            return difference == 0;
+        }
+
+        b8 any() const {
+            u64 combined = 0;
+            for (u64 i = 0; i < word_count; i++) {
+                combined |= words[i];
+            }
+            return combined != 0;
+        }
+
+        b8 none() const { return !any(); }
+
+        u64 count() const {
+            u64 result = 0;
+            for (u64 i = 0; i < word_count; i++) {
+                result += popcount(words[i]);
+            }
+            return result;
+        }
+
+        // Returns the index of the first set bit, or npos if no bit is set.
+        u64 find_first_set() const {
+            for (u64 i = 0; i < word_count; i++) {
+                if (words[i]) {
+                    return (i << 6) + count_trailing_zeros(words[i]);
+                }
+            }
+            return npos;
+        }
+
+        // Calls fn(index) for every set bit, in ascending order.
+        template <typename F>
+        void for_each_set(F&& fn) const {
+            for (u64 i = 0; i < word_count; i++) {
+                u64 word = words[i];
+                while (word) {
+                    fn((i << 6) + count_trailing_zeros(word));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        // Calls fn(index, value) for every bit that differs from the other bitset, where value is the bit in this one.
+        template <typename F>
+        void for_each_changed(const bitset<N>& other, F&& fn) const {
+            for (u64 i = 0; i < word_count; i++) {
+                u64 changed = words[i] ^ other.words[i];
+                while (changed) {
+                    u64 index = (i << 6) + count_trailing_zeros(changed);
+                    fn(index, (b8)((words[i] >> (index & 63)) & 1));
+                    changed &= changed - 1;
+                }
+            }
+        }
+
+        static constexpr u64 size() { return N; }
+
+        u64* data() { return words; }
+        const u64* data() const { return words; }
+
+       private:
+        void mask_tail() {
+            if constexpr ((N & 63) != 0) {
+                words[word_count - 1] &= (1ULL << (N & 63)) - 1;
+            }
+        }
+
+       private:
+        u64 words[word_count];
+    };
+}  // namespace ftl
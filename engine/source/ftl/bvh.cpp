@@ -0,0 +1,747 @@
+#include "ftl/bvh.hpp"
+#include "ftl/atomic.hpp"
+#include "ftl/lanes.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+#include "platform/platform.hpp"
+
+using namespace fabric;
+using namespace ftl;
+using namespace ftl::internal;
+
+namespace {
+    static constexpr u32 bin_count = 16;
+    // Cost of visiting a node relative to testing one primitive.
+    static constexpr f32 traversal_cost = 1.0f;
+    // Leaves are never made larger than this just because SAH prefers it.
+    static constexpr u32 max_sah_leaf_size = 16;
+    // Below this depth SAH is trusted, past it nodes are split in half to bound the tree depth.
+    static constexpr u32 max_sah_depth = 48;
+    static constexpr u32 max_stack_size = 256;
+
+    // Subtrees smaller than this aren't worth handing to another thread.
+    static constexpr u32 min_task_size = 4096;
+    static constexpr u32 tasks_per_thread = 4;
+    static constexpr u32 max_thread_count = 64;
+    static constexpr u32 min_parallel_count = 16384;
+
+#if FBSIMD_SSE2
+    using node_lanes = lanes_sse;
+#else
+    using node_lanes = lanes_scalar;
+#endif
+
+    FBINLINE aabb empty_aabb() {
+        return {vec3f(FB_INFINITY), vec3f(-FB_INFINITY)};
+    }
+
+    FBINLINE void grow(aabb& box, const aabb& other) {
+        for (u32 i = 0; i < 3; i++) {
+            box.min.vec[i] = other.min.vec[i] < box.min.vec[i] ? other.min.vec[i] : box.min.vec[i];
+            box.max.vec[i] = other.max.vec[i] > box.max.vec[i] ? other.max.vec[i] : box.max.vec[i];
+        }
+    }
+
+    FBINLINE void grow(aabb& box, const vec3f& point) {
+        for (u32 i = 0; i < 3; i++) {
+            box.min.vec[i] = point.vec[i] < box.min.vec[i] ? point.vec[i] : box.min.vec[i];
+            box.max.vec[i] = point.vec[i] > box.max.vec[i] ? point.vec[i] : box.max.vec[i];
+        }
+    }
+
+    // Half the surface area, which is all SAH needs.
+    FBINLINE f32 half_area(const aabb& box) {
+        vec3f d = box.max - box.min;
+        if (d.x < 0.0f) {
+            return 0.0f;
+        }
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    FBINLINE void set_slot(bvh_node& node, u32 slot, const aabb& box, u32 child, u32 count) {
+        node.min_x[slot] = box.min.x;
+        node.min_y[slot] = box.min.y;
+        node.min_z[slot] = box.min.z;
+        node.max_x[slot] = box.max.x;
+        node.max_y[slot] = box.max.y;
+        node.max_z[slot] = box.max.z;
+        node.child[slot] = child;
+        node.count[slot] = count;
+    }
+
+    FBINLINE aabb get_slot(const bvh_node& node, u32 slot) {
+        return {vec3f(node.min_x[slot], node.min_y[slot], node.min_z[slot]), vec3f(node.max_x[slot], node.max_y[slot], node.max_z[slot])};
+    }
+
+    /********** BUILD **********/
+
+    // Binary node used while building. count == 0 marks an inner node with children at left and left + 1.
+    struct build_node {
+        aabb bounds;
+        u32 left_or_first;
+        u32 count;
+    };
+
+    struct build_task {
+        u32 node;
+        u32 begin;
+        u32 end;
+        u32 depth;
+    };
+
+    struct build_context {
+        const aabb* boxes;
+        vec3f* centroids;
+        u32* indices;
+        build_node* nodes;
+        u32 max_leaf_size;
+
+        // Shared between the build threads.
+        u32 node_count;
+        build_task* tasks;
+        u32 task_count;
+        u32 next_task;
+    };
+
+    struct split {
+        u32 axis;
+        u32 bin;
+        f32 cost;
+    };
+
+    FBINLINE u32 bin_index(f32 centroid, f32 min, f32 scale) {
+        i32 bin = (i32)((centroid - min) * scale);
+        return bin < 0 ? 0 : (bin >= (i32)bin_count ? bin_count - 1 : (u32)bin);
+    }
+
+    // Best binned SAH split over all three axes. Returns false when all centroids coincide.
+    b8 find_split(const build_context& ctx, u32 begin, u32 end, const aabb& centroid_bounds, split& best) {
+        aabb bin_bounds[3][bin_count];
+        u32 bin_counts[3][bin_count] = {};
+        f32 min[3];
+        f32 scale[3];
+        for (u32 axis = 0; axis < 3; axis++) {
+            min[axis] = centroid_bounds.min.vec[axis];
+            f32 extent = centroid_bounds.max.vec[axis] - min[axis];
+            scale[axis] = extent > 0.0f ? (f32)bin_count / extent : 0.0f;
+            for (u32 b = 0; b < bin_count; b++) {
+                bin_bounds[axis][b] = empty_aabb();
+            }
+        }
+
+        // All three axes are binned in one pass so each primitive is only read once.
+        for (u32 i = begin; i < end; i++) {
+            u32 primitive = ctx.indices[i];
+            const aabb& box = ctx.boxes[primitive];
+            for (u32 axis = 0; axis < 3; axis++) {
+                u32 b = bin_index(ctx.centroids[primitive].vec[axis], min[axis], scale[axis]);
+                bin_counts[axis][b]++;
+                grow(bin_bounds[axis][b], box);
+            }
+        }
+
+        best.cost = FB_INFINITY;
+        b8 found = false;
+
+        for (u32 axis = 0; axis < 3; axis++) {
+            if (scale[axis] == 0.0f) {
+                continue;
+            }
+
+            // Sweep from the right to get the cost of everything past each split plane, then from the left.
+            f32 right_cost[bin_count];
+            aabb right = empty_aabb();
+            u32 right_count = 0;
+            for (u32 b = bin_count - 1; b > 0; b--) {
+                grow(right, bin_bounds[axis][b]);
+                right_count += bin_counts[axis][b];
+                right_cost[b] = half_area(right) * (f32)right_count;
+            }
+
+            aabb left = empty_aabb();
+            u32 left_count = 0;
+            for (u32 b = 0; b < bin_count - 1; b++) {
+                grow(left, bin_bounds[axis][b]);
+                left_count += bin_counts[axis][b];
+
+                if (left_count == 0 || left_count == end - begin) {
+                    continue;
+                }
+
+                f32 cost = half_area(left) * (f32)left_count + right_cost[b + 1];
+                if (cost < best.cost) {
+                    best = {axis, b, cost};
+                    found = true;
+                }
+            }
+        }
+
+        return found;
+    }
+
+    // Moves the primitives on the left of the split to the front of the range and returns where the right side starts.
+    u32 partition(build_context& ctx, u32 begin, u32 end, const aabb& centroid_bounds, const split& s) {
+        f32 min = centroid_bounds.min.vec[s.axis];
+        f32 scale = (f32)bin_count / (centroid_bounds.max.vec[s.axis] - min);
+
+        u32 i = begin;
+        u32 j = end;
+        while (i < j) {
+            if (bin_index(ctx.centroids[ctx.indices[i]].vec[s.axis], min, scale) <= s.bin) {
+                i++;
+            } else {
+                j--;
+                u32 swap = ctx.indices[i];
+                ctx.indices[i] = ctx.indices[j];
+                ctx.indices[j] = swap;
+            }
+        }
+
+        return i;
+    }
+
+    // Fills in the node for task and, unless it becomes a leaf, allocates its two children and returns their tasks.
+    b8 split_node(build_context& ctx, const build_task& task, build_task& left, build_task& right) {
+        build_node& node = ctx.nodes[task.node];
+        u32 count = task.end - task.begin;
+
+        aabb bounds = empty_aabb();
+        aabb centroid_bounds = empty_aabb();
+        for (u32 i = task.begin; i < task.end; i++) {
+            u32 primitive = ctx.indices[i];
+            grow(bounds, ctx.boxes[primitive]);
+            grow(centroid_bounds, ctx.centroids[primitive]);
+        }
+        node.bounds = bounds;
+
+        u32 mid = 0;
+        if (count > ctx.max_leaf_size) {
+            split s;
+            if (task.depth < max_sah_depth && find_split(ctx, task.begin, task.end, centroid_bounds, s)) {
+                f32 split_cost = traversal_cost + s.cost / half_area(bounds);
+                if (split_cost < (f32)count || count > max_sah_leaf_size) {
+                    mid = partition(ctx, task.begin, task.end, centroid_bounds, s);
+                }
+            } else if (count > max_sah_leaf_size) {
+                // Coincident centroids or a degenerate tree: any split is as good as another.
+                mid = task.begin + count / 2;
+            }
+        }
+
+        if (mid == 0) {
+            node.left_or_first = task.begin;
+            node.count = count;
+            return false;
+        }
+
+        u32 first_child = atomic_fetch_add(&ctx.node_count, 2u, MEMORY_ORDER_RELAXED);
+        node.left_or_first = first_child;
+        node.count = 0;
+
+        left = {first_child, task.begin, mid, task.depth + 1};
+        right = {first_child + 1, mid, task.end, task.depth + 1};
+        return true;
+    }
+
+    void build_recursive(build_context& ctx, const build_task& task) {
+        build_task left, right;
+        if (split_node(ctx, task, left, right)) {
+            build_recursive(ctx, left);
+            build_recursive(ctx, right);
+        }
+    }
+
+    u32 build_worker(void* params) {
+        build_context& ctx = *(build_context*)params;
+
+        for (;;) {
+            u32 index = atomic_fetch_add(&ctx.next_task, 1u, MEMORY_ORDER_RELAXED);
+            if (index >= ctx.task_count) {
+                break;
+            }
+            build_recursive(ctx, ctx.tasks[index]);
+        }
+
+        return 0;
+    }
+
+    // Splits the largest pending task on the calling thread until there are enough subtrees to share out.
+    void build_parallel(build_context& ctx, const build_task& root, u32 thread_count) {
+        u32 task_capacity = thread_count * tasks_per_thread + 1;
+        ctx.tasks = (build_task*)memory::fballocate(sizeof(build_task) * task_capacity, memory::MEMORY_TAG_SPATIAL);
+        ctx.tasks[0] = root;
+        ctx.task_count = 1;
+
+        while (ctx.task_count < task_capacity) {
+            u32 largest = 0;
+            for (u32 i = 1; i < ctx.task_count; i++) {
+                if (ctx.tasks[i].end - ctx.tasks[i].begin > ctx.tasks[largest].end - ctx.tasks[largest].begin) {
+                    largest = i;
+                }
+            }
+
+            build_task task = ctx.tasks[largest];
+            if (task.end - task.begin < min_task_size) {
+                break;
+            }
+
+            build_task left, right;
+            if (split_node(ctx, task, left, right)) {
+                ctx.tasks[largest] = left;
+                ctx.tasks[ctx.task_count++] = right;
+            } else {
+                // It became a leaf, nothing left to do for it.
+                ctx.tasks[largest] = ctx.tasks[--ctx.task_count];
+                if (ctx.task_count == 0) {
+                    break;
+                }
+            }
+        }
+
+        ctx.next_task = 0;
+
+        platform::thread threads[max_thread_count];
+        u32 started = 0;
+        for (u32 i = 1; i < thread_count; i++) {
+            if (platform::thread_create(build_worker, &ctx, threads[started])) {
+                started++;
+            }
+        }
+
+        // The calling thread works too, so the build finishes even if no thread could be started.
+        build_worker(&ctx);
+
+        for (u32 i = 0; i < started; i++) {
+            platform::thread_wait(threads[i]);
+        }
+
+        memory::fbfree(ctx.tasks, sizeof(build_task) * task_capacity, memory::MEMORY_TAG_SPATIAL);
+        ctx.tasks = nullptr;
+    }
+
+    // Turns the binary tree into 4-wide nodes by repeatedly opening the largest inner child.
+    u32 collapse(const build_node* binary, u32 binary_index, bvh_node* nodes, u32& node_count) {
+        u32 index = node_count++;
+
+        u32 children[4];
+        u32 child_count = 0;
+
+        const build_node& root = binary[binary_index];
+        if (root.count > 0) {
+            children[child_count++] = binary_index;
+        } else {
+            children[child_count++] = root.left_or_first;
+            children[child_count++] = root.left_or_first + 1;
+        }
+
+        while (child_count < 4) {
+            u32 open = invalid_u32;
+            f32 largest_area = -1.0f;
+            for (u32 i = 0; i < child_count; i++) {
+                const build_node& candidate = binary[children[i]];
+                f32 area = half_area(candidate.bounds);
+                if (candidate.count == 0 && area > largest_area) {
+                    largest_area = area;
+                    open = i;
+                }
+            }
+
+            if (open == invalid_u32) {
+                break;
+            }
+
+            u32 left = binary[children[open]].left_or_first;
+            children[open] = left;
+            children[child_count++] = left + 1;
+        }
+
+        for (u32 slot = 0; slot < 4; slot++) {
+            if (slot >= child_count) {
+                set_slot(nodes[index], slot, empty_aabb(), invalid_u32, 0);
+                continue;
+            }
+
+            const build_node& child = binary[children[slot]];
+            if (child.count > 0) {
+                set_slot(nodes[index], slot, child.bounds, child.left_or_first, child.count);
+            } else {
+                u32 child_index = collapse(binary, children[slot], nodes, node_count);
+                set_slot(nodes[index], slot, child.bounds, child_index, 0);
+            }
+        }
+
+        return index;
+    }
+
+    /********** TRAVERSAL **********/
+
+    struct stack_entry {
+        u32 child;
+        u32 count;
+        f32 t;
+    };
+
+    // Ray data for the slab tests. Using the near and far planes per direction sign means unused slots, stored as
+    // inverted boxes, can never be hit.
+    struct ray_query {
+        vec3f origin;
+        vec3f inv_direction;
+        b8 negative[3];
+    };
+
+    FBINLINE ray_query make_ray_query(const ray& r) {
+        ray_query q;
+        q.origin = r.origin;
+        for (u32 i = 0; i < 3; i++) {
+            f32 d = r.direction.vec[i];
+            if (d < 1e-30f && d > -1e-30f) {
+                d = d < 0.0f ? -1e-30f : 1e-30f;
+            }
+            q.inv_direction.vec[i] = 1.0f / d;
+            q.negative[i] = d < 0.0f;
+        }
+        return q;
+    }
+
+    FBINLINE f32 ray_box(const ray_query& q, const aabb& box, f32 max_t) {
+        f32 t_near = 0.0f;
+        f32 t_far = max_t;
+        for (u32 i = 0; i < 3; i++) {
+            f32 near = q.negative[i] ? box.max.vec[i] : box.min.vec[i];
+            f32 far = q.negative[i] ? box.min.vec[i] : box.max.vec[i];
+            f32 t0 = (near - q.origin.vec[i]) * q.inv_direction.vec[i];
+            f32 t1 = (far - q.origin.vec[i]) * q.inv_direction.vec[i];
+            t_near = t0 > t_near ? t0 : t_near;
+            t_far = t1 < t_far ? t1 : t_far;
+        }
+        return t_near <= t_far ? t_near : FB_INFINITY;
+    }
+
+    FBINLINE b8 boxes_overlap(const aabb& a, const aabb& b) {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    FBINLINE void push(stack_entry* stack, u32& size, u32 child, u32 count, f32 t) {
+        if (size < max_stack_size) {
+            stack[size++] = {child, count, t};
+        } else {
+            FBERROR("bvh: Traversal stack overflow, part of the tree was skipped.");
+        }
+    }
+}  // namespace
+
+bvh::~bvh() {
+    destroy();
+}
+
+b8 bvh::build(const aabb* boxes, u32 count, const bvh_build_config& config) {
+    destroy();
+
+    bounds = empty_aabb();
+    if (count == 0) {
+        return true;
+    }
+
+    u32 max_binary_nodes = 2 * count - 1;
+
+    build_context ctx = {};
+    ctx.boxes = boxes;
+    ctx.max_leaf_size = config.max_leaf_size > 0 ? config.max_leaf_size : 1;
+    ctx.centroids = (vec3f*)memory::fballocate(sizeof(vec3f) * count, memory::MEMORY_TAG_SPATIAL);
+    ctx.nodes = (build_node*)memory::fballocate(sizeof(build_node) * max_binary_nodes, memory::MEMORY_TAG_SPATIAL);
+    ctx.indices = (u32*)memory::fballocate(sizeof(u32) * count, memory::MEMORY_TAG_SPATIAL);
+    ctx.node_count = 1;
+
+    for (u32 i = 0; i < count; i++) {
+        ctx.centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+        ctx.indices[i] = i;
+    }
+
+    u32 thread_count = config.thread_count > 0 ? config.thread_count : platform::get_processor_count();
+    thread_count = thread_count > max_thread_count ? max_thread_count : thread_count;
+
+    build_task root = {0, 0, count, 0};
+    if (thread_count > 1 && count >= min_parallel_count) {
+        build_parallel(ctx, root, thread_count);
+    } else {
+        build_recursive(ctx, root);
+    }
+
+    // Every inner binary node collapses into at most one 4-wide node.
+    node_capacity = ctx.node_count;
+    nodes = (bvh_node*)memory::fballocate(sizeof(bvh_node) * node_capacity, memory::MEMORY_TAG_SPATIAL);
+    node_count = 0;
+    collapse(ctx.nodes, 0, nodes, node_count);
+
+    primitive_count = count;
+    primitive_indices = ctx.indices;
+    primitive_bounds = (aabb*)memory::fballocate(sizeof(aabb) * count, memory::MEMORY_TAG_SPATIAL);
+    for (u32 i = 0; i < count; i++) {
+        primitive_bounds[i] = boxes[primitive_indices[i]];
+    }
+    bounds = ctx.nodes[0].bounds;
+
+    memory::fbfree(ctx.centroids, sizeof(vec3f) * count, memory::MEMORY_TAG_SPATIAL);
+    memory::fbfree(ctx.nodes, sizeof(build_node) * max_binary_nodes, memory::MEMORY_TAG_SPATIAL);
+
+    return true;
+}
+
+void bvh::destroy() {
+    if (nodes) {
+        memory::fbfree(nodes, sizeof(bvh_node) * node_capacity, memory::MEMORY_TAG_SPATIAL);
+        memory::fbfree(primitive_indices, sizeof(u32) * primitive_count, memory::MEMORY_TAG_SPATIAL);
+        memory::fbfree(primitive_bounds, sizeof(aabb) * primitive_count, memory::MEMORY_TAG_SPATIAL);
+    }
+
+    nodes = nullptr;
+    primitive_indices = nullptr;
+    primitive_bounds = nullptr;
+    node_count = 0;
+    node_capacity = 0;
+    primitive_count = 0;
+}
+
+void bvh::refit(const aabb* boxes) {
+    if (!nodes) {
+        return;
+    }
+
+    for (u32 i = 0; i < primitive_count; i++) {
+        primitive_bounds[i] = boxes[primitive_indices[i]];
+    }
+
+    // Children always come after their parent, so walking backwards refits them first.
+    for (u32 n = node_count; n-- > 0;) {
+        bvh_node& node = nodes[n];
+        for (u32 slot = 0; slot < 4; slot++) {
+            aabb box = empty_aabb();
+            if (node.count[slot] > 0) {
+                for (u32 p = node.child[slot]; p < node.child[slot] + node.count[slot]; p++) {
+                    grow(box, primitive_bounds[p]);
+                }
+            } else if (node.child[slot] != invalid_u32) {
+                const bvh_node& child = nodes[node.child[slot]];
+                for (u32 c = 0; c < 4; c++) {
+                    grow(box, get_slot(child, c));
+                }
+            } else {
+                continue;
+            }
+            set_slot(node, slot, box, node.child[slot], node.count[slot]);
+        }
+    }
+
+    bounds = empty_aabb();
+    for (u32 slot = 0; slot < 4; slot++) {
+        grow(bounds, get_slot(nodes[0], slot));
+    }
+}
+
+ray_hit bvh::intersect(const ray& r, f32 max_t, bvh_ray_pfn test, void* context) const {
+    ray_hit best = {max_t, invalid_u32};
+    if (!nodes) {
+        return best;
+    }
+
+    ray_query q = make_ray_query(r);
+
+    using L = node_lanes;
+    typename L::reg ox = L::set(q.origin.x), oy = L::set(q.origin.y), oz = L::set(q.origin.z);
+    typename L::reg ix = L::set(q.inv_direction.x), iy = L::set(q.inv_direction.y), iz = L::set(q.inv_direction.z);
+
+    stack_entry stack[max_stack_size];
+    u32 size = 0;
+    push(stack, size, 0, 0, 0.0f);
+
+    while (size > 0) {
+        stack_entry entry = stack[--size];
+        if (entry.t >= best.t) {
+            continue;
+        }
+
+        if (entry.count > 0) {
+            for (u32 p = entry.child; p < entry.child + entry.count; p++) {
+                f32 t = test ? test(primitive_indices[p], r, best.t, context) : ray_box(q, primitive_bounds[p], best.t);
+                if (t < best.t) {
+                    best = {t, primitive_indices[p]};
+                }
+            }
+            continue;
+        }
+
+        const bvh_node& node = nodes[entry.child];
+        const f32* near_x = q.negative[0] ? node.max_x : node.min_x;
+        const f32* near_y = q.negative[1] ? node.max_y : node.min_y;
+        const f32* near_z = q.negative[2] ? node.max_z : node.min_z;
+        const f32* far_x = q.negative[0] ? node.min_x : node.max_x;
+        const f32* far_y = q.negative[1] ? node.min_y : node.max_y;
+        const f32* far_z = q.negative[2] ? node.min_z : node.max_z;
+
+        f32 t_slots[4];
+        u32 hit_bits = 0;
+        for (u32 c = 0; c < 4; c += L::width) {
+            typename L::reg t_near = L::max(L::max(L::mul(L::sub(L::load(near_x + c), ox), ix), L::mul(L::sub(L::load(near_y + c), oy), iy)),
+                                            L::max(L::mul(L::sub(L::load(near_z + c), oz), iz), L::set(0.0f)));
+            typename L::reg t_far = L::min(L::min(L::mul(L::sub(L::load(far_x + c), ox), ix), L::mul(L::sub(L::load(far_y + c), oy), iy)),
+                                           L::min(L::mul(L::sub(L::load(far_z + c), oz), iz), L::set(best.t)));
+            L::store(t_slots + c, t_near);
+            hit_bits |= (~L::bits(L::less(t_far, t_near)) & ((1u << L::width) - 1)) << c;
+        }
+
+        // Push the hit children furthest first, so the nearest is visited next.
+        u32 order[4];
+        u32 hits = 0;
+        while (hit_bits) {
+            u32 slot = count_trailing_zeros(hit_bits);
+            hit_bits &= hit_bits - 1;
+
+            u32 i = hits++;
+            while (i > 0 && t_slots[order[i - 1]] < t_slots[slot]) {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = slot;
+        }
+
+        for (u32 i = 0; i < hits; i++) {
+            push(stack, size, node.child[order[i]], node.count[order[i]], t_slots[order[i]]);
+        }
+    }
+
+    return best;
+}
+
+u32 bvh::overlap(const aabb& box, u32* out, u32 max_count) const {
+    u32 found = 0;
+    if (!nodes) {
+        return found;
+    }
+
+    using L = node_lanes;
+    typename L::reg qmin_x = L::set(box.min.x), qmin_y = L::set(box.min.y), qmin_z = L::set(box.min.z);
+    typename L::reg qmax_x = L::set(box.max.x), qmax_y = L::set(box.max.y), qmax_z = L::set(box.max.z);
+
+    stack_entry stack[max_stack_size];
+    u32 size = 0;
+    push(stack, size, 0, 0, 0.0f);
+
+    while (size > 0) {
+        stack_entry entry = stack[--size];
+
+        if (entry.count > 0) {
+            for (u32 p = entry.child; p < entry.child + entry.count; p++) {
+                if (boxes_overlap(primitive_bounds[p], box)) {
+                    if (found < max_count) {
+                        out[found] = primitive_indices[p];
+                    }
+                    found++;
+                }
+            }
+            continue;
+        }
+
+        const bvh_node& node = nodes[entry.child];
+        u32 separated = 0;
+        for (u32 c = 0; c < 4; c += L::width) {
+            typename L::mask apart = L::mask_or(L::mask_or(L::greater(L::load(node.min_x + c), qmax_x), L::less(L::load(node.max_x + c), qmin_x)),
+                                                L::mask_or(L::greater(L::load(node.min_y + c), qmax_y), L::less(L::load(node.max_y + c), qmin_y)));
+            apart = L::mask_or(apart, L::mask_or(L::greater(L::load(node.min_z + c), qmax_z), L::less(L::load(node.max_z + c), qmin_z)));
+            separated |= L::bits(apart) << c;
+        }
+
+        for (u32 slot = 0; slot < 4; slot++) {
+            if (!(separated & (1u << slot))) {
+                push(stack, size, node.child[slot], node.count[slot], 0.0f);
+            }
+        }
+    }
+
+    return found;
+}
+
+u32 bvh::cull(const frustum& f, u32* out, u32 max_count) const {
+    u32 found = 0;
+    if (!nodes) {
+        return found;
+    }
+
+    using L = node_lanes;
+    typename L::reg nx[FRUSTUM_PLANE_COUNT], ny[FRUSTUM_PLANE_COUNT], nz[FRUSTUM_PLANE_COUNT];
+    typename L::reg ax[FRUSTUM_PLANE_COUNT], ay[FRUSTUM_PLANE_COUNT], az[FRUSTUM_PLANE_COUNT], d[FRUSTUM_PLANE_COUNT];
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+        const plane& pl = f.planes[p];
+        nx[p] = L::set(pl.normal.x);
+        ny[p] = L::set(pl.normal.y);
+        nz[p] = L::set(pl.normal.z);
+        ax[p] = L::set(pl.normal.x < 0.0f ? -pl.normal.x : pl.normal.x);
+        ay[p] = L::set(pl.normal.y < 0.0f ? -pl.normal.y : pl.normal.y);
+        az[p] = L::set(pl.normal.z < 0.0f ? -pl.normal.z : pl.normal.z);
+        d[p] = L::set(pl.distance);
+    }
+
+    // The t field of a stack entry is 1 when the subtree is known to be fully inside the frustum.
+    stack_entry stack[max_stack_size];
+    u32 size = 0;
+    push(stack, size, 0, 0, 0.0f);
+
+    while (size > 0) {
+        stack_entry entry = stack[--size];
+        b8 inside = entry.t > 0.0f;
+
+        if (entry.count > 0) {
+            for (u32 p = entry.child; p < entry.child + entry.count; p++) {
+                if (inside || is_visible(f, primitive_bounds[p])) {
+                    if (found < max_count) {
+                        out[found] = primitive_indices[p];
+                    }
+                    found++;
+                }
+            }
+            continue;
+        }
+
+        const bvh_node& node = nodes[entry.child];
+        u32 outside_bits = 0;
+        u32 inside_bits = 0;
+        if (inside) {
+            inside_bits = 0xF;
+        } else {
+            for (u32 c = 0; c < 4; c += L::width) {
+                typename L::reg half = L::set(0.5f);
+                typename L::reg cx = L::mul(L::add(L::load(node.min_x + c), L::load(node.max_x + c)), half);
+                typename L::reg cy = L::mul(L::add(L::load(node.min_y + c), L::load(node.max_y + c)), half);
+                typename L::reg cz = L::mul(L::add(L::load(node.min_z + c), L::load(node.max_z + c)), half);
+                typename L::reg ex = L::mul(L::sub(L::load(node.max_x + c), L::load(node.min_x + c)), half);
+                typename L::reg ey = L::mul(L::sub(L::load(node.max_y + c), L::load(node.min_y + c)), half);
+                typename L::reg ez = L::mul(L::sub(L::load(node.max_z + c), L::load(node.min_z + c)), half);
+
+                // Nearest and furthest box corner distance over all planes.
+                typename L::reg nearest = L::set(FB_INFINITY);
+                typename L::reg furthest = L::set(FB_INFINITY);
+                for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+                    typename L::reg distance = L::madd(cx, nx[p], L::madd(cy, ny[p], L::madd(cz, nz[p], d[p])));
+                    typename L::reg radius = L::madd(ex, ax[p], L::madd(ey, ay[p], L::mul(ez, az[p])));
+                    nearest = L::min(nearest, L::add(distance, radius));
+                    furthest = L::min(furthest, L::sub(distance, radius));
+                }
+
+                u32 lanes = (1u << L::width) - 1;
+                outside_bits |= (L::bits(L::less(nearest, L::set(0.0f))) & lanes) << c;
+                inside_bits |= (~L::bits(L::less(furthest, L::set(0.0f))) & lanes) << c;
+            }
+        }
+
+        for (u32 slot = 0; slot < 4; slot++) {
+            b8 unused = node.count[slot] == 0 && node.child[slot] == invalid_u32;
+            if (unused || (outside_bits & (1u << slot))) {
+                continue;
+            }
+            push(stack, size, node.child[slot], node.count[slot], (inside_bits & (1u << slot)) ? 1.0f : 0.0f);
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/geometry.hpp"
+#include "ftl/intersection.hpp"
+
+namespace ftl {
+    // 4-wide node: the bounds of the 4 children are stored as SoA so one node is tested with a single SSE pass.
+    // Nodes are laid out depth first, so a parent always comes before its children.
+    struct bvh_node {
+        f32 min_x[4];
+        f32 min_y[4];
+        f32 min_z[4];
+        f32 max_x[4];
+        f32 max_y[4];
+        f32 max_z[4];
+        // count == 0: child is a node index, or invalid_u32 for an unused slot.
+        // count > 0:  the child is a leaf holding the primitives [child, child + count) in leaf order.
+        u32 child[4];
+        u32 count[4];
+    };
+
+    STATIC_ASSERT(sizeof(bvh_node) == 128, "bvh_node should span exactly two cache lines");
+
+    struct bvh_build_config {
+        // Nodes with this many primitives or fewer become leaves.
+        u32 max_leaf_size = 4;
+        // Worker threads used for the build, 0 uses one per processor and 1 builds on the calling thread only.
+        u32 thread_count = 0;
+    };
+
+    // Returns the distance along r at which the primitive is hit, or a value >= max_t when it isn't.
+    typedef f32 (*bvh_ray_pfn)(u32 primitive, const ray& r, f32 max_t, void* context);
+
+    // Bounding volume hierarchy over AABBs, built with binned SAH and collapsed to 4-wide nodes.
+    // Query results are primitive indices as passed to build.
+    class FBAPI bvh {
+       public:
+        bvh() = default;
+        ~bvh();
+
+        b8 build(const aabb* boxes, u32 count, const bvh_build_config& config = {});
+        void destroy();
+
+        // Updates the bounds for moved primitives without changing the tree. boxes must hold the same primitives,
+        // in the same order, as the last build. Quality drops as objects move away from their original neighbours,
+        // so rebuild now and then.
+        void refit(const aabb* boxes);
+
+        // Nearest primitive hit by r. Without a test function the primitive boxes themselves are the targets.
+        ray_hit intersect(const ray& r, f32 max_t = FB_INFINITY, bvh_ray_pfn test = nullptr, void* context = nullptr) const;
+
+        // Write up to max_count primitives overlapping box, or visible in f, to out and return how many were found.
+        // When the return value exceeds max_count the result was truncated.
+        u32 overlap(const aabb& box, u32* out, u32 max_count) const;
+        u32 cull(const frustum& f, u32* out, u32 max_count) const;
+
+        u32 get_node_count() const { return node_count; }
+        u32 get_primitive_count() const { return primitive_count; }
+        const aabb& get_bounds() const { return bounds; }
+
+       private:
+        bvh_node* nodes = nullptr;
+        u32 node_count = 0;
+        u32 node_capacity = 0;
+
+        // Both in leaf order.
+        u32* primitive_indices = nullptr;
+        aabb* primitive_bounds = nullptr;
+        u32 primitive_count = 0;
+
+        aabb bounds;
+    };
+}  // namespace ftl
@@ -0,0 +1,114 @@
+#include "ftl/culling.hpp"
+#include "ftl/lanes.hpp"
+
+using namespace ftl;
+using namespace ftl::internal;
+
+namespace {
+    // Frustum planes splatted once per call.
+    template <typename L>
+    struct frustum_lanes {
+        typename L::reg nx[FRUSTUM_PLANE_COUNT];
+        typename L::reg ny[FRUSTUM_PLANE_COUNT];
+        typename L::reg nz[FRUSTUM_PLANE_COUNT];
+        typename L::reg abs_nx[FRUSTUM_PLANE_COUNT];
+        typename L::reg abs_ny[FRUSTUM_PLANE_COUNT];
+        typename L::reg abs_nz[FRUSTUM_PLANE_COUNT];
+        typename L::reg d[FRUSTUM_PLANE_COUNT];
+
+        explicit frustum_lanes(const frustum& f) {
+            for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+                const plane& p = f.planes[i];
+                nx[i] = L::set(p.normal.x);
+                ny[i] = L::set(p.normal.y);
+                nz[i] = L::set(p.normal.z);
+                abs_nx[i] = L::set(p.normal.x < 0.0f ? -p.normal.x : p.normal.x);
+                abs_ny[i] = L::set(p.normal.y < 0.0f ? -p.normal.y : p.normal.y);
+                abs_nz[i] = L::set(p.normal.z < 0.0f ? -p.normal.z : p.normal.z);
+                d[i] = L::set(p.distance);
+            }
+        }
+    };
+
+    // Returns one bit per culled lane.
+    template <typename L>
+    FBINLINE u32 spheres_outside(const frustum_lanes<L>& f, const sphere_soa& spheres, u32 i) {
+        typename L::reg x = L::load(spheres.x + i);
+        typename L::reg y = L::load(spheres.y + i);
+        typename L::reg z = L::load(spheres.z + i);
+        typename L::reg r = L::load(spheres.radius + i);
+
+        // Smallest signed distance over all planes, offset by the radius.
+        typename L::reg nearest = L::set(FB_INFINITY);
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            typename L::reg distance = L::madd(x, f.nx[p], L::madd(y, f.ny[p], L::madd(z, f.nz[p], f.d[p])));
+            nearest = L::min(nearest, distance);
+        }
+
+        return L::bits(L::less(L::add(nearest, r), L::set(0.0f)));
+    }
+
+    template <typename L>
+    FBINLINE u32 aabbs_outside(const frustum_lanes<L>& f, const aabb_soa& boxes, u32 i) {
+        typename L::reg cx = L::load(boxes.center_x + i);
+        typename L::reg cy = L::load(boxes.center_y + i);
+        typename L::reg cz = L::load(boxes.center_z + i);
+        typename L::reg ex = L::load(boxes.extent_x + i);
+        typename L::reg ey = L::load(boxes.extent_y + i);
+        typename L::reg ez = L::load(boxes.extent_z + i);
+
+        // Distance of the box corner furthest along each plane normal.
+        typename L::reg nearest = L::set(FB_INFINITY);
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            typename L::reg distance = L::madd(cx, f.nx[p], L::madd(cy, f.ny[p], L::madd(cz, f.nz[p], f.d[p])));
+            typename L::reg radius = L::madd(ex, f.abs_nx[p], L::madd(ey, f.abs_ny[p], L::mul(ez, f.abs_nz[p])));
+            nearest = L::min(nearest, L::add(distance, radius));
+        }
+
+        return L::bits(L::less(nearest, L::set(0.0f)));
+    }
+}  // namespace
+
+u64 ftl::cull_spheres(const frustum& f, const sphere_soa& spheres, u32 begin, u32 end, u32* visible) {
+    constexpr u32 width = (u32)lanes_wide::width;
+    constexpr u32 all_lanes = (1u << width) - 1;
+
+    frustum_lanes<lanes_wide> wide(f);
+    u64 count = 0;
+    u32 i = begin;
+
+    for (; i + width <= end; i += width) {
+        count = append_indices(visible, count, i, ~spheres_outside(wide, spheres, i) & all_lanes);
+    }
+
+    frustum_lanes<lanes_scalar> scalar(f);
+    for (; i < end; i++) {
+        if (!spheres_outside(scalar, spheres, i)) {
+            visible[count++] = i;
+        }
+    }
+
+    return count;
+}
+
+u64 ftl::cull_aabbs(const frustum& f, const aabb_soa& boxes, u32 begin, u32 end, u32* visible) {
+    constexpr u32 width = (u32)lanes_wide::width;
+    constexpr u32 all_lanes = (1u << width) - 1;
+
+    frustum_lanes<lanes_wide> wide(f);
+    u64 count = 0;
+    u32 i = begin;
+
+    for (; i + width <= end; i += width) {
+        count = append_indices(visible, count, i, ~aabbs_outside(wide, boxes, i) & all_lanes);
+    }
+
+    frustum_lanes<lanes_scalar> scalar(f);
+    for (; i < end; i++) {
+        if (!aabbs_outside(scalar, boxes, i)) {
+            visible[count++] = i;
+        }
+    }
+
+    return count;
+}
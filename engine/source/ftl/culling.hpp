@@ -0,0 +1,14 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/geometry.hpp"
+
+// NOTE: The culling kernels test the range [begin, end) of a SoA array and write the indices of the visible
+//       elements, in increasing order, to visible. They return how many were written; visible must have room for
+//       end - begin indices. Splitting the array in ranges with separate output buffers lets several threads cull
+//       the same scene. 8 elements are tested per iteration with AVX, 4 with SSE.
+
+namespace ftl {
+    FBAPI u64 cull_spheres(const frustum& f, const sphere_soa& spheres, u32 begin, u32 end, u32* visible);
+    FBAPI u64 cull_aabbs(const frustum& f, const aabb_soa& boxes, u32 begin, u32 end, u32* visible);
+}  // namespace ftl
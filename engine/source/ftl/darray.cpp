@@ -41,7 +41,7 @@ void internal::darray_resize(internal::memory_layout& layout, u64 newSize, u64 s
 
 void internal::darray_push(internal::memory_layout& layout, u64 stride, u64 index, void* valuePtr) {
     if (index != invalid_u64 && index >= layout.length) {
-        FBERROR("Index outside of the bounds of this array! Length: %i, index: %i", layout.length, index);
+        FBERROR("Index outside of the bounds of this array! Length: %llu, index: %llu", layout.length, index);
         return;
     }
 
@@ -69,7 +69,7 @@ void internal::darray_push(internal::memory_layout& layout, u64 stride, u64 inde
 
 void internal::darray_pop(internal::memory_layout& layout, u64 stride, u64 index) {
     if (index != invalid_u64 && index >= layout.length) {
-        FBERROR("Index outside of the bounds of this array! Length: %i, index: %i", layout.length, index);
+        FBERROR("Index outside of the bounds of this array! Length: %llu, index: %llu", layout.length, index);
         return;
     }
 
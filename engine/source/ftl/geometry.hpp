@@ -0,0 +1,139 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/math.hpp"
+
+namespace ftl {
+    // Points with dot(normal, p) + distance >= 0 are on the positive side.
+    struct plane {
+        vec3f normal;
+        f32 distance;
+    };
+
+    struct sphere {
+        vec3f center;
+        f32 radius;
+    };
+
+    struct aabb {
+        vec3f min;
+        vec3f max;
+    };
+
+    // Points along the ray are origin + t * direction. The direction doesn't need to be normalized, t is then
+    // measured in multiples of its length.
+    struct ray {
+        vec3f origin;
+        vec3f direction;
+    };
+
+    struct sphere_soa {
+        f32* x;
+        f32* y;
+        f32* z;
+        f32* radius;
+    };
+
+    // Boxes in center and half extent form, which needs fewer operations per plane than min and max.
+    struct aabb_soa {
+        f32* center_x;
+        f32* center_y;
+        f32* center_z;
+        f32* extent_x;
+        f32* extent_y;
+        f32* extent_z;
+    };
+
+    // Structure of arrays view over rays, used for ray packets.
+    struct ray_soa {
+        f32* origin_x;
+        f32* origin_y;
+        f32* origin_z;
+        f32* direction_x;
+        f32* direction_y;
+        f32* direction_z;
+    };
+
+    // Triangles stored as a vertex and the two edges leaving it, which is what the intersection test needs.
+    struct triangle_soa {
+        f32* v0_x;
+        f32* v0_y;
+        f32* v0_z;
+        f32* edge1_x;
+        f32* edge1_y;
+        f32* edge1_z;
+        f32* edge2_x;
+        f32* edge2_y;
+        f32* edge2_z;
+    };
+
+    enum frustum_plane {
+        FRUSTUM_PLANE_LEFT,
+        FRUSTUM_PLANE_RIGHT,
+        FRUSTUM_PLANE_BOTTOM,
+        FRUSTUM_PLANE_TOP,
+        FRUSTUM_PLANE_NEAR,
+        FRUSTUM_PLANE_FAR,
+
+        FRUSTUM_PLANE_COUNT
+    };
+
+    // Planes point inwards, so a volume is visible when it is not fully on the negative side of any plane.
+    struct frustum {
+        plane planes[FRUSTUM_PLANE_COUNT];
+    };
+
+    FBINLINE plane normalize(const plane& p) {
+        f32 inv_length = 1.0f / p.normal.length();
+        return {p.normal * inv_length, p.distance * inv_length};
+    }
+
+    FBINLINE f32 signed_distance(const plane& p, const vec3f& point) {
+        return dot(p.normal, point) + p.distance;
+    }
+
+    // Extracts the normalized planes from a view projection matrix built with perspective or orthographic
+    // (row vectors, clip space depth in [-1, 1]). Each plane is a sum of the w column and one of the x, y, z columns.
+    FBINLINE frustum extract_frustum(const mat4& view_projection) {
+        const f32* m = view_projection.mat;
+
+        vec4f x = vec4f(m[0], m[4], m[8], m[12]);
+        vec4f y = vec4f(m[1], m[5], m[9], m[13]);
+        vec4f z = vec4f(m[2], m[6], m[10], m[14]);
+        vec4f w = vec4f(m[3], m[7], m[11], m[15]);
+
+        vec4f columns[FRUSTUM_PLANE_COUNT] = {w + x, w - x, w + y, w - y, w + z, w - z};
+
+        frustum result;
+        for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+            const vec4f& c = columns[i];
+            result.planes[i] = normalize(plane{vec3f(c.x, c.y, c.z), c.w});
+        }
+
+        return result;
+    }
+
+    FBINLINE b8 is_visible(const frustum& f, const sphere& s) {
+        for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+            if (signed_distance(f.planes[i], s.center) < -s.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Conservative: boxes outside the frustum but crossing two planes near a corner are reported visible.
+    FBINLINE b8 is_visible(const frustum& f, const aabb& box) {
+        vec3f center = (box.min + box.max) * 0.5f;
+        vec3f extent = (box.max - box.min) * 0.5f;
+
+        for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+            const plane& p = f.planes[i];
+            f32 radius = extent.x * fbabs(p.normal.x) + extent.y * fbabs(p.normal.y) + extent.z * fbabs(p.normal.z);
+            if (signed_distance(p, center) < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace ftl
@@ -0,0 +1,257 @@
+#include "ftl/intersection.hpp"
+#include "ftl/lanes.hpp"
+
+using namespace ftl;
+using namespace ftl::internal;
+
+namespace {
+    // Direction components closer to zero than this are nudged away from it, so the reciprocal stays finite and
+    // the slab tests never compute inf - inf.
+    static constexpr f32 min_direction = 1e-30f;
+
+    FBINLINE f32 safe_reciprocal(f32 d) {
+        if (d < min_direction && d > -min_direction) {
+            d = d < 0.0f ? -min_direction : min_direction;
+        }
+        return 1.0f / d;
+    }
+
+    // Updates best from the lanes in hit_bits.
+    template <typename L>
+    FBINLINE void keep_nearest(typename L::reg t, u32 hit_bits, u32 base, ray_hit& best) {
+        if (!hit_bits) {
+            return;
+        }
+
+        f32 lanes[L::width];
+        L::store(lanes, t);
+
+        while (hit_bits) {
+            u32 lane = count_trailing_zeros(hit_bits);
+            if (lanes[lane] < best.t) {
+                best.t = lanes[lane];
+                best.index = base + lane;
+            }
+            hit_bits &= hit_bits - 1;
+        }
+    }
+
+    // Ray data splatted once per query.
+    template <typename L>
+    struct ray_lanes {
+        typename L::reg ox, oy, oz;
+        typename L::reg dx, dy, dz;
+        typename L::reg inv_dx, inv_dy, inv_dz;
+        typename L::reg abs_inv_dx, abs_inv_dy, abs_inv_dz;
+
+        explicit ray_lanes(const ray& r) {
+            ox = L::set(r.origin.x);
+            oy = L::set(r.origin.y);
+            oz = L::set(r.origin.z);
+            dx = L::set(r.direction.x);
+            dy = L::set(r.direction.y);
+            dz = L::set(r.direction.z);
+
+            f32 ix = safe_reciprocal(r.direction.x);
+            f32 iy = safe_reciprocal(r.direction.y);
+            f32 iz = safe_reciprocal(r.direction.z);
+            inv_dx = L::set(ix);
+            inv_dy = L::set(iy);
+            inv_dz = L::set(iz);
+            abs_inv_dx = L::set(ix < 0.0f ? -ix : ix);
+            abs_inv_dy = L::set(iy < 0.0f ? -iy : iy);
+            abs_inv_dz = L::set(iz < 0.0f ? -iz : iz);
+        }
+    };
+
+    template <typename L>
+    FBINLINE void aabbs_block(const ray_lanes<L>& r, const aabb_soa& boxes, u32 i, ray_hit& best) {
+        using reg = typename L::reg;
+
+        // Slab test in center and extent form: each slab is entered at t_center - t_half and left at t_center + t_half.
+        reg cx = L::mul(L::sub(L::load(boxes.center_x + i), r.ox), r.inv_dx);
+        reg cy = L::mul(L::sub(L::load(boxes.center_y + i), r.oy), r.inv_dy);
+        reg cz = L::mul(L::sub(L::load(boxes.center_z + i), r.oz), r.inv_dz);
+        reg hx = L::mul(L::load(boxes.extent_x + i), r.abs_inv_dx);
+        reg hy = L::mul(L::load(boxes.extent_y + i), r.abs_inv_dy);
+        reg hz = L::mul(L::load(boxes.extent_z + i), r.abs_inv_dz);
+
+        reg t_near = L::max(L::max(L::sub(cx, hx), L::sub(cy, hy)), L::max(L::sub(cz, hz), L::set(0.0f)));
+        reg t_far = L::min(L::min(L::add(cx, hx), L::add(cy, hy)), L::add(cz, hz));
+
+        u32 miss = L::bits(L::less(t_far, t_near));
+        u32 hit = L::bits(L::less(t_near, L::set(best.t))) & ~miss;
+
+        keep_nearest<L>(t_near, hit, i, best);
+    }
+
+    template <typename L>
+    FBINLINE void spheres_block(const ray_lanes<L>& r, typename L::reg a, typename L::reg inv_a, const sphere_soa& spheres, u32 i, ray_hit& best) {
+        using reg = typename L::reg;
+
+        reg ocx = L::sub(r.ox, L::load(spheres.x + i));
+        reg ocy = L::sub(r.oy, L::load(spheres.y + i));
+        reg ocz = L::sub(r.oz, L::load(spheres.z + i));
+        reg radius = L::load(spheres.radius + i);
+
+        // a * t^2 + 2 * b * t + c = 0
+        reg b = L::madd(ocx, r.dx, L::madd(ocy, r.dy, L::mul(ocz, r.dz)));
+        reg c = L::sub(L::madd(ocx, ocx, L::madd(ocy, ocy, L::mul(ocz, ocz))), L::mul(radius, radius));
+        reg discriminant = L::sub(L::mul(b, b), L::mul(a, c));
+
+        reg root = L::sqrt(L::max(discriminant, L::set(0.0f)));
+        reg t_enter = L::mul(L::sub(L::set(0.0f), L::add(b, root)), inv_a);
+        reg t_exit = L::mul(L::sub(root, b), inv_a);
+        reg t = L::select(L::less(t_enter, L::set(0.0f)), t_exit, t_enter);
+
+        u32 miss = L::bits(L::mask_or(L::less(discriminant, L::set(0.0f)), L::less(t, L::set(0.0f))));
+        u32 hit = L::bits(L::less(t, L::set(best.t))) & ~miss;
+
+        keep_nearest<L>(t, hit, i, best);
+    }
+
+    template <typename L>
+    FBINLINE void triangles_block(const ray_lanes<L>& r, typename L::reg min_det_scale, const triangle_soa& triangles, u32 i, ray_hit& best) {
+        using reg = typename L::reg;
+
+        // Moller-Trumbore.
+        reg e1x = L::load(triangles.edge1_x + i);
+        reg e1y = L::load(triangles.edge1_y + i);
+        reg e1z = L::load(triangles.edge1_z + i);
+        reg e2x = L::load(triangles.edge2_x + i);
+        reg e2y = L::load(triangles.edge2_y + i);
+        reg e2z = L::load(triangles.edge2_z + i);
+
+        // p = direction x edge2
+        reg px = L::sub(L::mul(r.dy, e2z), L::mul(r.dz, e2y));
+        reg py = L::sub(L::mul(r.dz, e2x), L::mul(r.dx, e2z));
+        reg pz = L::sub(L::mul(r.dx, e2y), L::mul(r.dy, e2x));
+
+        reg det = L::madd(e1x, px, L::madd(e1y, py, L::mul(e1z, pz)));
+        reg inv_det = L::div(L::set(1.0f), det);
+
+        reg sx = L::sub(r.ox, L::load(triangles.v0_x + i));
+        reg sy = L::sub(r.oy, L::load(triangles.v0_y + i));
+        reg sz = L::sub(r.oz, L::load(triangles.v0_z + i));
+
+        reg u = L::mul(L::madd(sx, px, L::madd(sy, py, L::mul(sz, pz))), inv_det);
+
+        // q = s x edge1
+        reg qx = L::sub(L::mul(sy, e1z), L::mul(sz, e1y));
+        reg qy = L::sub(L::mul(sz, e1x), L::mul(sx, e1z));
+        reg qz = L::sub(L::mul(sx, e1y), L::mul(sy, e1x));
+
+        reg v = L::mul(L::madd(r.dx, qx, L::madd(r.dy, qy, L::mul(r.dz, qz))), inv_det);
+        reg t = L::mul(L::madd(e2x, qx, L::madd(e2y, qy, L::mul(e2z, qz))), inv_det);
+
+        reg zero = L::set(0.0f);
+        u32 miss = L::bits(L::mask_or(L::mask_or(L::less(u, zero), L::less(v, zero)), L::greater(L::add(u, v), L::set(1.0f))));
+        // The determinant scales with |direction||edge1||edge2|, so rays parallel to the plane and degenerate
+        // triangles are rejected relative to that, compared squared to skip the square roots.
+        reg e1_sq = L::madd(e1x, e1x, L::madd(e1y, e1y, L::mul(e1z, e1z)));
+        reg e2_sq = L::madd(e2x, e2x, L::madd(e2y, e2y, L::mul(e2z, e2z)));
+        reg min_det_sq = L::mul(min_det_scale, L::mul(e1_sq, e2_sq));
+        u32 valid = L::bits(L::mask_and(L::greater(L::mul(det, det), min_det_sq), L::greater(t, zero)));
+        u32 hit = L::bits(L::less(t, L::set(best.t))) & valid & ~miss;
+
+        keep_nearest<L>(t, hit, i, best);
+    }
+
+    template <typename L>
+    FBINLINE typename L::reg reciprocal_lanes(typename L::reg d) {
+        typename L::reg nudged = L::flip_sign(L::set(min_direction), d);
+        typename L::reg safe = L::select(L::less(L::flip_sign(d, d), L::set(min_direction)), nudged, d);
+        return L::div(L::set(1.0f), safe);
+    }
+
+    template <typename L>
+    FBINLINE void rays_block(const ray_soa& rays, u32 i, const vec3f& center, const vec3f& extent, f32* t) {
+        using reg = typename L::reg;
+
+        reg inv_dx = reciprocal_lanes<L>(L::load(rays.direction_x + i));
+        reg inv_dy = reciprocal_lanes<L>(L::load(rays.direction_y + i));
+        reg inv_dz = reciprocal_lanes<L>(L::load(rays.direction_z + i));
+
+        reg cx = L::mul(L::sub(L::set(center.x), L::load(rays.origin_x + i)), inv_dx);
+        reg cy = L::mul(L::sub(L::set(center.y), L::load(rays.origin_y + i)), inv_dy);
+        reg cz = L::mul(L::sub(L::set(center.z), L::load(rays.origin_z + i)), inv_dz);
+        reg hx = L::mul(L::set(extent.x), L::flip_sign(inv_dx, inv_dx));
+        reg hy = L::mul(L::set(extent.y), L::flip_sign(inv_dy, inv_dy));
+        reg hz = L::mul(L::set(extent.z), L::flip_sign(inv_dz, inv_dz));
+
+        reg t_near = L::max(L::max(L::sub(cx, hx), L::sub(cy, hy)), L::max(L::sub(cz, hz), L::set(0.0f)));
+        reg t_far = L::min(L::min(L::add(cx, hx), L::add(cy, hy)), L::add(cz, hz));
+
+        L::store(t + i, L::select(L::less(t_far, t_near), L::set(FB_INFINITY), t_near));
+    }
+}  // namespace
+
+ray_hit ftl::intersect_aabbs(const ray& r, const aabb_soa& boxes, u32 count, f32 max_t) {
+    ray_hit best = {max_t, invalid_u32};
+    u32 i = 0;
+
+    ray_lanes<lanes_wide> wide(r);
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        aabbs_block(wide, boxes, i, best);
+    }
+
+    ray_lanes<lanes_scalar> scalar(r);
+    for (; i < count; i++) {
+        aabbs_block(scalar, boxes, i, best);
+    }
+
+    return best;
+}
+
+ray_hit ftl::intersect_spheres(const ray& r, const sphere_soa& spheres, u32 count, f32 max_t) {
+    ray_hit best = {max_t, invalid_u32};
+    u32 i = 0;
+
+    f32 a = dot(r.direction, r.direction);
+    f32 inv_a = 1.0f / a;
+
+    ray_lanes<lanes_wide> wide(r);
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        spheres_block(wide, lanes_wide::set(a), lanes_wide::set(inv_a), spheres, i, best);
+    }
+
+    ray_lanes<lanes_scalar> scalar(r);
+    for (; i < count; i++) {
+        spheres_block(scalar, a, inv_a, spheres, i, best);
+    }
+
+    return best;
+}
+
+ray_hit ftl::intersect_triangles(const ray& r, const triangle_soa& triangles, u32 count, f32 max_t) {
+    ray_hit best = {max_t, invalid_u32};
+    u32 i = 0;
+
+    f32 min_det_scale = FB_FLOAT_EPSILON * FB_FLOAT_EPSILON * dot(r.direction, r.direction);
+
+    ray_lanes<lanes_wide> wide(r);
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        triangles_block(wide, lanes_wide::set(min_det_scale), triangles, i, best);
+    }
+
+    ray_lanes<lanes_scalar> scalar(r);
+    for (; i < count; i++) {
+        triangles_block(scalar, min_det_scale, triangles, i, best);
+    }
+
+    return best;
+}
+
+void ftl::intersect_rays(const ray_soa& rays, u32 count, const aabb& box, f32* t) {
+    vec3f center = (box.min + box.max) * 0.5f;
+    vec3f extent = (box.max - box.min) * 0.5f;
+    u32 i = 0;
+
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        rays_block<lanes_wide>(rays, i, center, extent, t);
+    }
+
+    for (; i < count; i++) {
+        rays_block<lanes_scalar>(rays, i, center, extent, t);
+    }
+}
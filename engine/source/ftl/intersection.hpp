@@ -0,0 +1,24 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/geometry.hpp"
+
+// NOTE: The batch queries test one ray against count primitives stored as SoA and return the nearest hit with
+//       t in [0, max_t). Rays starting inside a box or sphere hit it at t = 0 for boxes and at the exit point for
+//       spheres. 8 primitives are tested per iteration with AVX, 4 with SSE.
+
+namespace ftl {
+    struct ray_hit {
+        f32 t;
+        // invalid_u32 when nothing was hit.
+        u32 index;
+    };
+
+    FBAPI ray_hit intersect_aabbs(const ray& r, const aabb_soa& boxes, u32 count, f32 max_t = FB_INFINITY);
+    FBAPI ray_hit intersect_spheres(const ray& r, const sphere_soa& spheres, u32 count, f32 max_t = FB_INFINITY);
+    // Both faces count as hits.
+    FBAPI ray_hit intersect_triangles(const ray& r, const triangle_soa& triangles, u32 count, f32 max_t = FB_INFINITY);
+
+    // Ray packet against one box: t[i] receives the entry distance of ray i, or FB_INFINITY when it misses.
+    FBAPI void intersect_rays(const ray_soa& rays, u32 count, const aabb& box, f32* t);
+}  // namespace ftl
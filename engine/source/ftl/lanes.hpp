@@ -0,0 +1,125 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/math.hpp"
+#include "ftl/simd.hpp"
+
+// NOTE: Lane wrappers let a batch kernel be written once as a template and instantiated for 8 (AVX), 4 (SSE) and
+//       1 (scalar tail) elements per step. Masks are whatever the register width uses for per-lane conditions;
+//       bits() turns a mask into one bit per lane, lowest lane first.
+
+namespace ftl {
+    namespace internal {
+        struct lanes_scalar {
+            using reg = f32;
+            using mask = b8;
+            static constexpr u64 width = 1;
+
+            static FBINLINE reg load(const f32* p) { return *p; }
+            static FBINLINE void store(f32* p, reg v) { *p = v; }
+            static FBINLINE reg set(f32 v) { return v; }
+            static FBINLINE reg add(reg a, reg b) { return a + b; }
+            static FBINLINE reg sub(reg a, reg b) { return a - b; }
+            static FBINLINE reg mul(reg a, reg b) { return a * b; }
+            static FBINLINE reg div(reg a, reg b) { return a / b; }
+            static FBINLINE reg madd(reg a, reg b, reg c) { return a * b + c; }
+            static FBINLINE reg min(reg a, reg b) { return a < b ? a : b; }
+            static FBINLINE reg max(reg a, reg b) { return a > b ? a : b; }
+            static FBINLINE reg sqrt(reg v) { return fbsqrt(v); }
+            // Negates v where sign is negative.
+            static FBINLINE reg flip_sign(reg v, reg sign) { return sign < 0.0f ? -v : v; }
+            static FBINLINE mask greater(reg a, reg b) { return a > b; }
+            static FBINLINE mask less(reg a, reg b) { return a < b; }
+            static FBINLINE mask mask_and(mask a, mask b) { return a && b; }
+            static FBINLINE mask mask_or(mask a, mask b) { return a || b; }
+            static FBINLINE u32 bits(mask m) { return m ? 1u : 0u; }
+            static FBINLINE reg select(mask m, reg if_true, reg if_false) { return m ? if_true : if_false; }
+            static FBINLINE void sincos(reg v, reg& s, reg& c) { fbsincos(v, s, c); }
+            static FBINLINE reg acos(reg v) { return fbacos(v); }
+        };
+
+#if FBSIMD_SSE2
+        struct lanes_sse {
+            using reg = __m128;
+            using mask = __m128;
+            static constexpr u64 width = 4;
+
+            static FBINLINE reg load(const f32* p) { return _mm_loadu_ps(p); }
+            static FBINLINE void store(f32* p, reg v) { _mm_storeu_ps(p, v); }
+            static FBINLINE reg set(f32 v) { return _mm_set1_ps(v); }
+            static FBINLINE reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+            static FBINLINE reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+            static FBINLINE reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+            static FBINLINE reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+            static FBINLINE reg madd(reg a, reg b, reg c) { return internal::madd(a, b, c); }
+            static FBINLINE reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+            static FBINLINE reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+            static FBINLINE reg sqrt(reg v) { return _mm_sqrt_ps(v); }
+            static FBINLINE reg flip_sign(reg v, reg sign) { return _mm_xor_ps(v, _mm_and_ps(sign, _mm_set1_ps(-0.0f))); }
+            static FBINLINE mask greater(reg a, reg b) { return _mm_cmpgt_ps(a, b); }
+            static FBINLINE mask less(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+            static FBINLINE mask mask_and(mask a, mask b) { return _mm_and_ps(a, b); }
+            static FBINLINE mask mask_or(mask a, mask b) { return _mm_or_ps(a, b); }
+            static FBINLINE u32 bits(mask m) { return (u32)_mm_movemask_ps(m); }
+            static FBINLINE reg select(mask m, reg if_true, reg if_false) { return _mm_or_ps(_mm_and_ps(m, if_true), _mm_andnot_ps(m, if_false)); }
+            static FBINLINE void sincos(reg v, reg& s, reg& c) { fbsincos4(v, s, c); }
+            static FBINLINE reg acos(reg v) { return fbacos4(v); }
+        };
+#endif
+
+#if FBSIMD_AVX
+        struct lanes_avx {
+            using reg = __m256;
+            using mask = __m256;
+            static constexpr u64 width = 8;
+
+            static FBINLINE reg load(const f32* p) { return _mm256_loadu_ps(p); }
+            static FBINLINE void store(f32* p, reg v) { _mm256_storeu_ps(p, v); }
+            static FBINLINE reg set(f32 v) { return _mm256_set1_ps(v); }
+            static FBINLINE reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static FBINLINE reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static FBINLINE reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static FBINLINE reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+            static FBINLINE reg madd(reg a, reg b, reg c) {
+#if FBSIMD_FMA
+                return _mm256_fmadd_ps(a, b, c);
+#else
+                return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+            }
+            static FBINLINE reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+            static FBINLINE reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+            static FBINLINE reg sqrt(reg v) { return _mm256_sqrt_ps(v); }
+            static FBINLINE reg flip_sign(reg v, reg sign) { return _mm256_xor_ps(v, _mm256_and_ps(sign, _mm256_set1_ps(-0.0f))); }
+            static FBINLINE mask greater(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+            static FBINLINE mask less(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            static FBINLINE mask mask_and(mask a, mask b) { return _mm256_and_ps(a, b); }
+            static FBINLINE mask mask_or(mask a, mask b) { return _mm256_or_ps(a, b); }
+            static FBINLINE u32 bits(mask m) { return (u32)_mm256_movemask_ps(m); }
+            static FBINLINE reg select(mask m, reg if_true, reg if_false) { return _mm256_blendv_ps(if_false, if_true, m); }
+#if FBSIMD_AVX2
+            static FBINLINE void sincos(reg v, reg& s, reg& c) { fbsincos8(v, s, c); }
+            static FBINLINE reg acos(reg v) { return fbacos8(v); }
+#endif
+        };
+#endif
+
+        // Widest wrapper available in this build.
+#if FBSIMD_AVX
+        using lanes_wide = lanes_avx;
+#elif FBSIMD_SSE2
+        using lanes_wide = lanes_sse;
+#else
+        using lanes_wide = lanes_scalar;
+#endif
+
+        // Appends base + lane for every set bit of lane_bits and returns the new count.
+        FBINLINE u64 append_indices(u32* out, u64 count, u32 base, u32 lane_bits) {
+            while (lane_bits) {
+                out[count++] = base + count_trailing_zeros(lane_bits);
+                lane_bits &= lane_bits - 1;
+            }
+            return count;
+        }
+    }  // namespace internal
+}  // namespace ftl
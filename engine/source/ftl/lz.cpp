@@ -0,0 +1,175 @@
+#include "ftl/lz.hpp"
+
+#include <string.h>
+
+using namespace ftl;
+
+namespace {
+    static constexpr u32 hash_bits = 12;
+    static constexpr u32 min_match = 4;
+    static constexpr u64 max_offset = 65535;
+    // The format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end.
+    static constexpr u64 last_literals = 5;
+    static constexpr u64 match_margin = 12;
+
+    FBINLINE u32 read_u32(const u8* p) {
+        u32 value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    FBINLINE u32 hash(u32 sequence) {
+        return (sequence * 2654435761U) >> (32 - hash_bits);
+    }
+
+    // Lengths past the token's 4 bits continue in bytes of 255 and a final remainder.
+    FBINLINE u8* write_length(u8* out, u64 length) {
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = (u8)length;
+        return out;
+    }
+
+    u8* write_sequence(u8* out, const u8* literals, u64 literal_count, u64 offset, u64 match_length) {
+        u8* token = out++;
+        *token = (u8)((literal_count >= 15 ? 15 : literal_count) << 4);
+        if (literal_count >= 15) {
+            out = write_length(out, literal_count - 15);
+        }
+
+        if (literal_count > 0) {
+            memcpy(out, literals, literal_count);
+            out += literal_count;
+        }
+
+        // The final sequence is literals only.
+        if (match_length == 0) {
+            return out;
+        }
+
+        *out++ = (u8)offset;
+        *out++ = (u8)(offset >> 8);
+
+        u64 length = match_length - min_match;
+        *token |= (u8)(length >= 15 ? 15 : length);
+        if (length >= 15) {
+            out = write_length(out, length - 15);
+        }
+
+        return out;
+    }
+
+    // Returns false when the length runs past end.
+    FBINLINE b8 read_length(const u8*& in, const u8* end, u64& length) {
+        u8 byte;
+        do {
+            if (in >= end) {
+                return false;
+            }
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+
+        return true;
+    }
+}  // namespace
+
+u64 ftl::lz_compress(const void* source, u64 size, void* destination, u64 capacity) {
+    if (capacity < lz_compress_bound(size) || size > 0xFFFFFFFFULL) {
+        return 0;
+    }
+
+    const u8* base = (const u8*)source;
+    const u8* end = base + size;
+    const u8* anchor = base;
+    u8* out = (u8*)destination;
+
+    if (size > match_margin) {
+        // Positions of the last sequence seen with each hash.
+        u32 table[1 << hash_bits] = {};
+        const u8* match_limit = end - match_margin;
+        const u8* ip = base + 1;
+
+        while (ip < match_limit) {
+            u32 sequence = read_u32(ip);
+            u32 h = hash(sequence);
+            const u8* ref = base + table[h];
+            table[h] = (u32)(ip - base);
+
+            if (ref >= ip || (u64)(ip - ref) > max_offset || read_u32(ref) != sequence) {
+                ip++;
+                continue;
+            }
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            u64 length = min_match;
+            while (ip + length < end - last_literals && ip[length] == ref[length]) {
+                length++;
+            }
+
+            out = write_sequence(out, anchor, (u64)(ip - anchor), (u64)(ip - ref), length);
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    out = write_sequence(out, anchor, (u64)(end - anchor), 0, 0);
+    return (u64)(out - (u8*)destination);
+}
+
+u64 ftl::lz_decompress(const void* source, u64 size, void* destination, u64 capacity) {
+    const u8* in = (const u8*)source;
+    const u8* in_end = in + size;
+    u8* out = (u8*)destination;
+    u8* out_end = out + capacity;
+
+    while (in < in_end) {
+        u8 token = *in++;
+
+        u64 literal_count = token >> 4;
+        if (literal_count == 15 && !read_length(in, in_end, literal_count)) {
+            return invalid_u64;
+        }
+        if (literal_count > (u64)(in_end - in) || literal_count > (u64)(out_end - out)) {
+            return invalid_u64;
+        }
+
+        memcpy(out, in, literal_count);
+        in += literal_count;
+        out += literal_count;
+
+        if (in == in_end) {
+            break;
+        }
+
+        if (in_end - in < 2) {
+            return invalid_u64;
+        }
+        u64 offset = (u64)in[0] | ((u64)in[1] << 8);
+        in += 2;
+
+        u64 length = token & 15;
+        if (length == 15 && !read_length(in, in_end, length)) {
+            return invalid_u64;
+        }
+        length += min_match;
+
+        if (offset == 0 || offset > (u64)(out - (u8*)destination) || length > (u64)(out_end - out)) {
+            return invalid_u64;
+        }
+
+        // Matches may overlap their own output, so this copies forward a byte at a time.
+        const u8* ref = out - offset;
+        for (u64 i = 0; i < length; i++) {
+            out[i] = ref[i];
+        }
+        out += length;
+    }
+
+    return (u64)(out - (u8*)destination);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "defines.hpp"
+
+// NOTE: Byte oriented LZ77 compression in the LZ4 block format: fast greedy matching through a 4096 entry hash
+//       table of 4 byte sequences, with 64 KiB back-references. Text such as logs typically shrinks 3 to 5 times.
+//       Blocks carry no sizes or checksums, callers store those themselves.
+
+namespace ftl {
+    // Worst case compressed size of size bytes.
+    FBINLINE u64 lz_compress_bound(u64 size) { return size + size / 255 + 16; }
+
+    // Returns the compressed size, 0 when capacity is below lz_compress_bound(size). Sizes up to 4 GiB.
+    FBAPI u64 lz_compress(const void* source, u64 size, void* destination, u64 capacity);
+    // Returns the decompressed size, invalid_u64 when the block is malformed or doesn't fit in capacity.
+    FBAPI u64 lz_decompress(const void* source, u64 size, void* destination, u64 capacity);
+}  // namespace ftl
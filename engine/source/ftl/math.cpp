@@ -1,55 +1,34 @@
 #include "ftl/math.hpp"
-#include "platform/platform.hpp"
+#include "ftl/random.hpp"
 
-using namespace fabric;
+using namespace ftl;
 
 #include <math.h>
-#include <stdlib.h>
-
-f32 ftl::fbsin(f32 x) {
-    return sinf(x);
-}
-
-f32 ftl::fbcos(f32 x) {
-    return cosf(x);
-}
-
-f32 ftl::fbtan(f32 x) {
-    return tanf(x);
-}
-
-f32 ftl::fbacos(f32 x) {
-    return acosf(x);
-}
-
-f32 ftl::fbsqrt(f32 x) {
-    return sqrtf(x);
-}
 
 f32 ftl::fbabs(f32 x) {
     return fabsf(x);
 }
 
 i32 ftl::internal::fbrandom(u32 seed, i32 min, i32 max) {
-    u32 rng_seed = seed;
-    if (seed == -1) {
-        rng_seed = (u32)platform::get_absolute_time();
-    }
-    srand(rng_seed);
+    rng seeded_generator(seed);
+    rng& generator = seed == (u32)-1 ? thread_rng() : seeded_generator;
 
     if (max != min) {
-        return (rand() % (max - min + 1)) + min;
+        return generator.range(min, max);
     }
 
-    return rand();
+    return (i32)(generator.next_u32() >> 1);
 }
 
 f32 ftl::internal::fbrandom(u32 seed, f32 min, f32 max) {
+    rng seeded_generator(seed);
+    rng& generator = seed == (u32)-1 ? thread_rng() : seeded_generator;
+
     if ((max - min) > FB_FLOAT_EPSILON) {
-        return min + ((f32)ftl::internal::fbrandom(seed, (i32)min, (i32)max) / ((f32)RAND_MAX / (max - min)));
+        return generator.range(min, max);
     }
 
-    return (f32)ftl::internal::fbrandom(seed, (i32)min, (i32)max) / (f32)RAND_MAX;
+    return generator.next_f32();
 }
 
 u64 ftl::max(u64 val1, u64 val2) {
@@ -0,0 +1,462 @@
+#include "ftl/math_batch.hpp"
+#include "ftl/lanes.hpp"
+
+using namespace ftl;
+using namespace ftl::internal;
+
+namespace {
+#if FBSIMD_AVX
+    FBINLINE __m256 madd8(__m256 a, __m256 b, __m256 c) {
+#if FBSIMD_FMA
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    // Two result rows of a * b, one per 128-bit lane of a_rows. Same operations as mat4::operator*.
+    FBINLINE __m256 mul_rows2(__m256 a_rows, __m256 b0, __m256 b1, __m256 b2, __m256 b3) {
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(a_rows, 0x00), b0);
+        r = madd8(_mm256_permute_ps(a_rows, 0x55), b1, r);
+        r = madd8(_mm256_permute_ps(a_rows, 0xAA), b2, r);
+        return madd8(_mm256_permute_ps(a_rows, 0xFF), b3, r);
+    }
+
+    // Two products per call. Both are loaded before either is stored, which the compiler can't do by itself
+    // because out may alias the next inputs.
+    template <b8 stream>
+    FBINLINE void multiply_mat4x2(const f32* a, const f32* b, f32* out) {
+        __m256 r[4];
+        for (u32 m = 0; m < 2; m++) {
+            const f32* bm = b + m * 16;
+            __m256 b0 = _mm256_broadcast_ps((const __m128*)(bm + 0));
+            __m256 b1 = _mm256_broadcast_ps((const __m128*)(bm + 4));
+            __m256 b2 = _mm256_broadcast_ps((const __m128*)(bm + 8));
+            __m256 b3 = _mm256_broadcast_ps((const __m128*)(bm + 12));
+            r[m * 2 + 0] = mul_rows2(_mm256_loadu_ps(a + m * 16 + 0), b0, b1, b2, b3);
+            r[m * 2 + 1] = mul_rows2(_mm256_loadu_ps(a + m * 16 + 8), b0, b1, b2, b3);
+        }
+
+        for (u32 j = 0; j < 4; j++) {
+            if constexpr (stream) {
+                _mm256_stream_ps(out + j * 8, r[j]);
+            } else {
+                _mm256_storeu_ps(out + j * 8, r[j]);
+            }
+        }
+    }
+
+    static constexpr u64 stream_alignment = 32;
+
+    // Loads 8 packed vec3f and returns them as SoA registers.
+    FBINLINE void load_vec3x8(const f32* p, __m256& x, __m256& y, __m256& z) {
+        __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 0)), _mm_loadu_ps(p + 12), 1);
+        __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+        __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+
+        __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+        __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+        x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+    }
+
+    FBINLINE void store_vec3x8(f32* p, __m256 x, __m256 y, __m256 z) {
+        __m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm_storeu_ps(p + 0, _mm256_castps256_ps128(r03));
+        _mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+        _mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+        _mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+        _mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+        _mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+    }
+#elif FBSIMD_SSE2
+    // Two products per call, see the AVX version.
+    template <b8 stream>
+    FBINLINE void multiply_mat4x2(const f32* a, const f32* b, f32* out) {
+        __m128 r[8];
+        for (u32 m = 0; m < 2; m++) {
+            const f32* bm = b + m * 16;
+            __m128 b0 = _mm_loadu_ps(bm + 0);
+            __m128 b1 = _mm_loadu_ps(bm + 4);
+            __m128 b2 = _mm_loadu_ps(bm + 8);
+            __m128 b3 = _mm_loadu_ps(bm + 12);
+            for (u32 j = 0; j < 4; j++) {
+                r[m * 4 + j] = internal::mul_vec4_rows(_mm_loadu_ps(a + m * 16 + j * 4), b0, b1, b2, b3);
+            }
+        }
+
+        for (u32 j = 0; j < 8; j++) {
+            if constexpr (stream) {
+                _mm_stream_ps(out + j * 4, r[j]);
+            } else {
+                _mm_storeu_ps(out + j * 4, r[j]);
+            }
+        }
+    }
+
+    static constexpr u64 stream_alignment = 16;
+
+    // Loads 4 packed vec3f and returns them as SoA registers.
+    FBINLINE void load_vec3x4(const f32* p, __m128& x, __m128& y, __m128& z) {
+        __m128 m0 = _mm_loadu_ps(p + 0);
+        __m128 m1 = _mm_loadu_ps(p + 4);
+        __m128 m2 = _mm_loadu_ps(p + 8);
+
+        __m128 xy = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));
+        __m128 yz = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 0, 2, 1));
+        x = _mm_shuffle_ps(m0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        z = _mm_shuffle_ps(yz, m2, _MM_SHUFFLE(3, 0, 3, 1));
+    }
+
+    FBINLINE void store_vec3x4(f32* p, __m128 x, __m128 y, __m128 z) {
+        __m128 rxy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ryz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 rzx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm_storeu_ps(p + 0, _mm_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(p + 4, _mm_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm_storeu_ps(p + 8, _mm_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+
+#if FBSIMD_SSE2
+    // Outputs at least this large are written with non-temporal stores. They can't stay in the cache anyway, and
+    // skipping the read of each destination line before it is overwritten saves a third of the memory traffic.
+    static constexpr u64 stream_threshold = 8 * 1024 * 1024;
+
+    template <b8 stream>
+    void multiply_mat4s(const mat4* a, const mat4* b, mat4* out, u64 count) {
+        u64 i = 0;
+        for (; i + 2 <= count; i += 2) {
+            multiply_mat4x2<stream>(a[i].mat, b[i].mat, out[i].mat);
+        }
+
+        if (i < count) {
+            out[i] = a[i] * b[i];
+        }
+
+        if constexpr (stream) {
+            // Non-temporal stores aren't ordered with the ones that follow, fence them before returning.
+            _mm_sfence();
+        }
+    }
+#endif
+
+    FBINLINE void transform_point(const f32* m, f32 x, f32 y, f32 z, f32& ox, f32& oy, f32& oz) {
+        ox = x * m[0] + y * m[4] + z * m[8] + m[12];
+        oy = x * m[1] + y * m[5] + z * m[9] + m[13];
+        oz = x * m[2] + y * m[6] + z * m[10] + m[14];
+    }
+
+    template <typename L>
+    struct quat_lanes {
+        typename L::reg x, y, z, w;
+    };
+
+    template <typename L>
+    FBINLINE quat_lanes<L> load_quat(const quat_soa& q, u64 i) {
+        return {L::load(q.x + i), L::load(q.y + i), L::load(q.z + i), L::load(q.w + i)};
+    }
+
+    template <typename L>
+    FBINLINE void store_quat(const quat_soa& q, u64 i, const quat_lanes<L>& v) {
+        L::store(q.x + i, v.x);
+        L::store(q.y + i, v.y);
+        L::store(q.z + i, v.z);
+        L::store(q.w + i, v.w);
+    }
+
+    template <typename L>
+    FBINLINE typename L::reg dot_lanes(const quat_lanes<L>& a, const quat_lanes<L>& b) {
+        return L::madd(a.x, b.x, L::madd(a.y, b.y, L::madd(a.z, b.z, L::mul(a.w, b.w))));
+    }
+
+    template <typename L>
+    FBINLINE quat_lanes<L> normalize_lanes(const quat_lanes<L>& q) {
+        typename L::reg inv_length = L::div(L::set(1.0f), L::sqrt(dot_lanes(q, q)));
+        return {L::mul(q.x, inv_length), L::mul(q.y, inv_length), L::mul(q.z, inv_length), L::mul(q.w, inv_length)};
+    }
+
+    // Negates b where it lies in the other hemisphere than a, so blends take the shortest path.
+    template <typename L>
+    FBINLINE quat_lanes<L> same_hemisphere(const quat_lanes<L>& b, typename L::reg d) {
+        return {L::flip_sign(b.x, d), L::flip_sign(b.y, d), L::flip_sign(b.z, d), L::flip_sign(b.w, d)};
+    }
+
+    template <typename L>
+    FBINLINE quat_lanes<L> lerp_lanes(const quat_lanes<L>& a, const quat_lanes<L>& b, typename L::reg t) {
+        return {L::madd(L::sub(b.x, a.x), t, a.x), L::madd(L::sub(b.y, a.y), t, a.y),
+                L::madd(L::sub(b.z, a.z), t, a.z), L::madd(L::sub(b.w, a.w), t, a.w)};
+    }
+
+    template <typename L>
+    FBINLINE void multiply_block(const quat_soa& a, const quat_soa& b, const quat_soa& out, u64 i) {
+        quat_lanes<L> p = load_quat<L>(a, i);
+        quat_lanes<L> q = load_quat<L>(b, i);
+
+        // Same product as quat::operator*.
+        quat_lanes<L> r;
+        r.x = L::add(L::sub(L::madd(p.x, q.w, L::mul(p.y, q.z)), L::mul(p.z, q.y)), L::mul(p.w, q.x));
+        r.y = L::add(L::sub(L::madd(p.y, q.w, L::mul(p.z, q.x)), L::mul(p.x, q.z)), L::mul(p.w, q.y));
+        r.z = L::add(L::sub(L::madd(p.x, q.y, L::mul(p.z, q.w)), L::mul(p.y, q.x)), L::mul(p.w, q.z));
+        r.w = L::sub(L::mul(p.w, q.w), L::madd(p.x, q.x, L::madd(p.y, q.y, L::mul(p.z, q.z))));
+
+        store_quat<L>(out, i, r);
+    }
+
+    template <typename L>
+    FBINLINE void normalize_block(const quat_soa& in, const quat_soa& out, u64 i) {
+        store_quat<L>(out, i, normalize_lanes<L>(load_quat<L>(in, i)));
+    }
+
+    template <typename L>
+    FBINLINE void nlerp_block(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 i) {
+        quat_lanes<L> p = load_quat<L>(a, i);
+        quat_lanes<L> q = load_quat<L>(b, i);
+        q = same_hemisphere<L>(q, dot_lanes<L>(p, q));
+
+        store_quat<L>(out, i, normalize_lanes<L>(lerp_lanes<L>(p, q, L::load(t + i))));
+    }
+
+    template <typename L>
+    FBINLINE void slerp_block(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 i) {
+        using reg = typename L::reg;
+
+        quat_lanes<L> p = load_quat<L>(a, i);
+        quat_lanes<L> q = load_quat<L>(b, i);
+        reg weight = L::load(t + i);
+
+        reg d = dot_lanes<L>(p, q);
+        q = same_hemisphere<L>(q, d);
+        d = L::flip_sign(d, d);
+
+        reg theta = L::mul(L::acos(d), weight);
+        reg s, c;
+        L::sincos(theta, s, c);
+
+        // sin(acos(d)) = sqrt(1 - d^2)
+        reg s1 = L::div(s, L::sqrt(L::sub(L::set(1.0f), L::mul(d, d))));
+        reg s0 = L::sub(c, L::mul(d, s1));
+
+        quat_lanes<L> r;
+        r.x = L::madd(p.x, s0, L::mul(q.x, s1));
+        r.y = L::madd(p.y, s0, L::mul(q.y, s1));
+        r.z = L::madd(p.z, s0, L::mul(q.z, s1));
+        r.w = L::madd(p.w, s0, L::mul(q.w, s1));
+
+        // Nearly parallel inputs divide by almost zero above, those lanes use nlerp instead (same threshold as ftl::slerp).
+        typename L::mask parallel = L::greater(d, L::set(0.9995f));
+        quat_lanes<L> n = normalize_lanes<L>(lerp_lanes<L>(p, q, weight));
+        r.x = L::select(parallel, n.x, r.x);
+        r.y = L::select(parallel, n.y, r.y);
+        r.z = L::select(parallel, n.z, r.z);
+        r.w = L::select(parallel, n.w, r.w);
+
+        store_quat<L>(out, i, r);
+    }
+
+    template <typename L>
+    FBINLINE void slerp_fast_block(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 i) {
+        using reg = typename L::reg;
+
+        quat_lanes<L> p = load_quat<L>(a, i);
+        quat_lanes<L> q = load_quat<L>(b, i);
+        reg weight = L::load(t + i);
+
+        reg d = dot_lanes<L>(p, q);
+        q = same_hemisphere<L>(q, d);
+        d = L::flip_sign(d, d);
+
+        // Polynomial fit of the t correction that turns nlerp into an approximate slerp:
+        // t' = t + t * (t - 0.5) * (t - 1) * (A(d) * (t - 0.5)^2 + B(d))
+        reg fa = L::madd(d, L::set(-1.43519f), L::set(3.55645f));
+        fa = L::madd(d, fa, L::set(-3.2452f));
+        fa = L::madd(d, fa, L::set(1.0904f));
+        reg fb = L::madd(d, L::set(0.215638f), L::set(-1.06021f));
+        fb = L::madd(d, fb, L::set(0.848013f));
+
+        reg centered = L::sub(weight, L::set(0.5f));
+        reg k = L::madd(L::mul(fa, centered), centered, fb);
+        reg corrected = L::madd(L::mul(L::mul(weight, centered), L::sub(weight, L::set(1.0f))), k, weight);
+
+        store_quat<L>(out, i, normalize_lanes<L>(lerp_lanes<L>(p, q, corrected)));
+    }
+}  // namespace
+
+void ftl::transform_points(const mat4& matrix, const vec3f* in, vec3f* out, u64 count) {
+    const f32* m = matrix.mat;
+    const f32* src = (const f32*)in;
+    f32* dst = (f32*)out;
+    u64 i = 0;
+
+#if FBSIMD_AVX
+    __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+    __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+    __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+    __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x, y, z;
+        load_vec3x8(src + i * 3, x, y, z);
+
+        __m256 ox = madd8(x, m0, madd8(y, m4, madd8(z, m8, m12)));
+        __m256 oy = madd8(x, m1, madd8(y, m5, madd8(z, m9, m13)));
+        __m256 oz = madd8(x, m2, madd8(y, m6, madd8(z, m10, m14)));
+
+        store_vec3x8(dst + i * 3, ox, oy, oz);
+    }
+#elif FBSIMD_SSE2
+    __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+    __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+    __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+    __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load_vec3x4(src + i * 3, x, y, z);
+
+        __m128 ox = internal::madd(x, m0, internal::madd(y, m4, internal::madd(z, m8, m12)));
+        __m128 oy = internal::madd(x, m1, internal::madd(y, m5, internal::madd(z, m9, m13)));
+        __m128 oz = internal::madd(x, m2, internal::madd(y, m6, internal::madd(z, m10, m14)));
+
+        store_vec3x4(dst + i * 3, ox, oy, oz);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const f32* p = src + i * 3;
+        f32* o = dst + i * 3;
+        transform_point(m, p[0], p[1], p[2], o[0], o[1], o[2]);
+    }
+}
+
+void ftl::transform_points(const mat4& matrix, const vec3_soa& in, const vec3_soa& out, u64 count) {
+    const f32* m = matrix.mat;
+    u64 i = 0;
+
+#if FBSIMD_AVX
+    __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+    __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+    __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+    __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in.x + i);
+        __m256 y = _mm256_loadu_ps(in.y + i);
+        __m256 z = _mm256_loadu_ps(in.z + i);
+
+        _mm256_storeu_ps(out.x + i, madd8(x, m0, madd8(y, m4, madd8(z, m8, m12))));
+        _mm256_storeu_ps(out.y + i, madd8(x, m1, madd8(y, m5, madd8(z, m9, m13))));
+        _mm256_storeu_ps(out.z + i, madd8(x, m2, madd8(y, m6, madd8(z, m10, m14))));
+    }
+#elif FBSIMD_SSE2
+    __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+    __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+    __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+    __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(in.x + i);
+        __m128 y = _mm_loadu_ps(in.y + i);
+        __m128 z = _mm_loadu_ps(in.z + i);
+
+        _mm_storeu_ps(out.x + i, internal::madd(x, m0, internal::madd(y, m4, internal::madd(z, m8, m12))));
+        _mm_storeu_ps(out.y + i, internal::madd(x, m1, internal::madd(y, m5, internal::madd(z, m9, m13))));
+        _mm_storeu_ps(out.z + i, internal::madd(x, m2, internal::madd(y, m6, internal::madd(z, m10, m14))));
+    }
+#endif
+
+    for (; i < count; i++) {
+        transform_point(m, in.x[i], in.y[i], in.z[i], out.x[i], out.y[i], out.z[i]);
+    }
+}
+
+void ftl::multiply(const mat4* a, const mat4* b, mat4* out, u64 count) {
+#if FBSIMD_SSE2
+    if (count * sizeof(mat4) >= stream_threshold && (u64)out % stream_alignment == 0) {
+        multiply_mat4s<true>(a, b, out, count);
+    } else {
+        multiply_mat4s<false>(a, b, out, count);
+    }
+#else
+    for (u64 i = 0; i < count; i++) {
+        out[i] = a[i] * b[i];
+    }
+#endif
+}
+
+void ftl::multiply(const quat_soa& a, const quat_soa& b, const quat_soa& out, u64 count) {
+    u64 i = 0;
+
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        multiply_block<lanes_wide>(a, b, out, i);
+    }
+
+    for (; i < count; i++) {
+        multiply_block<lanes_scalar>(a, b, out, i);
+    }
+}
+
+void ftl::normalize(const quat_soa& in, const quat_soa& out, u64 count) {
+    u64 i = 0;
+
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        normalize_block<lanes_wide>(in, out, i);
+    }
+
+    for (; i < count; i++) {
+        normalize_block<lanes_scalar>(in, out, i);
+    }
+}
+
+void ftl::nlerp(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count) {
+    u64 i = 0;
+
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        nlerp_block<lanes_wide>(a, b, t, out, i);
+    }
+
+    for (; i < count; i++) {
+        nlerp_block<lanes_scalar>(a, b, t, out, i);
+    }
+}
+
+void ftl::slerp(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count) {
+    u64 i = 0;
+
+    // NOTE: The 8-wide fbsincos8/fbacos8 need AVX2, plain AVX builds use the 4-wide versions.
+#if FBSIMD_AVX2
+    for (; i + lanes_avx::width <= count; i += lanes_avx::width) {
+        slerp_block<lanes_avx>(a, b, t, out, i);
+    }
+#elif FBSIMD_SSE2
+    for (; i + lanes_sse::width <= count; i += lanes_sse::width) {
+        slerp_block<lanes_sse>(a, b, t, out, i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        slerp_block<lanes_scalar>(a, b, t, out, i);
+    }
+}
+
+void ftl::slerp_fast(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count) {
+    u64 i = 0;
+
+    for (; i + lanes_wide::width <= count; i += lanes_wide::width) {
+        slerp_fast_block<lanes_wide>(a, b, t, out, i);
+    }
+
+    for (; i < count; i++) {
+        slerp_fast_block<lanes_scalar>(a, b, t, out, i);
+    }
+}
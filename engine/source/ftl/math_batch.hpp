@@ -0,0 +1,51 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/math.hpp"
+
+// NOTE: Batch kernels process whole arrays per call. They use AVX (8 elements per iteration) or SSE (4 per iteration)
+//       when available and fall back to scalar loops otherwise. Output arrays may be the same as the input arrays,
+//       but must not partially overlap them.
+
+namespace ftl {
+    // Structure of arrays view over 3 component vectors.
+    struct vec3_soa {
+        f32* x;
+        f32* y;
+        f32* z;
+    };
+
+    // out[i] = vec4f(in[i], 1.0f) * matrix, dropping w.
+    FBAPI void transform_points(const mat4& matrix, const vec3f* in, vec3f* out, u64 count);
+    FBAPI void transform_points(const mat4& matrix, const vec3_soa& in, const vec3_soa& out, u64 count);
+
+    // out[i] = a[i] * b[i], the same results as mat4::operator*. Outputs of 8 MiB or more are streamed past the
+    // cache when out is aligned to the SIMD width, so they won't be in it afterwards.
+    FBAPI void multiply(const mat4* a, const mat4* b, mat4* out, u64 count);
+
+    // Structure of arrays view over quaternions.
+    struct quat_soa {
+        f32* x;
+        f32* y;
+        f32* z;
+        f32* w;
+    };
+
+    // out[i] = a[i] * b[i]
+    FBAPI void multiply(const quat_soa& a, const quat_soa& b, const quat_soa& out, u64 count);
+
+    FBAPI void normalize(const quat_soa& in, const quat_soa& out, u64 count);
+
+    // NOTE: The blends below take the shortest path and expect unit quaternions. t holds one blend factor per
+    //       element, which is the keyframe fraction when sampling or the layer weight when blending poses.
+
+    // Normalized linear blend. Cheapest option, but the angular velocity is not constant over t.
+    FBAPI void nlerp(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count);
+
+    // Spherical blend using the polynomial fbacos and fbsincos, within about 1e-6 of the scalar ftl::slerp.
+    FBAPI void slerp(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count);
+
+    // nlerp with t corrected by a fitted polynomial, which brings it within about 1e-3 of slerp at the cost of a
+    // few multiply-adds. Good enough for animation sampling where the keys are close together.
+    FBAPI void slerp_fast(const quat_soa& a, const quat_soa& b, const f32* t, const quat_soa& out, u64 count);
+}  // namespace ftl
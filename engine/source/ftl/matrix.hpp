@@ -2,19 +2,23 @@
 
 #ifdef __cplusplus
 struct mat3 {
-    mat3(f32 diag = 0.0f) : mat{diag, 0.0f, 0.0f,
-                                0.0f, diag, 0.0f,
-                                0.0f, 0.0f, diag} {}
+    constexpr mat3(f32 diag = 0.0f) : mat{diag, 0.0f, 0.0f,
+                                          0.0f, diag, 0.0f,
+                                          0.0f, 0.0f, diag} {}
 
-    mat3(const vec3f& r0, const vec3f& r1, const vec3f& r2) : mat{r0.x, r0.y, r0.z,
-                                                                  r1.x, r1.y, r1.z,
-                                                                  r2.x, r2.y, r2.z} {}
+    constexpr mat3(const vec3f& r0, const vec3f& r1, const vec3f& r2) : mat{r0.vec[0], r0.vec[1], r0.vec[2],
+                                                                            r1.vec[0], r1.vec[1], r1.vec[2],
+                                                                            r2.vec[0], r2.vec[1], r2.vec[2]} {}
 
-    mat3 operator*(f32 scalar) {
-        return mat3(row0 * scalar, row1 * scalar, row2 * scalar);
+    constexpr mat3 operator*(f32 scalar) const {
+        mat3 result;
+        for (u32 i = 0; i < 9; i++) {
+            result.mat[i] = mat[i] * scalar;
+        }
+        return result;
     }
 
-    mat3 operator*(mat3& other) {
+    constexpr mat3 operator*(const mat3& other) const {
         mat3 result = mat3(1.0f);
 
         const f32* m1_ptr = mat;
@@ -34,7 +38,8 @@ struct mat3 {
         return result;
     }
 
-    mat3 transpose() {
+    // Returns a transposed copy, unlike mat4::transpose. transpose_in_place matches mat4's.
+    constexpr mat3 transpose() const {
         mat3 result = mat3(1.0f);
 
         result.mat[0] = mat[0];
@@ -50,7 +55,11 @@ struct mat3 {
         return result;
     }
 
-    void inverse() {
+    constexpr void transpose_in_place() {
+        *this = transpose();
+    }
+
+    constexpr void inverse() {
         f32* m = mat;
 
         mat3 result;
@@ -72,34 +81,133 @@ struct mat3 {
         o[7] = d * (m[1] * m[6] - m[0] * m[7]);
         o[8] = d * (m[0] * m[4] - m[1] * m[3]);
 
-        *m = *o;
+        *this = result;
     }
 
     union {
         f32 mat[9];
-        vec3f row0;
-        vec3f row1;
-        vec3f row2;
+        vec3f rows[3];
     };
 };
 
+#if FBSIMD_SSE2
+namespace internal {
+#define FB_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define FB_SWIZZLE(v, x, y, z, w) _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), FB_SHUFFLE_MASK(x, y, z, w)))
+#define FB_SHUFFLE(v0, v1, x, y, z, w) _mm_shuffle_ps(v0, v1, FB_SHUFFLE_MASK(x, y, z, w))
+
+    FBINLINE __m128 madd(__m128 a, __m128 b, __m128 c) {
+#if FBSIMD_FMA
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    // Row vector times the 4 rows of a matrix: v.x * r0 + v.y * r1 + v.z * r2 + v.w * r3.
+    FBINLINE __m128 mul_vec4_rows(__m128 v, __m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+        __m128 result = _mm_mul_ps(FB_SWIZZLE(v, 0, 0, 0, 0), r0);
+        result = madd(FB_SWIZZLE(v, 1, 1, 1, 1), r1, result);
+        result = madd(FB_SWIZZLE(v, 2, 2, 2, 2), r2, result);
+        result = madd(FB_SWIZZLE(v, 3, 3, 3, 3), r3, result);
+        return result;
+    }
+
+    // 2x2 row major matrix helpers used by the block-wise 4x4 inverse. A# is the adjugate of A.
+    // A * B
+    FBINLINE __m128 mat2_mul(__m128 a, __m128 b) {
+        return madd(a, FB_SWIZZLE(b, 0, 3, 0, 3), _mm_mul_ps(FB_SWIZZLE(a, 1, 0, 3, 2), FB_SWIZZLE(b, 2, 1, 2, 1)));
+    }
+
+    // A# * B
+    FBINLINE __m128 mat2_adj_mul(__m128 a, __m128 b) {
+        return _mm_sub_ps(_mm_mul_ps(FB_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(FB_SWIZZLE(a, 1, 1, 2, 2), FB_SWIZZLE(b, 2, 3, 0, 1)));
+    }
+
+    // A * B#
+    FBINLINE __m128 mat2_mul_adj(__m128 a, __m128 b) {
+        return _mm_sub_ps(_mm_mul_ps(a, FB_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(FB_SWIZZLE(a, 1, 0, 3, 2), FB_SWIZZLE(b, 2, 1, 2, 1)));
+    }
+
+    FBINLINE __m128 cross3(__m128 a, __m128 b) {
+        __m128 a_yzx = FB_SWIZZLE(a, 1, 2, 0, 3);
+        __m128 b_yzx = FB_SWIZZLE(b, 1, 2, 0, 3);
+        __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return FB_SWIZZLE(c, 1, 2, 0, 3);
+    }
+
+    FBINLINE __m128 dot3(__m128 a, __m128 b) {
+        __m128 m = _mm_mul_ps(a, b);
+        __m128 d = _mm_add_ps(FB_SWIZZLE(m, 0, 0, 0, 0), FB_SWIZZLE(m, 1, 1, 1, 1));
+        return _mm_add_ps(d, FB_SWIZZLE(m, 2, 2, 2, 2));
+    }
+}  // namespace internal
+#endif
+
+// NOTE: The SIMD paths below are selected at compile time (see ftl/simd.hpp). The scalar branches are the
+//       reference implementations and are used when FB_SIMD_DISABLED is defined or during constant evaluation,
+//       so every operation can also produce compile-time constants.
 struct mat4 {
-    mat4(f32 diag = 0.0f) : mat{diag, 0.0f, 0.0f, 0.0f,
-                                0.0f, diag, 0.0f, 0.0f,
-                                0.0f, 0.0f, diag, 0.0f,
-                                0.0f, 0.0f, 0.0f, diag} {}
+    constexpr mat4(f32 diag = 0.0f) : mat{diag, 0.0f, 0.0f, 0.0f,
+                                          0.0f, diag, 0.0f, 0.0f,
+                                          0.0f, 0.0f, diag, 0.0f,
+                                          0.0f, 0.0f, 0.0f, diag} {}
 
-    mat4(const vec4f& r0, const vec4f& r1, const vec4f& r2, const vec4f& r3) : mat{r0.x, r0.y, r0.z, r0.w,
-                                                                                   r1.x, r1.y, r1.z, r1.w,
-                                                                                   r2.x, r2.y, r2.z, r2.w,
-                                                                                   r3.x, r3.y, r3.z, r3.w} {}
+    constexpr mat4(const vec4f& r0, const vec4f& r1, const vec4f& r2, const vec4f& r3) : mat{r0.vec[0], r0.vec[1], r0.vec[2], r0.vec[3],
+                                                                                             r1.vec[0], r1.vec[1], r1.vec[2], r1.vec[3],
+                                                                                             r2.vec[0], r2.vec[1], r2.vec[2], r2.vec[3],
+                                                                                             r3.vec[0], r3.vec[1], r3.vec[2], r3.vec[3]} {}
 
-    mat4 operator*(f32 scalar) {
-        return mat4(row0 * scalar, row1 * scalar, row2 * scalar, row3 * scalar);
+    constexpr mat4 operator*(f32 scalar) const {
+        mat4 result;
+        for (u32 i = 0; i < 16; i++) {
+            result.mat[i] = mat[i] * scalar;
+        }
+        return result;
     }
 
-    mat4 operator*(const mat4& other) {
-        mat4 result = mat4(1.0f);
+    constexpr mat4 operator*(const mat4& other) const {
+        mat4 result;
+
+#if FBSIMD_AVX
+        if (!__builtin_is_constant_evaluated()) {
+            // Two result rows per iteration: each 128-bit lane broadcasts its own row's elements.
+            __m256 b0 = _mm256_broadcast_ps((const __m128*)(other.mat + 0));
+            __m256 b1 = _mm256_broadcast_ps((const __m128*)(other.mat + 4));
+            __m256 b2 = _mm256_broadcast_ps((const __m128*)(other.mat + 8));
+            __m256 b3 = _mm256_broadcast_ps((const __m128*)(other.mat + 12));
+
+            for (u32 i = 0; i < 16; i += 8) {
+                __m256 a = _mm256_loadu_ps(mat + i);
+                __m256 r = _mm256_mul_ps(_mm256_permute_ps(a, 0x00), b0);
+#if FBSIMD_FMA
+                r = _mm256_fmadd_ps(_mm256_permute_ps(a, 0x55), b1, r);
+                r = _mm256_fmadd_ps(_mm256_permute_ps(a, 0xAA), b2, r);
+                r = _mm256_fmadd_ps(_mm256_permute_ps(a, 0xFF), b3, r);
+#else
+                r = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a, 0x55), b1), r);
+                r = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a, 0xAA), b2), r);
+                r = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a, 0xFF), b3), r);
+#endif
+                _mm256_storeu_ps(result.mat + i, r);
+            }
+
+            return result;
+        }
+#elif FBSIMD_SSE2
+        if (!__builtin_is_constant_evaluated()) {
+            __m128 b0 = _mm_loadu_ps(other.mat + 0);
+            __m128 b1 = _mm_loadu_ps(other.mat + 4);
+            __m128 b2 = _mm_loadu_ps(other.mat + 8);
+            __m128 b3 = _mm_loadu_ps(other.mat + 12);
+
+            for (u32 i = 0; i < 16; i += 4) {
+                _mm_storeu_ps(result.mat + i, internal::mul_vec4_rows(_mm_loadu_ps(mat + i), b0, b1, b2, b3));
+            }
+
+            return result;
+        }
+#endif
 
         const f32* m1_ptr = mat;
         const f32* m2_ptr = other.mat;
@@ -119,8 +227,26 @@ struct mat4 {
         return result;
     }
 
-    void transpose() {
-        mat4 result = mat4(1.0f);
+    constexpr void transpose() {
+#if FBSIMD_SSE2
+        if (!__builtin_is_constant_evaluated()) {
+            __m128 r0 = _mm_loadu_ps(mat + 0);
+            __m128 r1 = _mm_loadu_ps(mat + 4);
+            __m128 r2 = _mm_loadu_ps(mat + 8);
+            __m128 r3 = _mm_loadu_ps(mat + 12);
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            _mm_storeu_ps(mat + 0, r0);
+            _mm_storeu_ps(mat + 4, r1);
+            _mm_storeu_ps(mat + 8, r2);
+            _mm_storeu_ps(mat + 12, r3);
+
+            return;
+        }
+#endif
+
+        mat4 result;
 
         result.mat[0] = mat[0];
         result.mat[1] = mat[4];
@@ -139,13 +265,66 @@ struct mat4 {
         result.mat[14] = mat[11];
         result.mat[15] = mat[15];
 
-        f32* m = mat;
-        f32* r = result.mat;
-
-        *m = *r;
+        *this = result;
     }
 
-    void inverse() {
+    constexpr void inverse() {
+#if FBSIMD_SSE2
+        if (!__builtin_is_constant_evaluated()) {
+            // Block-wise inverse: M = | A B |, with A, B, C, D being 2x2 matrices.
+            //                         | C D |
+            __m128 r0 = _mm_loadu_ps(mat + 0);
+            __m128 r1 = _mm_loadu_ps(mat + 4);
+            __m128 r2 = _mm_loadu_ps(mat + 8);
+            __m128 r3 = _mm_loadu_ps(mat + 12);
+
+            __m128 a = _mm_movelh_ps(r0, r1);
+            __m128 b = _mm_movehl_ps(r1, r0);
+            __m128 c = _mm_movelh_ps(r2, r3);
+            __m128 d = _mm_movehl_ps(r3, r2);
+
+            // (|A|, |B|, |C|, |D|)
+            __m128 det_sub = _mm_sub_ps(_mm_mul_ps(FB_SHUFFLE(r0, r2, 0, 2, 0, 2), FB_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                                        _mm_mul_ps(FB_SHUFFLE(r0, r2, 1, 3, 1, 3), FB_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+            __m128 det_a = FB_SWIZZLE(det_sub, 0, 0, 0, 0);
+            __m128 det_b = FB_SWIZZLE(det_sub, 1, 1, 1, 1);
+            __m128 det_c = FB_SWIZZLE(det_sub, 2, 2, 2, 2);
+            __m128 det_d = FB_SWIZZLE(det_sub, 3, 3, 3, 3);
+
+            __m128 d_c = internal::mat2_adj_mul(d, c);
+            __m128 a_b = internal::mat2_adj_mul(a, b);
+
+            __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), internal::mat2_mul(b, d_c));
+            __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), internal::mat2_mul(c, a_b));
+            __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), internal::mat2_mul_adj(d, a_b));
+            __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), internal::mat2_mul_adj(a, d_c));
+
+            // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+            __m128 tr = _mm_mul_ps(a_b, FB_SWIZZLE(d_c, 0, 2, 1, 3));
+            tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+            tr = _mm_add_ps(tr, FB_SWIZZLE(tr, 1, 1, 1, 1));
+            tr = FB_SWIZZLE(tr, 0, 0, 0, 0);
+
+            __m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+            det_m = _mm_sub_ps(det_m, tr);
+
+            __m128 rcp_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+
+            x = _mm_mul_ps(x, rcp_det);
+            y = _mm_mul_ps(y, rcp_det);
+            z = _mm_mul_ps(z, rcp_det);
+            w = _mm_mul_ps(w, rcp_det);
+
+            // Apply the adjugate shuffle while storing.
+            _mm_storeu_ps(mat + 0, FB_SHUFFLE(x, y, 3, 1, 3, 1));
+            _mm_storeu_ps(mat + 4, FB_SHUFFLE(x, y, 2, 0, 2, 0));
+            _mm_storeu_ps(mat + 8, FB_SHUFFLE(z, w, 3, 1, 3, 1));
+            _mm_storeu_ps(mat + 12, FB_SHUFFLE(z, w, 2, 0, 2, 0));
+
+            return;
+        }
+#endif
+
         f32* m = mat;
 
         f32 t0 = m[10] * m[15];
@@ -200,22 +379,114 @@ struct mat4 {
         o[14] = d * ((t18 * m[6] + t23 * m[14] + t15 * m[2]) - (t22 * m[14] + t14 * m[2] + t19 * m[6]));
         o[15] = d * ((t22 * m[10] + t16 * m[2] + t21 * m[6]) - (t20 * m[6] + t23 * m[10] + t17 * m[2]));
 
-        *m = *o;
+        *this = result;
     }
 
-    mat3 get_mat3() {
-        return mat3(row0.xyz, row1.xyz, row2.xyz);
+    // Faster inverse for affine matrices (rows 0-2 hold the linear part with w = 0, row 3 holds the translation).
+    constexpr void inverse_affine() {
+#if FBSIMD_SSE2
+        if (!__builtin_is_constant_evaluated()) {
+            __m128 r0 = _mm_loadu_ps(mat + 0);
+            __m128 r1 = _mm_loadu_ps(mat + 4);
+            __m128 r2 = _mm_loadu_ps(mat + 8);
+            __m128 t = _mm_loadu_ps(mat + 12);
+
+            // The columns of the inverse linear part are the cross products of its rows over the determinant.
+            __m128 c0 = internal::cross3(r1, r2);
+            __m128 c1 = internal::cross3(r2, r0);
+            __m128 c2 = internal::cross3(r0, r1);
+            __m128 rcp_det = _mm_div_ps(_mm_set1_ps(1.0f), internal::dot3(r0, c0));
+
+            c0 = _mm_mul_ps(c0, rcp_det);
+            c1 = _mm_mul_ps(c1, rcp_det);
+            c2 = _mm_mul_ps(c2, rcp_det);
+            __m128 c3 = _mm_setzero_ps();
+
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            __m128 translation = internal::mul_vec4_rows(t, c0, c1, c2, _mm_setzero_ps());
+            translation = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), translation);
+
+            _mm_storeu_ps(mat + 0, c0);
+            _mm_storeu_ps(mat + 4, c1);
+            _mm_storeu_ps(mat + 8, c2);
+            _mm_storeu_ps(mat + 12, translation);
+
+            return;
+        }
+#endif
+
+        f32* m = mat;
+
+        mat4 result;
+        f32* o = result.mat;
+
+        o[0] = m[5] * m[10] - m[6] * m[9];
+        o[4] = m[6] * m[8] - m[4] * m[10];
+        o[8] = m[4] * m[9] - m[5] * m[8];
+
+        f32 d = 1.0f / (m[0] * o[0] + m[1] * o[4] + m[2] * o[8]);
+
+        o[0] = d * o[0];
+        o[4] = d * o[4];
+        o[8] = d * o[8];
+        o[1] = d * (m[9] * m[2] - m[10] * m[1]);
+        o[5] = d * (m[10] * m[0] - m[8] * m[2]);
+        o[9] = d * (m[8] * m[1] - m[9] * m[0]);
+        o[2] = d * (m[1] * m[6] - m[2] * m[5]);
+        o[6] = d * (m[2] * m[4] - m[0] * m[6]);
+        o[10] = d * (m[0] * m[5] - m[1] * m[4]);
+
+        o[12] = -(m[12] * o[0] + m[13] * o[4] + m[14] * o[8]);
+        o[13] = -(m[12] * o[1] + m[13] * o[5] + m[14] * o[9]);
+        o[14] = -(m[12] * o[2] + m[13] * o[6] + m[14] * o[10]);
+        o[15] = 1.0f;
+
+        *this = result;
+    }
+
+    constexpr mat3 get_mat3() const {
+        return mat3(vec3f(mat[0], mat[1], mat[2]), vec3f(mat[4], mat[5], mat[6]), vec3f(mat[8], mat[9], mat[10]));
     }
 
     union {
         f32 mat[16];
-        vec4f row0;
-        vec4f row1;
-        vec4f row2;
-        vec4f row3;
+        vec4f rows[4];
     };
 };
+
+// Row vector times matrix, matching the row major convention used by the transform builders.
+FBINLINE constexpr vec4f operator*(const vec4f& vec, const mat4& matrix) {
+    vec4f result;
+
+#if FBSIMD_SSE2
+    if (!__builtin_is_constant_evaluated()) {
+        __m128 r0 = _mm_loadu_ps(matrix.mat + 0);
+        __m128 r1 = _mm_loadu_ps(matrix.mat + 4);
+        __m128 r2 = _mm_loadu_ps(matrix.mat + 8);
+        __m128 r3 = _mm_loadu_ps(matrix.mat + 12);
+
+        _mm_storeu_ps(result.vec, internal::mul_vec4_rows(_mm_loadu_ps(vec.vec), r0, r1, r2, r3));
+        return result;
+    }
+#endif
+
+    const f32* m = matrix.mat;
+    const f32* v = vec.vec;
+
+    for (u32 j = 0; j < 4; j++) {
+        result.vec[j] = v[0] * m[0 + j] + v[1] * m[4 + j] + v[2] * m[8 + j] + v[3] * m[12 + j];
+    }
+
+    return result;
+}
+
+#if FBSIMD_SSE2
+#undef FB_SHUFFLE
+#undef FB_SWIZZLE
+#undef FB_SHUFFLE_MASK
+#endif
 #else
 using mat3 = float3x3;
 using mat4 = float4x4;
-#endif
\ No newline at end of file
+#endif
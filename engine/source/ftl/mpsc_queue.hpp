@@ -0,0 +1,123 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/atomic.hpp"
+
+// NOTE: Bounded multi-producer queue from Dmitry Vyukov, with a single consumer. Producers claim a position with
+//       a compare-exchange and publish the cell through its sequence number, so neither side ever waits on the
+//       other. There is no constructor since queues live in zeroed system states: call reset before use.
+
+namespace ftl {
+    template <typename T, u32 N>
+    class mpsc_queue {
+       public:
+        STATIC_ASSERT((N & (N - 1)) == 0, "mpsc_queue capacity must be a power of two");
+
+        static constexpr u32 capacity = N;
+
+        // Not thread-safe.
+        void reset() {
+            for (u32 i = 0; i < N; i++) {
+                cells[i].sequence = i;
+            }
+            enqueue_position = 0;
+            dequeue_position = 0;
+        }
+
+        // Any thread. Calls fill(T&) on the claimed slot before publishing it, returns false when full.
+        template <typename F>
+        b8 push_with(F&& fill) {
+            u64 position = atomic_load(&enqueue_position, MEMORY_ORDER_RELAXED);
+            cell* c;
+
+            for (;;) {
+                c = &cells[position & (N - 1)];
+                u64 sequence = atomic_load(&c->sequence, MEMORY_ORDER_ACQUIRE);
+                i64 difference = (i64)sequence - (i64)position;
+
+                if (difference == 0) {
+                    if (atomic_compare_exchange(&enqueue_position, position, position + 1, MEMORY_ORDER_RELAXED, MEMORY_ORDER_RELAXED)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    // The consumer hasn't caught up with this lap yet.
+                    return false;
+                } else {
+                    position = atomic_load(&enqueue_position, MEMORY_ORDER_RELAXED);
+                }
+            }
+
+            fill(c->value);
+            atomic_store(&c->sequence, position + 1, MEMORY_ORDER_RELEASE);
+            return true;
+        }
+
+        // Any thread. Claims count consecutive slots, so the consumer finds them one after the other with nothing in
+        // between, and calls fill(T&, u32 index) on each before publishing it. Returns false when they don't all fit.
+        template <typename F>
+        b8 push_span_with(u32 count, F&& fill) {
+            u64 position = atomic_load(&enqueue_position, MEMORY_ORDER_RELAXED);
+
+            for (;;) {
+                // The consumer frees cells in order, so the whole span is free once its last cell is.
+                cell& last = cells[(position + count - 1) & (N - 1)];
+                u64 sequence = atomic_load(&last.sequence, MEMORY_ORDER_ACQUIRE);
+                i64 difference = (i64)sequence - (i64)(position + count - 1);
+
+                if (difference == 0) {
+                    if (atomic_compare_exchange(&enqueue_position, position, position + count, MEMORY_ORDER_RELAXED, MEMORY_ORDER_RELAXED)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = atomic_load(&enqueue_position, MEMORY_ORDER_RELAXED);
+                }
+            }
+
+            for (u32 i = 0; i < count; i++) {
+                cell& c = cells[(position + i) & (N - 1)];
+                fill(c.value, i);
+                atomic_store(&c.sequence, position + i + 1, MEMORY_ORDER_RELEASE);
+            }
+            return true;
+        }
+
+        b8 push(const T& value) {
+            return push_with([&](T& slot) { slot = value; });
+        }
+
+        // Consumer only. The oldest published element, nullptr when there is none. It stays valid until pop.
+        T* front() {
+            cell& c = cells[dequeue_position & (N - 1)];
+            if (atomic_load(&c.sequence, MEMORY_ORDER_ACQUIRE) != dequeue_position + 1) {
+                return nullptr;
+            }
+            return &c.value;
+        }
+
+        // Consumer only, after front returned an element.
+        void pop() {
+            cell& c = cells[dequeue_position & (N - 1)];
+            atomic_store(&c.sequence, dequeue_position + N, MEMORY_ORDER_RELEASE);
+            dequeue_position++;
+        }
+
+        // Positions claimed so far, published or not.
+        u64 get_push_count() const { return atomic_load(&enqueue_position, MEMORY_ORDER_RELAXED); }
+        u64 get_pop_count() const { return dequeue_position; }
+
+       private:
+        struct cell {
+            // Equals the position the cell is next written at while free, and that position + 1 once written.
+            u64 sequence;
+            T value;
+        };
+
+        cell cells[N];
+        u8 pad0[64];
+        u64 enqueue_position;
+        u8 pad1[64];
+        u64 dequeue_position;
+    };
+}  // namespace ftl
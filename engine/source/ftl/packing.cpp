@@ -0,0 +1,537 @@
+#include "ftl/packing.hpp"
+#include "ftl/lanes.hpp"
+
+using namespace ftl;
+using namespace ftl::internal;
+
+namespace {
+    // Vectors are converted in chunks through stack buffers, so the float math runs on SoA lanes and the integer
+    // conversion reuses the snorm16 kernels.
+    static constexpr u64 chunk_size = 64;
+
+    static constexpr f32 snorm8_scale = 127.0f;
+    static constexpr f32 snorm16_scale = 32767.0f;
+    static constexpr f32 unorm8_scale = 255.0f;
+    static constexpr f32 unorm16_scale = 65535.0f;
+
+    FBINLINE u32 as_u32(f32 v) { return __builtin_bit_cast(u32, v); }
+    FBINLINE f32 as_f32(u32 v) { return __builtin_bit_cast(f32, v); }
+
+    FBINLINE f32 clamp(f32 v, f32 min, f32 max) {
+        // Written so NaN ends up as min.
+        return v > min ? (v < max ? v : max) : min;
+    }
+
+    // Rounds with the current mode like _mm_cvtps_epi32, so exact halves go to even in both paths.
+    FBINLINE i32 round_to_int(f32 v) {
+        return (i32)__builtin_rintf(v);
+    }
+
+    /********** HALF FLOATS **********/
+
+    // NOTE: Bit tricks from Fabian Giesen's float/half conversions, rounding to nearest even.
+    FBINLINE u16 f32_to_f16(f32 value) {
+        u32 bits = as_u32(value);
+        u32 sign = (bits >> 16) & 0x8000;
+        u32 abs = bits & 0x7FFFFFFF;
+
+        u32 half;
+        if (abs >= 0x7F800000) {
+            // Infinity stays infinity, NaN becomes a quiet NaN.
+            half = abs > 0x7F800000 ? 0x7E00 : 0x7C00;
+        } else if (abs >= 0x477FF000) {
+            // Rounds past the largest half.
+            half = 0x7C00;
+        } else if (abs < 0x38800000) {
+            // Denormal half: let the FPU do the rounding by adding 0.5, which lines the mantissa up with the bits
+            // we keep.
+            half = as_u32(as_f32(abs) + 0.5f) - 0x3F000000;
+        } else {
+            u32 odd = (abs >> 13) & 1;
+            // Rebias the exponent from 127 to 15 and round.
+            half = (abs + 0xC8000FFF + odd) >> 13;
+        }
+
+        return (u16)(sign | half);
+    }
+
+    FBINLINE f32 f16_to_f32(u16 half) {
+        u32 bits = (u32)(half & 0x7FFF) << 13;
+        u32 exponent = bits & 0x0F800000;
+        bits += (127 - 15) << 23;
+
+        if (exponent == 0x0F800000) {
+            // Infinity or NaN.
+            bits += (128 - 16) << 23;
+        } else if (exponent == 0) {
+            // Zero or denormal, renormalize through the FPU.
+            bits = as_u32(as_f32(bits + (1 << 23)) - as_f32(113 << 23));
+        }
+
+        return as_f32(bits | ((u32)(half & 0x8000) << 16));
+    }
+
+#if FBSIMD_SSE2
+    FBINLINE __m128i select_i(__m128i mask, __m128i if_true, __m128i if_false) {
+        return _mm_or_si128(_mm_and_si128(mask, if_true), _mm_andnot_si128(mask, if_false));
+    }
+
+    // 4 values in the low 16 bits of each lane to 4 u16, without the signed saturation of packs getting in the way.
+    FBINLINE __m128i pack_u16(__m128i v) {
+        v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        return _mm_packs_epi32(v, v);
+    }
+
+    FBINLINE __m128i f32_to_f16_sse(__m128 value) {
+        __m128i bits = _mm_castps_si128(value);
+        __m128i sign = _mm_and_si128(bits, _mm_set1_epi32((i32)0x80000000));
+        __m128i abs = _mm_xor_si128(bits, sign);
+
+        __m128i denormal = _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_set1_ps(0.5f)));
+        denormal = _mm_sub_epi32(denormal, _mm_set1_epi32(0x3F000000));
+
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(abs, _mm_set1_epi32((i32)0xC8000FFF)), odd), 13);
+
+        __m128i nan = _mm_and_si128(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7F800000)), _mm_set1_epi32(0x0200));
+
+        __m128i half = select_i(_mm_cmplt_epi32(abs, _mm_set1_epi32(0x38800000)), denormal, normal);
+        half = select_i(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x477FEFFF)), _mm_or_si128(_mm_set1_epi32(0x7C00), nan), half);
+
+        return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+    }
+
+    FBINLINE __m128 f16_to_f32_sse(__m128i half) {
+        __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+        __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x0F800000));
+        bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+        __m128i infinite = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x0F800000));
+        bits = _mm_add_epi32(bits, _mm_and_si128(infinite, _mm_set1_epi32((128 - 16) << 23)));
+
+        __m128i denormal = _mm_castps_si128(
+            _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23))));
+        bits = select_i(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), denormal, bits);
+
+        __m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+        return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+    }
+
+    // Loads of 4 narrow integers widened to 32 bit lanes.
+    FBINLINE __m128i load_u16(const void* p) {
+        return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+    }
+
+    FBINLINE __m128i load_i16(const void* p) {
+        __m128i v = _mm_loadl_epi64((const __m128i*)p);
+        return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    }
+
+    FBINLINE __m128i load_bytes(const void* p) {
+        i32 word;
+        __builtin_memcpy(&word, p, sizeof(word));
+        return _mm_cvtsi32_si128(word);
+    }
+
+    FBINLINE void store_bytes(void* p, __m128i v) {
+        i32 word = _mm_cvtsi128_si32(v);
+        __builtin_memcpy(p, &word, sizeof(word));
+    }
+
+    FBINLINE __m128i load_u8(const void* p) {
+        __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(load_bytes(p), zero), zero);
+    }
+
+    FBINLINE __m128i load_i8(const void* p) {
+        __m128i v = load_bytes(p);
+        v = _mm_unpacklo_epi8(v, v);
+        return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 24);
+    }
+
+    // Clamped, scaled and rounded to nearest, which is the default MXCSR rounding mode.
+    FBINLINE __m128i quantize(const f32* in, f32 min, f32 scale) {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), _mm_set1_ps(min)), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(scale)));
+    }
+#endif
+
+    /********** OCTAHEDRAL **********/
+
+    template <typename L>
+    FBINLINE void octahedral_encode(const f32* x, const f32* y, const f32* z, f32* u, f32* v) {
+        using reg = typename L::reg;
+
+        reg nx = L::load(x);
+        reg ny = L::load(y);
+        reg nz = L::load(z);
+
+        reg inv_l1 = L::div(L::set(1.0f), L::add(L::add(L::flip_sign(nx, nx), L::flip_sign(ny, ny)), L::flip_sign(nz, nz)));
+        reg px = L::mul(nx, inv_l1);
+        reg py = L::mul(ny, inv_l1);
+
+        // The lower hemisphere is folded over the diagonals.
+        reg fold_x = L::flip_sign(L::sub(L::set(1.0f), L::flip_sign(py, py)), px);
+        reg fold_y = L::flip_sign(L::sub(L::set(1.0f), L::flip_sign(px, px)), py);
+        typename L::mask lower = L::less(nz, L::set(0.0f));
+
+        L::store(u, L::select(lower, fold_x, px));
+        L::store(v, L::select(lower, fold_y, py));
+    }
+
+    template <typename L>
+    FBINLINE void octahedral_decode(const f32* u, const f32* v, f32* x, f32* y, f32* z) {
+        using reg = typename L::reg;
+
+        reg px = L::load(u);
+        reg py = L::load(v);
+        reg pz = L::sub(L::sub(L::set(1.0f), L::flip_sign(px, px)), L::flip_sign(py, py));
+
+        // Unfold the lower hemisphere.
+        reg t = L::max(L::sub(L::set(0.0f), pz), L::set(0.0f));
+        px = L::sub(px, L::flip_sign(t, px));
+        py = L::sub(py, L::flip_sign(t, py));
+
+        reg inv_length = L::div(L::set(1.0f), L::sqrt(L::madd(px, px, L::madd(py, py, L::mul(pz, pz)))));
+        L::store(x, L::mul(px, inv_length));
+        L::store(y, L::mul(py, inv_length));
+        L::store(z, L::mul(pz, inv_length));
+    }
+
+    /********** QTANGENT **********/
+
+    // Smallest value that survives snorm16 quantization, so w never rounds to zero and loses its sign.
+    static constexpr f32 qtangent_bias = 1.0f / snorm16_scale;
+
+    // Rotation taking the x and z axes to the tangent and normal, as x, y, z, w.
+    void frame_to_quaternion(const vec3f& normal, const vec4f& tangent, f32* q) {
+        vec3f n = normal;
+        vec3f t = vec3f(tangent.x, tangent.y, tangent.z);
+        t = t - n * dot(n, t);
+        f32 t_length = fbsqrt(dot(t, t));
+        if (t_length > FB_FLOAT_EPSILON) {
+            t = t * (1.0f / t_length);
+        } else {
+            // Degenerate tangent, any vector orthogonal to the normal will do.
+            t = (n.x > 0.9f || n.x < -0.9f) ? cross(vec3f(0.0f, 1.0f, 0.0f), n) : cross(vec3f(1.0f, 0.0f, 0.0f), n);
+            t = t * (1.0f / fbsqrt(dot(t, t)));
+        }
+        vec3f b = cross(n, t);
+
+        // Columns of the rotation are t, b and n.
+        f32 m00 = t.x, m10 = t.y, m20 = t.z;
+        f32 m01 = b.x, m11 = b.y, m21 = b.z;
+        f32 m02 = n.x, m12 = n.y, m22 = n.z;
+
+        f32 trace = m00 + m11 + m22;
+        f32 x, y, z, w;
+        if (trace > 0.0f) {
+            f32 s = 0.5f / fbsqrt(trace + 1.0f);
+            w = 0.25f / s;
+            x = (m21 - m12) * s;
+            y = (m02 - m20) * s;
+            z = (m10 - m01) * s;
+        } else if (m00 > m11 && m00 > m22) {
+            f32 s = 2.0f * fbsqrt(1.0f + m00 - m11 - m22);
+            w = (m21 - m12) / s;
+            x = 0.25f * s;
+            y = (m01 + m10) / s;
+            z = (m02 + m20) / s;
+        } else if (m11 > m22) {
+            f32 s = 2.0f * fbsqrt(1.0f + m11 - m00 - m22);
+            w = (m02 - m20) / s;
+            x = (m01 + m10) / s;
+            y = 0.25f * s;
+            z = (m12 + m21) / s;
+        } else {
+            f32 s = 2.0f * fbsqrt(1.0f + m22 - m00 - m11);
+            w = (m10 - m01) / s;
+            x = (m02 + m20) / s;
+            y = (m12 + m21) / s;
+            z = 0.25f * s;
+        }
+
+        f32 inv_length = 1.0f / fbsqrt(x * x + y * y + z * z + w * w);
+        x *= inv_length;
+        y *= inv_length;
+        z *= inv_length;
+        w *= inv_length;
+
+        // q and -q are the same rotation, which frees the sign of w for the handedness.
+        if (w < 0.0f) {
+            x = -x;
+            y = -y;
+            z = -z;
+            w = -w;
+        }
+        if (w < qtangent_bias) {
+            f32 scale = fbsqrt(1.0f - qtangent_bias * qtangent_bias);
+            x *= scale;
+            y *= scale;
+            z *= scale;
+            w = qtangent_bias;
+        }
+        if (tangent.w < 0.0f) {
+            x = -x;
+            y = -y;
+            z = -z;
+            w = -w;
+        }
+
+        q[0] = x;
+        q[1] = y;
+        q[2] = z;
+        q[3] = w;
+    }
+
+    void quaternion_to_frame(const f32* q, vec3f& normal, vec4f& tangent) {
+        f32 inv_length = 1.0f / fbsqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        f32 x = q[0] * inv_length;
+        f32 y = q[1] * inv_length;
+        f32 z = q[2] * inv_length;
+        f32 w = q[3] * inv_length;
+
+        tangent = vec4f(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), w < 0.0f ? -1.0f : 1.0f);
+        normal = vec3f(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y));
+    }
+}  // namespace
+
+void ftl::pack_f16(const f32* in, u16* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_F16C && FBSIMD_AVX
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128((__m128i*)(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#elif FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storel_epi64((__m128i*)(out + i), pack_u16(f32_to_f16_sse(_mm_loadu_ps(in + i))));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = f32_to_f16(in[i]);
+    }
+}
+
+void ftl::unpack_f16(const u16* in, f32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_F16C && FBSIMD_AVX
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(in + i))));
+    }
+#elif FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, f16_to_f32_sse(load_u16(in + i)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = f16_to_f32(in[i]);
+    }
+}
+
+void ftl::pack_snorm8(const f32* in, i8* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_packs_epi32(quantize(in + i, -1.0f, snorm8_scale), _mm_setzero_si128());
+        store_bytes(out + i, _mm_packs_epi16(v, v));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (i8)round_to_int(clamp(in[i], -1.0f, 1.0f) * snorm8_scale);
+    }
+}
+
+void ftl::unpack_snorm8(const i8* in, f32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    // NOTE: -128 is clamped to -1 like the GPU does.
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(load_i8(in + i)), _mm_set1_ps(1.0f / snorm8_scale));
+        _mm_storeu_ps(out + i, _mm_max_ps(v, _mm_set1_ps(-1.0f)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        f32 v = (f32)in[i] * (1.0f / snorm8_scale);
+        out[i] = v < -1.0f ? -1.0f : v;
+    }
+}
+
+void ftl::pack_snorm16(const f32* in, i16* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = quantize(in + i, -1.0f, snorm16_scale);
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packs_epi32(v, v));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (i16)round_to_int(clamp(in[i], -1.0f, 1.0f) * snorm16_scale);
+    }
+}
+
+void ftl::unpack_snorm16(const i16* in, f32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(load_i16(in + i)), _mm_set1_ps(1.0f / snorm16_scale));
+        _mm_storeu_ps(out + i, _mm_max_ps(v, _mm_set1_ps(-1.0f)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        f32 v = (f32)in[i] * (1.0f / snorm16_scale);
+        out[i] = v < -1.0f ? -1.0f : v;
+    }
+}
+
+void ftl::pack_unorm8(const f32* in, u8* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_packs_epi32(quantize(in + i, 0.0f, unorm8_scale), _mm_setzero_si128());
+        store_bytes(out + i, _mm_packus_epi16(v, v));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (u8)round_to_int(clamp(in[i], 0.0f, 1.0f) * unorm8_scale);
+    }
+}
+
+void ftl::unpack_unorm8(const u8* in, f32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(load_u8(in + i)), _mm_set1_ps(1.0f / unorm8_scale)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (f32)in[i] * (1.0f / unorm8_scale);
+    }
+}
+
+void ftl::pack_unorm16(const f32* in, u16* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storel_epi64((__m128i*)(out + i), pack_u16(quantize(in + i, 0.0f, unorm16_scale)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (u16)round_to_int(clamp(in[i], 0.0f, 1.0f) * unorm16_scale);
+    }
+}
+
+void ftl::unpack_unorm16(const u16* in, f32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(load_u16(in + i)), _mm_set1_ps(1.0f / unorm16_scale)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (f32)in[i] * (1.0f / unorm16_scale);
+    }
+}
+
+void ftl::pack_octahedral(const vec3f* in, i16* out, u64 count) {
+    f32 x[chunk_size], y[chunk_size], z[chunk_size];
+    f32 u[chunk_size], v[chunk_size];
+    f32 uv[chunk_size * 2];
+
+    for (u64 base = 0; base < count; base += chunk_size) {
+        u64 n = count - base < chunk_size ? count - base : chunk_size;
+
+        for (u64 i = 0; i < n; i++) {
+            x[i] = in[base + i].x;
+            y[i] = in[base + i].y;
+            z[i] = in[base + i].z;
+        }
+
+        u64 i = 0;
+        for (; i + lanes_wide::width <= n; i += lanes_wide::width) {
+            octahedral_encode<lanes_wide>(x + i, y + i, z + i, u + i, v + i);
+        }
+        for (; i < n; i++) {
+            octahedral_encode<lanes_scalar>(x + i, y + i, z + i, u + i, v + i);
+        }
+
+        for (i = 0; i < n; i++) {
+            uv[i * 2] = u[i];
+            uv[i * 2 + 1] = v[i];
+        }
+        pack_snorm16(uv, out + base * 2, n * 2);
+    }
+}
+
+void ftl::unpack_octahedral(const i16* in, vec3f* out, u64 count) {
+    f32 x[chunk_size], y[chunk_size], z[chunk_size];
+    f32 u[chunk_size], v[chunk_size];
+    f32 uv[chunk_size * 2];
+
+    for (u64 base = 0; base < count; base += chunk_size) {
+        u64 n = count - base < chunk_size ? count - base : chunk_size;
+
+        unpack_snorm16(in + base * 2, uv, n * 2);
+        for (u64 i = 0; i < n; i++) {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+
+        u64 i = 0;
+        for (; i + lanes_wide::width <= n; i += lanes_wide::width) {
+            octahedral_decode<lanes_wide>(u + i, v + i, x + i, y + i, z + i);
+        }
+        for (; i < n; i++) {
+            octahedral_decode<lanes_scalar>(u + i, v + i, x + i, y + i, z + i);
+        }
+
+        for (i = 0; i < n; i++) {
+            out[base + i] = vec3f(x[i], y[i], z[i]);
+        }
+    }
+}
+
+void ftl::pack_qtangent(const vec3f* normals, const vec4f* tangents, i16* out, u64 count) {
+    f32 q[chunk_size * 4];
+
+    for (u64 base = 0; base < count; base += chunk_size) {
+        u64 n = count - base < chunk_size ? count - base : chunk_size;
+
+        for (u64 i = 0; i < n; i++) {
+            frame_to_quaternion(normals[base + i], tangents[base + i], q + i * 4);
+        }
+        pack_snorm16(q, out + base * 4, n * 4);
+    }
+}
+
+void ftl::unpack_qtangent(const i16* in, vec3f* normals, vec4f* tangents, u64 count) {
+    f32 q[chunk_size * 4];
+
+    for (u64 base = 0; base < count; base += chunk_size) {
+        u64 n = count - base < chunk_size ? count - base : chunk_size;
+
+        unpack_snorm16(in + base * 4, q, n * 4);
+        for (u64 i = 0; i < n; i++) {
+            quaternion_to_frame(q + i * 4, normals[base + i], tangents[base + i]);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/math.hpp"
+
+// NOTE: Quantization kernels for vertex and instance data. They process 4 elements per iteration with SSE2 (8 for
+//       half floats with F16C) and round to nearest. The error bounds below are the worst case of a full
+//       pack/unpack round trip.
+
+namespace ftl {
+    // IEEE half floats, relative error 2^-11 in the normal range. Values past 65504 become infinity.
+    FBAPI void pack_f16(const f32* in, u16* out, u64 count);
+    FBAPI void unpack_f16(const u16* in, f32* out, u64 count);
+
+    // snorm maps [-1, 1] to [-127, 127] or [-32767, 32767], unorm maps [0, 1] to [0, 255] or [0, 65535]. Inputs
+    // are clamped to the range first. Absolute error is half a step: 1/254, 1/65534, 1/510 and 1/131070.
+    FBAPI void pack_snorm8(const f32* in, i8* out, u64 count);
+    FBAPI void unpack_snorm8(const i8* in, f32* out, u64 count);
+    FBAPI void pack_snorm16(const f32* in, i16* out, u64 count);
+    FBAPI void unpack_snorm16(const i16* in, f32* out, u64 count);
+    FBAPI void pack_unorm8(const f32* in, u8* out, u64 count);
+    FBAPI void unpack_unorm8(const u8* in, f32* out, u64 count);
+    FBAPI void pack_unorm16(const f32* in, u16* out, u64 count);
+    FBAPI void unpack_unorm16(const u16* in, f32* out, u64 count);
+
+    // Unit vectors folded onto an octahedron and stored as two snorm16 per vector (out holds 2 * count values).
+    // Angular error is below 0.005 degrees. Unpacked vectors are normalized.
+    FBAPI void pack_octahedral(const vec3f* in, i16* out, u64 count);
+    FBAPI void unpack_octahedral(const i16* in, vec3f* out, u64 count);
+
+    // Tangent frames as a unit quaternion in four snorm16 (out holds 4 * count values), 8 bytes instead of 28.
+    // Tangents are vec4f with the bitangent handedness (+1 or -1) in w, as in glTF, and are orthogonalized
+    // against the normal before packing. The handedness is kept in the sign of the quaternion's w. Angular error
+    // of the unpacked normal and tangent is below 0.005 degrees.
+    FBAPI void pack_qtangent(const vec3f* normals, const vec4f* tangents, i16* out, u64 count);
+    FBAPI void unpack_qtangent(const i16* in, vec3f* normals, vec4f* tangents, u64 count);
+}  // namespace ftl
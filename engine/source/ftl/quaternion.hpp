@@ -1,12 +1,12 @@
 #pragma once
 
 struct quat {
-    quat() : vec{1.0f, 0.0f, 0.0f, 0.0f} {}
-    quat(f32 X, f32 Y, f32 Z, f32 W) : vec{W, X, Y, Z} {}
+    constexpr quat() : vec{1.0f, 0.0f, 0.0f, 0.0f} {}
+    constexpr quat(f32 X, f32 Y, f32 Z, f32 W) : vec{W, X, Y, Z} {}
     quat(const vec3f& axis, f32 angle, b8 normalized = false) {
         const f32 half_angle = 0.5f * angle;
-        f32 s = fbsin(half_angle);
-        f32 c = fbcos(half_angle);
+        f32 s, c;
+        fbsincos(half_angle, s, c);
 
         vec[0] = c;
         vec[1] = s * axis.x;
@@ -18,32 +18,34 @@ struct quat {
         }
     }
 
-    f32 normal() { return fbsqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2] + vec[3] * vec[3]); }
+    f32 normal() const { return fbsqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2] + vec[3] * vec[3]); }
 
-    quat operator*(const quat& other) {
-        quat result;
+    // NOTE: Components are read through vec[] (w, x, y, z) so the operators stay usable in constant expressions.
+    constexpr quat operator*(const quat& other) const {
+        const f32* a = vec;
+        const f32* b = other.vec;
 
-        result.x = x * other.w +
-                   y * other.z -
-                   z * other.y +
-                   w * other.x;
+        f32 rw = -a[1] * b[1] -
+                 a[2] * b[2] -
+                 a[3] * b[3] +
+                 a[0] * b[0];
 
-        result.y = -x * other.z +
-                   y * other.w +
-                   z * other.x +
-                   w * other.y;
+        f32 rx = a[1] * b[0] +
+                 a[2] * b[3] -
+                 a[3] * b[2] +
+                 a[0] * b[1];
 
-        result.z = x * other.y -
-                   y * other.x +
-                   z * other.w +
-                   w * other.z;
+        f32 ry = -a[1] * b[3] +
+                 a[2] * b[0] +
+                 a[3] * b[1] +
+                 a[0] * b[2];
 
-        result.w = -x * other.x -
-                   y * other.y -
-                   z * other.z +
-                   w * other.w;
+        f32 rz = a[1] * b[2] -
+                 a[2] * b[1] +
+                 a[3] * b[0] +
+                 a[0] * b[3];
 
-        return result;
+        return quat(rx, ry, rz, rw);
     }
 
     void normalize() {
@@ -54,7 +56,7 @@ struct quat {
         vec[3] /= n;
     }
 
-    quat conjugate() const {
+    constexpr quat conjugate() const {
         quat result;
         result.vec[0] = vec[0];
         result.vec[1] = -vec[1];
@@ -0,0 +1,158 @@
+#include "ftl/random.hpp"
+#include "ftl/simd.hpp"
+#include "platform/platform.hpp"
+
+using namespace fabric;
+using namespace ftl;
+
+namespace {
+    static constexpr f32 unit_scale = 1.0f / 16777216.0f;
+
+#if FBSIMD_AVX2
+    static constexpr u32 lane_count = 8;
+    using lane_register = __m256i;
+
+    FBINLINE __m256i rotl(__m256i x, i32 k) {
+        return _mm256_or_si256(_mm256_slli_epi32(x, k), _mm256_srli_epi32(x, 32 - k));
+    }
+
+    // One xoshiro128** step for every lane.
+    FBINLINE __m256i next_lanes(__m256i s[4]) {
+        __m256i s1_times_5 = _mm256_add_epi32(_mm256_slli_epi32(s[1], 2), s[1]);
+        __m256i rotated = rotl(s1_times_5, 7);
+        __m256i result = _mm256_add_epi32(_mm256_slli_epi32(rotated, 3), rotated);
+
+        __m256i t = _mm256_slli_epi32(s[1], 9);
+        s[2] = _mm256_xor_si256(s[2], s[0]);
+        s[3] = _mm256_xor_si256(s[3], s[1]);
+        s[1] = _mm256_xor_si256(s[1], s[2]);
+        s[0] = _mm256_xor_si256(s[0], s[3]);
+        s[2] = _mm256_xor_si256(s[2], t);
+        s[3] = rotl(s[3], 11);
+
+        return result;
+    }
+
+    FBINLINE void store_u32(u32* out, __m256i value) {
+        _mm256_storeu_si256((__m256i*)out, value);
+    }
+
+    FBINLINE void store_f32(f32* out, __m256i value, f32 min, f32 span) {
+        __m256 unit = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(value, 8)), _mm256_set1_ps(unit_scale));
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_set1_ps(min), _mm256_mul_ps(unit, _mm256_set1_ps(span))));
+    }
+
+    FBINLINE void seed_lanes(rng& generator, __m256i s[4]) {
+        u32 seeds[4][lane_count];
+        for (u32 word = 0; word < 4; word++) {
+            for (u32 lane = 0; lane < lane_count; lane++) {
+                seeds[word][lane] = generator.next_u32();
+            }
+        }
+        for (u32 word = 0; word < 4; word++) {
+            s[word] = _mm256_loadu_si256((const __m256i*)seeds[word]);
+        }
+        // An all zero state would only ever produce zeros.
+        s[0] = _mm256_or_si256(s[0], _mm256_set1_epi32(1));
+    }
+#elif FBSIMD_SSE2
+    static constexpr u32 lane_count = 4;
+    using lane_register = __m128i;
+
+    FBINLINE __m128i rotl(__m128i x, i32 k) {
+        return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+    }
+
+    // One xoshiro128** step for every lane.
+    FBINLINE __m128i next_lanes(__m128i s[4]) {
+        __m128i s1_times_5 = _mm_add_epi32(_mm_slli_epi32(s[1], 2), s[1]);
+        __m128i rotated = rotl(s1_times_5, 7);
+        __m128i result = _mm_add_epi32(_mm_slli_epi32(rotated, 3), rotated);
+
+        __m128i t = _mm_slli_epi32(s[1], 9);
+        s[2] = _mm_xor_si128(s[2], s[0]);
+        s[3] = _mm_xor_si128(s[3], s[1]);
+        s[1] = _mm_xor_si128(s[1], s[2]);
+        s[0] = _mm_xor_si128(s[0], s[3]);
+        s[2] = _mm_xor_si128(s[2], t);
+        s[3] = rotl(s[3], 11);
+
+        return result;
+    }
+
+    FBINLINE void store_u32(u32* out, __m128i value) {
+        _mm_storeu_si128((__m128i*)out, value);
+    }
+
+    FBINLINE void store_f32(f32* out, __m128i value, f32 min, f32 span) {
+        __m128 unit = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(value, 8)), _mm_set1_ps(unit_scale));
+        _mm_storeu_ps(out, _mm_add_ps(_mm_set1_ps(min), _mm_mul_ps(unit, _mm_set1_ps(span))));
+    }
+
+    FBINLINE void seed_lanes(rng& generator, __m128i s[4]) {
+        u32 seeds[4][lane_count];
+        for (u32 word = 0; word < 4; word++) {
+            for (u32 lane = 0; lane < lane_count; lane++) {
+                seeds[word][lane] = generator.next_u32();
+            }
+        }
+        for (u32 word = 0; word < 4; word++) {
+            s[word] = _mm_loadu_si128((const __m128i*)seeds[word]);
+        }
+        // An all zero state would only ever produce zeros.
+        s[0] = _mm_or_si128(s[0], _mm_set1_epi32(1));
+    }
+#endif
+}  // namespace
+
+void rng::fill(u32* out, u64 count) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    if (count >= lane_count) {
+        lane_register s[4];
+        seed_lanes(*this, s);
+
+        for (; i + lane_count <= count; i += lane_count) {
+            store_u32(out + i, next_lanes(s));
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = next_u32();
+    }
+}
+
+void rng::fill(f32* out, u64 count, f32 min, f32 max) {
+    u64 i = 0;
+
+#if FBSIMD_SSE2
+    if (count >= lane_count) {
+        lane_register s[4];
+        seed_lanes(*this, s);
+
+        for (; i + lane_count <= count; i += lane_count) {
+            store_f32(out + i, next_lanes(s), min, max - min);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = range(min, max);
+    }
+}
+
+rng& ftl::thread_rng() {
+    static thread_local rng generator;
+    static thread_local b8 seeded = false;
+
+    if (!seeded) {
+        // The address of a thread local is unique per live thread, which gives each thread its own stream.
+        u64 seed = (u64)(platform::get_absolute_time() * 1000000000.0);
+        generator.reseed(seed, (u64)&seeded);
+        seeded = true;
+    }
+
+    return generator;
+}
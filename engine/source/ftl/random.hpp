@@ -0,0 +1,86 @@
+#pragma once
+
+#include "defines.hpp"
+
+namespace ftl {
+    // PCG32 (XSH RR) generator: 64 bit state, 32 bit output and 2^63 independent streams per seed.
+    // Instances are not shared between threads; use thread_rng() or give each worker its own stream.
+    class FBAPI rng {
+       public:
+        static constexpr u64 default_seed = 0x853c49e6748fea9bULL;
+        static constexpr u64 default_stream = 0xda3e39cb94b95bdbULL;
+
+        rng(u64 seed = default_seed, u64 stream = default_stream) {
+            reseed(seed, stream);
+        }
+
+        void reseed(u64 seed, u64 stream = default_stream) {
+            state = 0;
+            increment = (stream << 1) | 1;
+            next_u32();
+            state += seed;
+            next_u32();
+        }
+
+        u32 next_u32() {
+            u64 old_state = state;
+            state = old_state * multiplier + increment;
+
+            u32 xorshifted = (u32)(((old_state >> 18) ^ old_state) >> 27);
+            u32 rotation = (u32)(old_state >> 59);
+            return (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31));
+        }
+
+        // Uniform in [0, bound), without modulo bias (Lemire's multiply and reject).
+        u32 next_bounded(u32 bound) {
+            u64 m = (u64)next_u32() * bound;
+            u32 low = (u32)m;
+
+            if (low < bound) {
+                u32 threshold = (0u - bound) % bound;
+                while (low < threshold) {
+                    m = (u64)next_u32() * bound;
+                    low = (u32)m;
+                }
+            }
+
+            return (u32)(m >> 32);
+        }
+
+        // Uniform in [min, max].
+        i32 range(i32 min, i32 max) {
+            u32 span = (u32)max - (u32)min + 1u;
+            if (span == 0) {
+                // The whole 32 bit range was requested.
+                return (i32)next_u32();
+            }
+
+            return (i32)((u32)min + next_bounded(span));
+        }
+
+        // Uniform in [0, 1), using the top 24 bits so every value is exactly representable.
+        f32 next_f32() {
+            return (f32)(next_u32() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        // Uniform in [min, max).
+        f32 range(f32 min, f32 max) {
+            return min + next_f32() * (max - min);
+        }
+
+        // Bulk generation. These run several xoshiro128** lanes side by side in SIMD registers; the lanes are seeded
+        // from this generator, so the output is reproducible from the seed and the generator advances. The sequence
+        // depends on the SIMD width the engine was built with (4 lanes with SSE2, 8 with AVX2).
+        void fill(u32* out, u64 count);
+        void fill(f32* out, u64 count, f32 min = 0.0f, f32 max = 1.0f);
+
+       private:
+        static constexpr u64 multiplier = 6364136223846793005ULL;
+
+        u64 state;
+        u64 increment;
+    };
+
+    // Generator owned by the calling thread, seeded from the clock and a per-thread stream on first use.
+    FBAPI rng& thread_rng();
+}  // namespace ftl
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "defines.hpp"
+
+// NOTE: SIMD code paths are selected at compile time from the target features enabled on the
+//       command line (e.g. -msse4.1, -mavx2 -mfma). x64 always guarantees SSE2.
+//       Define FB_SIMD_DISABLED to force the scalar reference paths everywhere.
+
+#ifndef FB_SIMD_DISABLED
+#if defined(__AVX2__)
+#define FBSIMD_AVX2 1
+#endif
+
+#if defined(__AVX__)
+#define FBSIMD_AVX 1
+#endif
+
+#if defined(__FMA__)
+#define FBSIMD_FMA 1
+#endif
+
+#if defined(__F16C__)
+#define FBSIMD_F16C 1
+#endif
+
+#if defined(__SSE4_1__)
+#define FBSIMD_SSE4 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FBSIMD_SSE2 1
+#endif
+#endif
+
+#ifndef FBSIMD_AVX2
+#define FBSIMD_AVX2 0
+#endif
+
+#ifndef FBSIMD_AVX
+#define FBSIMD_AVX 0
+#endif
+
+#ifndef FBSIMD_FMA
+#define FBSIMD_FMA 0
+#endif
+
+#ifndef FBSIMD_F16C
+#define FBSIMD_F16C 0
+#endif
+
+#ifndef FBSIMD_SSE4
+#define FBSIMD_SSE4 0
+#endif
+
+#ifndef FBSIMD_SSE2
+#define FBSIMD_SSE2 0
+#endif
+
+#if FBSIMD_SSE2
+#include <immintrin.h>
+#endif
+
+namespace ftl {
+    FBINLINE u32 popcount(u64 value) {
+#if _MSC_VER && !__clang__
+        return (u32)__popcnt64(value);
+#else
+        return (u32)__builtin_popcountll(value);
+#endif
+    }
+
+    // Index of the lowest set bit. The value must not be zero.
+    FBINLINE u32 count_trailing_zeros(u64 value) {
+#if _MSC_VER && !__clang__
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return (u32)index;
+#else
+        return (u32)__builtin_ctzll(value);
+#endif
+    }
+
+    // Index of the highest set bit. The value must not be zero.
+    FBINLINE u32 bit_scan_reverse(u64 value) {
+#if _MSC_VER && !__clang__
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return (u32)index;
+#else
+        return 63u - (u32)__builtin_clzll(value);
+#endif
+    }
+}  // namespace ftl
@@ -0,0 +1,618 @@
+#include "ftl/spatial.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+
+using namespace fabric;
+using namespace ftl;
+
+namespace {
+    static constexpr u32 max_octree_depth = 16;
+    static constexpr u32 min_node_capacity = 64;
+
+    FBINLINE i32 floor_to_int(f32 v) {
+        i32 i = (i32)v;
+        return (f32)i > v ? i - 1 : i;
+    }
+
+    // 21 bits per axis, so coordinates wrap every 2^21 cells. Wrapped cells only share a bucket, the geometric tests
+    // still tell their objects apart.
+    FBINLINE u64 pack_cell(i32 x, i32 y, i32 z) {
+        return ((u64)(x & 0x1FFFFF) << 42) | ((u64)(y & 0x1FFFFF) << 21) | (u64)(z & 0x1FFFFF);
+    }
+
+    FBINLINE u32 hash_cell(u64 key, u32 mask) {
+        return (u32)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    FBINLINE b8 spheres_overlap(const vec3f& center, f32 radius, f32 x, f32 y, f32 z, f32 object_radius) {
+        f32 dx = x - center.x;
+        f32 dy = y - center.y;
+        f32 dz = z - center.z;
+        f32 r = radius + object_radius;
+        return dx * dx + dy * dy + dz * dz <= r * r;
+    }
+
+    FBINLINE b8 box_overlaps_sphere(const aabb& box, f32 x, f32 y, f32 z, f32 radius) {
+        f32 dx = x < box.min.x ? box.min.x - x : (x > box.max.x ? x - box.max.x : 0.0f);
+        f32 dy = y < box.min.y ? box.min.y - y : (y > box.max.y ? y - box.max.y : 0.0f);
+        f32 dz = z < box.min.z ? box.min.z - z : (z > box.max.z ? z - box.max.z : 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+    FBINLINE u32 next_power_2(u32 v) {
+        u32 p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+}  // namespace
+
+/********** OBJECTS **********/
+
+b8 internal::spatial_objects_create(spatial_objects& objects, u32 capacity) {
+    if (capacity == 0) {
+        FBERROR("spatial_objects_create: capacity must be greater than 0.");
+        return false;
+    }
+
+    u64 stride = sizeof(f32) * 4 + sizeof(u64) + sizeof(u32) * 2;
+    u8* block = (u8*)memory::fballocate(stride * capacity, memory::MEMORY_TAG_SPATIAL);
+
+    // u64 first to keep it aligned.
+    objects.owner = (u64*)block;
+    objects.x = (f32*)(objects.owner + capacity);
+    objects.y = objects.x + capacity;
+    objects.z = objects.y + capacity;
+    objects.radius = objects.z + capacity;
+    objects.next = (u32*)(objects.radius + capacity);
+    objects.prev = objects.next + capacity;
+
+    objects.capacity = capacity;
+    objects.count = 0;
+
+    // Chain the free slots in order so handles are handed out from 0.
+    for (u32 i = 0; i < capacity; i++) {
+        objects.owner[i] = invalid_u64;
+        objects.next[i] = i + 1 < capacity ? i + 1 : invalid_u32;
+    }
+    objects.free_head = 0;
+
+    return true;
+}
+
+void internal::spatial_objects_destroy(spatial_objects& objects) {
+    if (objects.owner) {
+        u64 stride = sizeof(f32) * 4 + sizeof(u64) + sizeof(u32) * 2;
+        memory::fbfree(objects.owner, stride * objects.capacity, memory::MEMORY_TAG_SPATIAL);
+    }
+
+    objects = {};
+}
+
+u32 internal::spatial_objects_allocate(spatial_objects& objects) {
+    u32 handle = objects.free_head;
+    if (handle == invalid_u32) {
+        return invalid_u32;
+    }
+
+    objects.free_head = objects.next[handle];
+    objects.count++;
+    return handle;
+}
+
+void internal::spatial_objects_release(spatial_objects& objects, u32 handle) {
+    objects.owner[handle] = invalid_u64;
+    objects.next[handle] = objects.free_head;
+    objects.free_head = handle;
+    objects.count--;
+}
+
+/********** SPATIAL HASH **********/
+
+spatial_hash::~spatial_hash() {
+    destroy();
+}
+
+b8 spatial_hash::create(f32 cell_size, u32 max_objects) {
+    if (cell_size <= 0.0f) {
+        FBERROR("spatial_hash::create: cell_size must be greater than 0.");
+        return false;
+    }
+
+    destroy();
+
+    if (!internal::spatial_objects_create(objects, max_objects)) {
+        return false;
+    }
+
+    // Every object occupies at most one cell, so this keeps the load factor at or below 0.5.
+    u32 cell_capacity = next_power_2(max_objects * 2);
+    cells = (cell*)memory::fballocate(sizeof(cell) * cell_capacity, memory::MEMORY_TAG_SPATIAL);
+    for (u32 i = 0; i < cell_capacity; i++) {
+        cells[i].key = invalid_u64;
+    }
+    cell_mask = cell_capacity - 1;
+
+    inverse_cell_size = 1.0f / cell_size;
+    max_radius = 0.0f;
+
+    return true;
+}
+
+void spatial_hash::destroy() {
+    if (cells) {
+        memory::fbfree(cells, sizeof(cell) * (cell_mask + 1), memory::MEMORY_TAG_SPATIAL);
+    }
+
+    internal::spatial_objects_destroy(objects);
+    cells = nullptr;
+    cell_mask = 0;
+}
+
+u64 spatial_hash::cell_key(const vec3f& position) const {
+    return pack_cell(floor_to_int(position.x * inverse_cell_size), floor_to_int(position.y * inverse_cell_size), floor_to_int(position.z * inverse_cell_size));
+}
+
+u32 spatial_hash::find_cell(u64 key) const {
+    for (u32 slot = hash_cell(key, cell_mask);; slot = (slot + 1) & cell_mask) {
+        if (cells[slot].key == key) {
+            return slot;
+        }
+        if (cells[slot].key == invalid_u64) {
+            return invalid_u32;
+        }
+    }
+}
+
+u32 spatial_hash::add_cell(u64 key) {
+    u32 slot = hash_cell(key, cell_mask);
+    while (cells[slot].key != key && cells[slot].key != invalid_u64) {
+        slot = (slot + 1) & cell_mask;
+    }
+
+    if (cells[slot].key == invalid_u64) {
+        cells[slot] = {key, invalid_u32, 0};
+    }
+    return slot;
+}
+
+void spatial_hash::remove_cell(u32 slot) {
+    // Linear probing lets us delete without tombstones: shift back every following entry that would otherwise
+    // become unreachable from its home slot.
+    u32 hole = slot;
+    for (u32 next = (hole + 1) & cell_mask; cells[next].key != invalid_u64; next = (next + 1) & cell_mask) {
+        u32 home = hash_cell(cells[next].key, cell_mask);
+        if (((next - home) & cell_mask) >= ((next - hole) & cell_mask)) {
+            cells[hole] = cells[next];
+            hole = next;
+        }
+    }
+    cells[hole].key = invalid_u64;
+}
+
+void spatial_hash::link(u32 handle, u64 key) {
+    cell& c = cells[add_cell(key)];
+
+    objects.owner[handle] = key;
+    objects.prev[handle] = invalid_u32;
+    objects.next[handle] = c.first;
+    if (c.first != invalid_u32) {
+        objects.prev[c.first] = handle;
+    }
+    c.first = handle;
+    c.count++;
+}
+
+void spatial_hash::unlink(u32 handle) {
+    u32 slot = find_cell(objects.owner[handle]);
+    cell& c = cells[slot];
+
+    u32 prev = objects.prev[handle];
+    u32 next = objects.next[handle];
+    if (prev != invalid_u32) {
+        objects.next[prev] = next;
+    } else {
+        c.first = next;
+    }
+    if (next != invalid_u32) {
+        objects.prev[next] = prev;
+    }
+
+    if (--c.count == 0) {
+        remove_cell(slot);
+    }
+}
+
+u32 spatial_hash::insert(const vec3f& position, f32 radius) {
+    u32 handle = internal::spatial_objects_allocate(objects);
+    if (handle == invalid_u32) {
+        FBERROR("spatial_hash::insert: The hash is full (%u objects).", objects.capacity);
+        return invalid_u32;
+    }
+
+    objects.x[handle] = position.x;
+    objects.y[handle] = position.y;
+    objects.z[handle] = position.z;
+    objects.radius[handle] = radius;
+    max_radius = radius > max_radius ? radius : max_radius;
+
+    link(handle, cell_key(position));
+    return handle;
+}
+
+void spatial_hash::remove(u32 handle) {
+    if (handle >= objects.capacity || objects.owner[handle] == invalid_u64) {
+        FBERROR("spatial_hash::remove: Invalid handle %u.", handle);
+        return;
+    }
+
+    unlink(handle);
+    internal::spatial_objects_release(objects, handle);
+}
+
+void spatial_hash::move(u32 handle, const vec3f& position) {
+    update(&handle, &position, 1);
+}
+
+void spatial_hash::update(const u32* handles, const vec3f* positions, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        u32 handle = handles[i];
+        const vec3f& position = positions[i];
+
+        objects.x[handle] = position.x;
+        objects.y[handle] = position.y;
+        objects.z[handle] = position.z;
+
+        u64 key = cell_key(position);
+        if (key != objects.owner[handle]) {
+            unlink(handle);
+            link(handle, key);
+        }
+    }
+}
+
+template <typename Test>
+u32 spatial_hash::query(const vec3f& min, const vec3f& max, const Test& test, u32* out, u32 max_count) const {
+    u32 found = 0;
+
+    i32 min_x = floor_to_int((min.x - max_radius) * inverse_cell_size);
+    i32 min_y = floor_to_int((min.y - max_radius) * inverse_cell_size);
+    i32 min_z = floor_to_int((min.z - max_radius) * inverse_cell_size);
+    i32 max_x = floor_to_int((max.x + max_radius) * inverse_cell_size);
+    i32 max_y = floor_to_int((max.y + max_radius) * inverse_cell_size);
+    i32 max_z = floor_to_int((max.z + max_radius) * inverse_cell_size);
+
+    // NOTE: A query wider than the wrap-around period would visit the same cells twice.
+    if (max_x - min_x >= 0x1FFFFF || max_y - min_y >= 0x1FFFFF || max_z - min_z >= 0x1FFFFF) {
+        FBERROR("spatial_hash: Query spans too many cells, increase the cell size.");
+        return 0;
+    }
+
+    for (i32 z = min_z; z <= max_z; z++) {
+        for (i32 y = min_y; y <= max_y; y++) {
+            for (i32 x = min_x; x <= max_x; x++) {
+                u32 slot = find_cell(pack_cell(x, y, z));
+                if (slot == invalid_u32) {
+                    continue;
+                }
+
+                for (u32 handle = cells[slot].first; handle != invalid_u32; handle = objects.next[handle]) {
+                    if (test(objects.x[handle], objects.y[handle], objects.z[handle], objects.radius[handle])) {
+                        if (found < max_count) {
+                            out[found] = handle;
+                        }
+                        found++;
+                    }
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+u32 spatial_hash::query_radius(const vec3f& center, f32 radius, u32* out, u32 max_count) const {
+    if (objects.count == 0) {
+        return 0;
+    }
+
+    vec3f extent(radius);
+    auto test = [&](f32 x, f32 y, f32 z, f32 object_radius) { return spheres_overlap(center, radius, x, y, z, object_radius); };
+    return query(center - extent, center + extent, test, out, max_count);
+}
+
+u32 spatial_hash::query_box(const aabb& box, u32* out, u32 max_count) const {
+    if (objects.count == 0) {
+        return 0;
+    }
+
+    auto test = [&](f32 x, f32 y, f32 z, f32 object_radius) { return box_overlaps_sphere(box, x, y, z, object_radius); };
+    return query(box.min, box.max, test, out, max_count);
+}
+
+/********** LOOSE OCTREE **********/
+
+loose_octree::~loose_octree() {
+    destroy();
+}
+
+b8 loose_octree::create(const aabb& world_bounds, u32 max_depth, u32 max_objects) {
+    destroy();
+
+    if (!internal::spatial_objects_create(objects, max_objects)) {
+        return false;
+    }
+
+    if (max_depth > max_octree_depth) {
+        FBWARN("loose_octree::create: max_depth %u clamped to %u.", max_depth, max_octree_depth);
+        max_depth = max_octree_depth;
+    }
+    this->max_depth = max_depth;
+
+    node_capacity = max_objects / 2 > min_node_capacity ? max_objects / 2 : min_node_capacity;
+    nodes = (node*)memory::fballocate(sizeof(node) * node_capacity, memory::MEMORY_TAG_SPATIAL);
+    node_count = 0;
+    free_node = invalid_u32;
+    free_node_count = 0;
+
+    // The root is a cube around the world bounds.
+    vec3f extent = (world_bounds.max - world_bounds.min) * 0.5f;
+    f32 half_size = extent.x > extent.y ? extent.x : extent.y;
+    half_size = extent.z > half_size ? extent.z : half_size;
+    allocate_node(invalid_u32, (world_bounds.min + world_bounds.max) * 0.5f, half_size);
+
+    return true;
+}
+
+void loose_octree::destroy() {
+    if (nodes) {
+        memory::fbfree(nodes, sizeof(node) * node_capacity, memory::MEMORY_TAG_SPATIAL);
+    }
+
+    internal::spatial_objects_destroy(objects);
+    nodes = nullptr;
+    node_count = 0;
+    node_capacity = 0;
+    free_node = invalid_u32;
+    free_node_count = 0;
+}
+
+u32 loose_octree::allocate_node(u32 parent, const vec3f& center, f32 half_size) {
+    u32 index = free_node;
+    if (index != invalid_u32) {
+        free_node = nodes[index].parent;
+        free_node_count--;
+    } else {
+        if (node_count == node_capacity) {
+            u32 capacity = node_capacity * 2;
+            node* grown = (node*)memory::fballocate(sizeof(node) * capacity, memory::MEMORY_TAG_SPATIAL);
+            memory::fbcopy(grown, nodes, sizeof(node) * node_count);
+            memory::fbfree(nodes, sizeof(node) * node_capacity, memory::MEMORY_TAG_SPATIAL);
+            nodes = grown;
+            node_capacity = capacity;
+        }
+        index = node_count++;
+    }
+
+    node& n = nodes[index];
+    n.center = center;
+    n.half_size = half_size;
+    n.parent = parent;
+    for (u32 i = 0; i < 8; i++) {
+        n.child[i] = invalid_u32;
+    }
+    n.first = invalid_u32;
+    n.count = 0;
+    n.subtree_count = 0;
+
+    return index;
+}
+
+void loose_octree::release_empty(u32 index) {
+    // Walk up while nodes are empty, the root is never released.
+    while (index != 0 && nodes[index].subtree_count == 0) {
+        u32 parent = nodes[index].parent;
+        for (u32 i = 0; i < 8; i++) {
+            if (nodes[parent].child[i] == index) {
+                nodes[parent].child[i] = invalid_u32;
+                break;
+            }
+        }
+
+        // Free nodes are chained through parent.
+        nodes[index].parent = free_node;
+        free_node = index;
+        free_node_count++;
+
+        index = parent;
+    }
+}
+
+u32 loose_octree::target_node(const vec3f& position, f32 radius) {
+    u32 index = 0;
+    const node& root = nodes[0];
+
+    vec3f offset = position - root.center;
+    f32 half_size = root.half_size;
+    if (offset.x < -half_size || offset.x > half_size || offset.y < -half_size || offset.y > half_size || offset.z < -half_size || offset.z > half_size) {
+        return 0;
+    }
+
+    // An object fits in a node when its radius is at most the node's half size, since the loose bounds reach that
+    // far past the cell its center is in.
+    for (u32 depth = 0; depth < max_depth && half_size * 0.5f >= radius; depth++) {
+        const node& n = nodes[index];
+        u32 octant = (position.x >= n.center.x ? 1 : 0) | (position.y >= n.center.y ? 2 : 0) | (position.z >= n.center.z ? 4 : 0);
+
+        u32 child = n.child[octant];
+        if (child == invalid_u32) {
+            f32 quarter = n.half_size * 0.5f;
+            vec3f center(n.center.x + ((octant & 1) ? quarter : -quarter), n.center.y + ((octant & 2) ? quarter : -quarter), n.center.z + ((octant & 4) ? quarter : -quarter));
+
+            // NOTE: allocate_node may move the node array.
+            child = allocate_node(index, center, quarter);
+            nodes[index].child[octant] = child;
+        }
+
+        index = child;
+        half_size *= 0.5f;
+    }
+
+    return index;
+}
+
+void loose_octree::link(u32 handle, u32 node_index) {
+    node& n = nodes[node_index];
+
+    objects.owner[handle] = node_index;
+    objects.prev[handle] = invalid_u32;
+    objects.next[handle] = n.first;
+    if (n.first != invalid_u32) {
+        objects.prev[n.first] = handle;
+    }
+    n.first = handle;
+    n.count++;
+
+    for (u32 i = node_index; i != invalid_u32; i = nodes[i].parent) {
+        nodes[i].subtree_count++;
+    }
+}
+
+void loose_octree::unlink(u32 handle) {
+    u32 node_index = (u32)objects.owner[handle];
+    node& n = nodes[node_index];
+
+    u32 prev = objects.prev[handle];
+    u32 next = objects.next[handle];
+    if (prev != invalid_u32) {
+        objects.next[prev] = next;
+    } else {
+        n.first = next;
+    }
+    if (next != invalid_u32) {
+        objects.prev[next] = prev;
+    }
+    n.count--;
+
+    for (u32 i = node_index; i != invalid_u32; i = nodes[i].parent) {
+        nodes[i].subtree_count--;
+    }
+}
+
+u32 loose_octree::insert(const vec3f& position, f32 radius) {
+    u32 handle = internal::spatial_objects_allocate(objects);
+    if (handle == invalid_u32) {
+        FBERROR("loose_octree::insert: The tree is full (%u objects).", objects.capacity);
+        return invalid_u32;
+    }
+
+    objects.x[handle] = position.x;
+    objects.y[handle] = position.y;
+    objects.z[handle] = position.z;
+    objects.radius[handle] = radius;
+
+    link(handle, target_node(position, radius));
+    return handle;
+}
+
+void loose_octree::remove(u32 handle) {
+    if (handle >= objects.capacity || objects.owner[handle] == invalid_u64) {
+        FBERROR("loose_octree::remove: Invalid handle %u.", handle);
+        return;
+    }
+
+    u32 node_index = (u32)objects.owner[handle];
+    unlink(handle);
+    internal::spatial_objects_release(objects, handle);
+    release_empty(node_index);
+}
+
+void loose_octree::move(u32 handle, const vec3f& position) {
+    update(&handle, &position, 1);
+}
+
+void loose_octree::update(const u32* handles, const vec3f* positions, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        u32 handle = handles[i];
+        const vec3f& position = positions[i];
+
+        objects.x[handle] = position.x;
+        objects.y[handle] = position.y;
+        objects.z[handle] = position.z;
+
+        // The node depth only depends on the radius, so an object still inside its node's cell keeps the node. The
+        // root is always rechecked since it also holds objects outside the world.
+        u32 current = (u32)objects.owner[handle];
+        const node& n = nodes[current];
+        vec3f offset = position - n.center;
+        b8 inside = offset.x >= -n.half_size && offset.x < n.half_size && offset.y >= -n.half_size && offset.y < n.half_size &&
+                    offset.z >= -n.half_size && offset.z < n.half_size;
+        if (inside && current != 0) {
+            continue;
+        }
+
+        u32 target = target_node(position, objects.radius[handle]);
+        if (target != current) {
+            unlink(handle);
+            link(handle, target);
+            release_empty(current);
+        }
+    }
+}
+
+template <typename Overlaps, typename Test>
+u32 loose_octree::query(const Overlaps& overlaps, const Test& test, u32* out, u32 max_count) const {
+    u32 found = 0;
+    if (!nodes || objects.count == 0) {
+        return found;
+    }
+
+    u32 stack[max_octree_depth * 7 + 1];
+    u32 size = 0;
+    stack[size++] = 0;
+
+    while (size > 0) {
+        const node& n = nodes[stack[--size]];
+
+        for (u32 handle = n.first; handle != invalid_u32; handle = objects.next[handle]) {
+            if (test(objects.x[handle], objects.y[handle], objects.z[handle], objects.radius[handle])) {
+                if (found < max_count) {
+                    out[found] = handle;
+                }
+                found++;
+            }
+        }
+
+        for (u32 i = 0; i < 8; i++) {
+            u32 child = n.child[i];
+            if (child == invalid_u32 || nodes[child].subtree_count == 0) {
+                continue;
+            }
+
+            // Loose bounds are twice the cell.
+            const node& c = nodes[child];
+            vec3f extent(c.half_size * 2.0f);
+            if (overlaps(aabb{c.center - extent, c.center + extent})) {
+                stack[size++] = child;
+            }
+        }
+    }
+
+    return found;
+}
+
+u32 loose_octree::query_radius(const vec3f& center, f32 radius, u32* out, u32 max_count) const {
+    auto overlaps = [&](const aabb& bounds) { return box_overlaps_sphere(bounds, center.x, center.y, center.z, radius); };
+    auto test = [&](f32 x, f32 y, f32 z, f32 object_radius) { return spheres_overlap(center, radius, x, y, z, object_radius); };
+    return query(overlaps, test, out, max_count);
+}
+
+u32 loose_octree::query_box(const aabb& box, u32* out, u32 max_count) const {
+    auto overlaps = [&](const aabb& bounds) {
+        return bounds.min.x <= box.max.x && bounds.max.x >= box.min.x && bounds.min.y <= box.max.y && bounds.max.y >= box.min.y &&
+               bounds.min.z <= box.max.z && bounds.max.z >= box.min.z;
+    };
+    auto test = [&](f32 x, f32 y, f32 z, f32 object_radius) { return box_overlaps_sphere(box, x, y, z, object_radius); };
+    return query(overlaps, test, out, max_count);
+}
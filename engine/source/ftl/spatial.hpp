@@ -0,0 +1,147 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/geometry.hpp"
+
+// NOTE: Both structures below store bounding spheres for objects that move every frame. Objects are addressed by
+//       the handle returned from insert, which stays valid until the object is removed. Queries write the handles
+//       of the objects overlapping the query shape to out and return how many were found, which can exceed
+//       max_count when the result was truncated.
+
+namespace ftl {
+    namespace internal {
+        // Object storage shared by the spatial structures. Objects are kept SoA and linked into a list per cell or
+        // node, owner says which one. Free slots are chained through next with owner set to invalid_u64.
+        struct spatial_objects {
+            f32* x = nullptr;
+            f32* y = nullptr;
+            f32* z = nullptr;
+            f32* radius = nullptr;
+            u64* owner = nullptr;
+            u32* next = nullptr;
+            u32* prev = nullptr;
+
+            u32 capacity = 0;
+            u32 count = 0;
+            u32 free_head = invalid_u32;
+        };
+
+        b8 spatial_objects_create(spatial_objects& objects, u32 capacity);
+        void spatial_objects_destroy(spatial_objects& objects);
+        u32 spatial_objects_allocate(spatial_objects& objects);
+        void spatial_objects_release(spatial_objects& objects, u32 handle);
+    }  // namespace internal
+
+    // Uniform grid over an open addressed hash of the occupied cells, so memory only depends on the object count.
+    // Objects live in the cell of their center; queries widen their search by the largest radius inserted so far,
+    // which keeps the grid cheap as long as cell_size is around the diameter of a typical object.
+    class FBAPI spatial_hash {
+       public:
+        spatial_hash() = default;
+        ~spatial_hash();
+
+        b8 create(f32 cell_size, u32 max_objects);
+        void destroy();
+
+        // Returns invalid_u32 when the hash is full.
+        u32 insert(const vec3f& position, f32 radius);
+        void remove(u32 handle);
+        void move(u32 handle, const vec3f& position);
+        // Moves a batch of objects, e.g. once per frame. Only objects that changed cell touch the table.
+        void update(const u32* handles, const vec3f* positions, u32 count);
+
+        u32 query_radius(const vec3f& center, f32 radius, u32* out, u32 max_count) const;
+        u32 query_box(const aabb& box, u32* out, u32 max_count) const;
+
+        u32 get_count() const { return objects.count; }
+        vec3f get_position(u32 handle) const { return vec3f(objects.x[handle], objects.y[handle], objects.z[handle]); }
+
+       private:
+        struct cell {
+            // invalid_u64 for an empty slot.
+            u64 key;
+            u32 first;
+            u32 count;
+        };
+
+        u64 cell_key(const vec3f& position) const;
+        u32 find_cell(u64 key) const;
+        u32 add_cell(u64 key);
+        void remove_cell(u32 slot);
+
+        void link(u32 handle, u64 key);
+        void unlink(u32 handle);
+
+        template <typename Test>
+        u32 query(const vec3f& min, const vec3f& max, const Test& test, u32* out, u32 max_count) const;
+
+       private:
+        internal::spatial_objects objects;
+
+        cell* cells = nullptr;
+        u32 cell_mask = 0;
+
+        f32 inverse_cell_size = 0.0f;
+        f32 max_radius = 0.0f;
+    };
+
+    // Octree whose nodes accept objects reaching up to half a node size past their cell, so an object is stored in
+    // exactly one node picked from its radius and center and never has to be split. Nodes are created on demand
+    // and released when their subtree becomes empty. Objects outside the world bounds are kept in the root.
+    class FBAPI loose_octree {
+       public:
+        loose_octree() = default;
+        ~loose_octree();
+
+        b8 create(const aabb& world_bounds, u32 max_depth, u32 max_objects);
+        void destroy();
+
+        // Returns invalid_u32 when the tree is full.
+        u32 insert(const vec3f& position, f32 radius);
+        void remove(u32 handle);
+        void move(u32 handle, const vec3f& position);
+        // Moves a batch of objects, e.g. once per frame. Objects that stay in their node are only written.
+        void update(const u32* handles, const vec3f* positions, u32 count);
+
+        u32 query_radius(const vec3f& center, f32 radius, u32* out, u32 max_count) const;
+        u32 query_box(const aabb& box, u32* out, u32 max_count) const;
+
+        u32 get_count() const { return objects.count; }
+        u32 get_node_count() const { return node_count - free_node_count; }
+        vec3f get_position(u32 handle) const { return vec3f(objects.x[handle], objects.y[handle], objects.z[handle]); }
+
+       private:
+        struct node {
+            vec3f center;
+            // Half the size of the cell; the loose bounds reach twice as far.
+            f32 half_size;
+            u32 parent;
+            u32 child[8];
+            u32 first;
+            // Objects in this node and in the whole subtree.
+            u32 count;
+            u32 subtree_count;
+        };
+
+        u32 target_node(const vec3f& position, f32 radius);
+        u32 allocate_node(u32 parent, const vec3f& center, f32 half_size);
+        void release_empty(u32 index);
+
+        void link(u32 handle, u32 node_index);
+        void unlink(u32 handle);
+
+        template <typename Overlaps, typename Test>
+        u32 query(const Overlaps& overlaps, const Test& test, u32* out, u32 max_count) const;
+
+       private:
+        internal::spatial_objects objects;
+
+        node* nodes = nullptr;
+        u32 node_count = 0;
+        u32 node_capacity = 0;
+        u32 free_node = invalid_u32;
+        u32 free_node_count = 0;
+
+        u32 max_depth = 0;
+    };
+}  // namespace ftl
@@ -8,7 +8,7 @@
     };
 
 #define ARITHMETIC_VEC2(op)                                             \
-    vec2<T> operator op(const vec2<T>& other) const {                   \
+    constexpr vec2<T> operator op(const vec2<T>& other) const {         \
         return vec2<T>(vec[0] op other.vec[0], vec[1] op other.vec[1]); \
     }
 
@@ -28,7 +28,7 @@
     };
 
 #define ARITHMETIC_VEC3(op)                                                                     \
-    vec3<T> operator op(const vec3<T>& other) const {                                           \
+    constexpr vec3<T> operator op(const vec3<T>& other) const {                                 \
         return vec3<T>(vec[0] op other.vec[0], vec[1] op other.vec[1], vec[2] op other.vec[2]); \
     }
 
@@ -58,31 +58,31 @@
     };
 
 #define ARITHMETIC_VEC4(op)                                                                                             \
-    vec4<T> operator op(const vec4<T>& other) const {                                                                   \
+    constexpr vec4<T> operator op(const vec4<T>& other) const {                                                         \
         return vec4<T>(vec[0] op other.vec[0], vec[1] op other.vec[1], vec[2] op other.vec[2], vec[3] op other.vec[3]); \
     }
 
 template <typename T>
 struct vec2 {
-    vec2(T val = 0) : vec{val, val} {}
-    vec2(T a, T b) : vec{a, b} {}
+    constexpr vec2(T val = 0) : vec{val, val} {}
+    constexpr vec2(T a, T b) : vec{a, b} {}
 
     ARITHMETIC_VEC2(+);
     ARITHMETIC_VEC2(-);
     ARITHMETIC_VEC2(*);
     ARITHMETIC_VEC2(/);
 
-    vec2<T> operator*(T scalar) {
+    constexpr vec2<T> operator*(T scalar) const {
         return vec2<T>(vec[0] * scalar, vec[1] * scalar);
     }
 
-    vec2<T> operator/(T scalar) {
+    constexpr vec2<T> operator/(T scalar) const {
         return vec2<T>(vec[0] / scalar, vec[1] / scalar);
     }
 
-    T length_sq() { vec[0] * vec[0] + vec[1] * vec[1]; }
+    constexpr T length_sq() const { return vec[0] * vec[0] + vec[1] * vec[1]; }
 
-    f32 length() { return fbsqrt(length_sq()); }
+    f32 length() const { return fbsqrt(length_sq()); }
 
     void normalize() {
         f32 len = length();
@@ -100,27 +100,27 @@ struct vec2 {
 
 template <typename T>
 struct vec3 {
-    vec3(T val = 0) : vec{val, val, val} {}
-    vec3(T a, T b, T c) : vec{a, b, c} {}
-    vec3(const vec2<T>& vec0, T c) : vec{vec0.vec[0], vec0.vec[1], c} {}
-    vec3(T a, const vec2<T>& vec0) : vec{a, vec0.vec[0], vec0.vec[1]} {}
+    constexpr vec3(T val = 0) : vec{val, val, val} {}
+    constexpr vec3(T a, T b, T c) : vec{a, b, c} {}
+    constexpr vec3(const vec2<T>& vec0, T c) : vec{vec0.vec[0], vec0.vec[1], c} {}
+    constexpr vec3(T a, const vec2<T>& vec0) : vec{a, vec0.vec[0], vec0.vec[1]} {}
 
     ARITHMETIC_VEC3(+);
     ARITHMETIC_VEC3(-);
     ARITHMETIC_VEC3(*);
     ARITHMETIC_VEC3(/);
 
-    vec3<T> operator*(T scalar) {
+    constexpr vec3<T> operator*(T scalar) const {
         return vec3<T>(vec[0] * scalar, vec[1] * scalar, vec[2] * scalar);
     }
 
-    vec3<T> operator/(T scalar) {
+    constexpr vec3<T> operator/(T scalar) const {
         return vec3<T>(vec[0] / scalar, vec[1] / scalar, vec[2] / scalar);
     }
 
-    T length_sq() { return vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]; }
+    constexpr T length_sq() const { return vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]; }
 
-    f32 length() { return fbsqrt(length_sq()); }
+    f32 length() const { return fbsqrt(length_sq()); }
 
     void normalize() {
         f32 len = length();
@@ -139,29 +139,29 @@ struct vec3 {
 
 template <typename T>
 struct vec4 {
-    vec4(T val = 0) : vec{val, val, val, val} {}
-    vec4(T a, T b, T c, T d) : vec{a, b, c, d} {}
-    vec4(const vec2<T>& vec0, const vec2<T>& vec1) : vec{vec0.vec[0], vec0.vec[1], vec1.vec[0], vec1.vec[1]} {}
-    vec4(T a, const vec2<T>& vec0, T d) : vec{a, vec0.vec[0], vec0.vec[1], d} {}
-    vec4(const vec3<T>& vec0, T d) : vec{vec0.vec[0], vec0.vec[1], vec0.vec[2], d} {}
-    vec4(T a, const vec3<T>& vec1) : vec{a, vec1.vec[0], vec1.vec[1], vec1.vec[2]} {}
+    constexpr vec4(T val = 0) : vec{val, val, val, val} {}
+    constexpr vec4(T a, T b, T c, T d) : vec{a, b, c, d} {}
+    constexpr vec4(const vec2<T>& vec0, const vec2<T>& vec1) : vec{vec0.vec[0], vec0.vec[1], vec1.vec[0], vec1.vec[1]} {}
+    constexpr vec4(T a, const vec2<T>& vec0, T d) : vec{a, vec0.vec[0], vec0.vec[1], d} {}
+    constexpr vec4(const vec3<T>& vec0, T d) : vec{vec0.vec[0], vec0.vec[1], vec0.vec[2], d} {}
+    constexpr vec4(T a, const vec3<T>& vec1) : vec{a, vec1.vec[0], vec1.vec[1], vec1.vec[2]} {}
 
     ARITHMETIC_VEC4(+);
     ARITHMETIC_VEC4(-);
     ARITHMETIC_VEC4(*);
     ARITHMETIC_VEC4(/);
 
-    vec4<T> operator*(T scalar) {
+    constexpr vec4<T> operator*(T scalar) const {
         return vec4<T>(vec[0] * scalar, vec[1] * scalar, vec[2] * scalar, vec[3] * scalar);
     }
 
-    vec4<T> operator/(T scalar) {
+    constexpr vec4<T> operator/(T scalar) const {
         return vec4<T>(vec[0] / scalar, vec[1] / scalar, vec[2] / scalar, vec[3] / scalar);
     }
 
-    T length_sq() { vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2] + vec[3] * vec[3]; }
+    constexpr T length_sq() const { return vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2] + vec[3] * vec[3]; }
 
-    f32 length() { return fbsqrt(length_sq()); }
+    f32 length() const { return fbsqrt(length_sq()); }
 
     void normalize() {
         f32 len = length();
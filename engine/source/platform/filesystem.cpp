@@ -59,13 +59,20 @@ b8 filesystem::file::write_line(const char* text) {
             result = fputc('\n', (FILE*)handle);
         }
 
-        fflush((FILE*)handle);
         return result != EOF;
     }
 
     return false;
 }
 
+b8 filesystem::file::flush() {
+    if (handle) {
+        return fflush((FILE*)handle) == 0;
+    }
+
+    return false;
+}
+
 b8 filesystem::file::read(void* data, u64* bytesRead, u64 dataSize) {
     if (handle && data) {
         *bytesRead = fread(data, 1, dataSize, (FILE*)handle);
@@ -103,4 +110,18 @@ b8 filesystem::file::write(const void* data, u64* bytesWritten, u64 dataSize) {
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+b8 filesystem::rename(const char* from, const char* to) {
+    if (!file::exists(from)) {
+        return false;
+    }
+
+    // NOTE: The C runtime on Windows doesn't replace an existing file.
+    ::remove(to);
+    return ::rename(from, to) == 0;
+}
+
+b8 filesystem::remove(const char* path) {
+    return ::remove(path) == 0;
+}
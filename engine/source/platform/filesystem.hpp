@@ -13,14 +13,16 @@ namespace fabric::filesystem {
         file() = default;
         ~file() = default;
 
-        b8 exists(const char* path);
+        static b8 exists(const char* path);
         b8 open(const char* path, file_modes mode, b8 binary);
         void close();
 
         b8 is_valid() { return handle != nullptr; }
 
         b8 read_line(char** buffer);
+        // Buffered, call flush when the lines have to reach the file.
         b8 write_line(const char* text);
+        b8 flush();
 
         b8 read(void* data, u64* bytesRead, u64 dataSize);
         b8 read(u8** data, u64* bytesRead);
@@ -29,4 +31,8 @@ namespace fabric::filesystem {
        private:
         void* handle = nullptr;
     };
+
+    // Replaces to when it exists. Fails, leaving to alone, when from doesn't exist.
+    FBAPI b8 rename(const char* from, const char* to);
+    FBAPI b8 remove(const char* path);
 }  // namespace fabric::filesystem
\ No newline at end of file
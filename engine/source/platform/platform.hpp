@@ -28,4 +28,29 @@ namespace fabric::platform {
     f64 get_absolute_time();
 
     void sleep(u64 ms);
+
+    struct thread {
+        void* internal_handle = nullptr;
+        u64 id = 0;
+    };
+
+    typedef u32 (*thread_start_pfn)(void* params);
+
+    b8 thread_create(thread_start_pfn start, void* params, thread& out_thread);
+    // Blocks until the thread returns, then releases it.
+    void thread_wait(thread& t);
+    u64 get_current_thread_id();
+
+    struct semaphore {
+        void* internal_handle = nullptr;
+    };
+
+    b8 semaphore_create(u32 initial_count, semaphore& out_semaphore);
+    void semaphore_destroy(semaphore& s);
+    void semaphore_signal(semaphore& s);
+    // Returns false when the timeout ran out first.
+    b8 semaphore_wait(semaphore& s, u64 timeout_ms);
+
+    // Number of logical processors, at least 1.
+    u32 get_processor_count();
 }  // namespace fabric::platform
\ No newline at end of file
@@ -183,6 +183,66 @@ void platform::sleep(u64 ms) {
     Sleep(ms);
 }
 
+b8 platform::thread_create(thread_start_pfn start, void* params, thread& out_thread) {
+    DWORD id = 0;
+    HANDLE handle = CreateThread(0, 0, (LPTHREAD_START_ROUTINE)start, params, 0, &id);
+    if (!handle) {
+        FBERROR("platform::thread_create: CreateThread failed with error %u.", (u32)GetLastError());
+        return false;
+    }
+
+    out_thread.internal_handle = handle;
+    out_thread.id = id;
+    return true;
+}
+
+void platform::thread_wait(thread& t) {
+    if (!t.internal_handle) {
+        return;
+    }
+
+    WaitForSingleObject((HANDLE)t.internal_handle, INFINITE);
+    CloseHandle((HANDLE)t.internal_handle);
+    t.internal_handle = nullptr;
+    t.id = 0;
+}
+
+u64 platform::get_current_thread_id() {
+    return GetCurrentThreadId();
+}
+
+b8 platform::semaphore_create(u32 initial_count, semaphore& out_semaphore) {
+    HANDLE handle = CreateSemaphoreA(0, (LONG)initial_count, 0x7FFFFFFF, 0);
+    if (!handle) {
+        FBERROR("platform::semaphore_create: CreateSemaphoreA failed with error %u.", (u32)GetLastError());
+        return false;
+    }
+
+    out_semaphore.internal_handle = handle;
+    return true;
+}
+
+void platform::semaphore_destroy(semaphore& s) {
+    if (s.internal_handle) {
+        CloseHandle((HANDLE)s.internal_handle);
+        s.internal_handle = nullptr;
+    }
+}
+
+void platform::semaphore_signal(semaphore& s) {
+    ReleaseSemaphore((HANDLE)s.internal_handle, 1, 0);
+}
+
+b8 platform::semaphore_wait(semaphore& s, u64 timeout_ms) {
+    return WaitForSingleObject((HANDLE)s.internal_handle, (DWORD)timeout_ms) == WAIT_OBJECT_0;
+}
+
+u32 platform::get_processor_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+}
+
 b8 filesystem::file::exists(const char* path) {
     DWORD attribs = GetFileAttributesA(path);
     return (attribs != INVALID_FILE_ATTRIBUTES && !(attribs & FILE_ATTRIBUTE_DIRECTORY));
@@ -213,7 +273,7 @@ LRESULT CALLBACK win32_process_message(HWND hWnd, u32 msg, WPARAM wParam, LPARAM
             context.data.u16[0] = (u16)width;
             context.data.u16[1] = (u16)height;
 
-            event::send(event::RESIZED, nullptr, context);
+            event::post(event::RESIZED, nullptr, context);
         } break;
 
         case WM_KEYDOWN:
@@ -475,19 +475,19 @@ descriptor_allocation backend::create_writable_texture_view(ID3D12Resource2* res
 void CALLBACK d3d12_report_validation(D3D12_MESSAGE_CATEGORY category, D3D12_MESSAGE_SEVERITY severity, D3D12_MESSAGE_ID messageID, LPCSTR message, void* context) {
     switch (severity) {
         case D3D12_MESSAGE_SEVERITY_CORRUPTION:
-            FBFATAL(message);
+            FBFATAL("%s", message);
             break;
         case D3D12_MESSAGE_SEVERITY_ERROR:
-            FBERROR(message);
+            FBERROR("%s", message);
             break;
         case D3D12_MESSAGE_SEVERITY_WARNING:
-            FBWARN(message);
+            FBWARN("%s", message);
             break;
         case D3D12_MESSAGE_SEVERITY_INFO:
-            FBINFO(message);
+            FBINFO("%s", message);
             break;
         case D3D12_MESSAGE_SEVERITY_MESSAGE:
-            FBDEBUG(message);
+            FBDEBUG("%s", message);
             break;
     }
 }
\ No newline at end of file
@@ -64,7 +64,7 @@ b8 d3d12_device::create(IDXGIFactory7* dxgiFactory) {
     HRESULT hr = D3D12CreateDevice(physical_adapter, max_supported_feature_level, IID_PPV_ARGS(&logical_device));
 
     if (FAILED(hr)) {
-        FBERROR("Logical device creation failed with error %s", hr);
+        FBERROR("Logical device creation failed with error 0x%08X", (u32)hr);
         return false;
     }
 
@@ -0,0 +1,364 @@
+#include "scene/transform_hierarchy.hpp"
+#include "core/logger.hpp"
+#include "core/memory.hpp"
+#include "ftl/simd.hpp"
+
+using namespace fabric;
+using namespace ftl;
+
+namespace {
+    FBINLINE u64 word_count(u32 count) {
+        return ((u64)count + 63) / 64;
+    }
+
+    FBINLINE u64 node_stride() {
+        return sizeof(vec3f) * 2 + sizeof(quat) + sizeof(affine3) + sizeof(u32) * 5;
+    }
+
+    // data[i] = data[order[i]], through scratch.
+    template <typename T>
+    void permute(T* data, const u32* order, u32 count, void* scratch) {
+        T* temp = (T*)scratch;
+        for (u32 i = 0; i < count; i++) {
+            temp[i] = data[order[i]];
+        }
+        memory::fbcopy(data, temp, sizeof(T) * count);
+    }
+}  // namespace
+
+scene::transform_hierarchy::~transform_hierarchy() {
+    destroy();
+}
+
+b8 scene::transform_hierarchy::create(u32 capacity) {
+    if (capacity == 0) {
+        FBERROR("transform_hierarchy::create: capacity must be greater than 0.");
+        return false;
+    }
+
+    destroy();
+
+    // affine3 first since it has the largest alignment.
+    u8* block = (u8*)memory::fballocate(node_stride() * capacity + sizeof(u64) * word_count(capacity), memory::MEMORY_TAG_SCENE);
+    dirty = (u64*)block;
+    worlds = (affine3*)(dirty + word_count(capacity));
+    rotations = (quat*)(worlds + capacity);
+    positions = (vec3f*)(rotations + capacity);
+    scales = positions + capacity;
+    parents = (u32*)(scales + capacity);
+    subtree_sizes = parents + capacity;
+    handles = subtree_sizes + capacity;
+    indices = handles + capacity;
+    free_handles = indices + capacity;
+
+    memory::fbzero(dirty, sizeof(u64) * word_count(capacity));
+
+    // Handed out from 0 upwards.
+    for (u32 i = 0; i < capacity; i++) {
+        free_handles[i] = capacity - 1 - i;
+        indices[i] = invalid_u32;
+    }
+    free_handle_count = capacity;
+
+    this->capacity = capacity;
+    count = 0;
+    dead_count = 0;
+    order_dirty = false;
+    ranges_stale = false;
+
+    return true;
+}
+
+void scene::transform_hierarchy::destroy() {
+    if (dirty) {
+        memory::fbfree(dirty, node_stride() * capacity + sizeof(u64) * word_count(capacity), memory::MEMORY_TAG_SCENE);
+    }
+
+    dirty = nullptr;
+    worlds = nullptr;
+    rotations = nullptr;
+    positions = nullptr;
+    scales = nullptr;
+    parents = nullptr;
+    subtree_sizes = nullptr;
+    handles = nullptr;
+    indices = nullptr;
+    free_handles = nullptr;
+    free_handle_count = 0;
+    capacity = 0;
+    count = 0;
+    dead_count = 0;
+}
+
+u32 scene::transform_hierarchy::add(u32 parent, const vec3f& position, const quat& rotation, const vec3f& scale) {
+    u32 parent_index = invalid_u32;
+    if (parent != invalid_u32) {
+        parent_index = parent < capacity ? indices[parent] : invalid_u32;
+        if (parent_index == invalid_u32) {
+            FBERROR("transform_hierarchy::add: Invalid parent %u.", parent);
+            return invalid_u32;
+        }
+    }
+
+    if (count == capacity && dead_count > 0) {
+        rebuild_order();
+        if (parent != invalid_u32) {
+            parent_index = indices[parent];
+        }
+    }
+
+    if (count == capacity) {
+        FBERROR("transform_hierarchy::add: The hierarchy is full (%u nodes).", capacity);
+        return invalid_u32;
+    }
+
+    u32 handle = free_handles[--free_handle_count];
+    u32 index = count++;
+
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    parents[index] = parent_index;
+    subtree_sizes[index] = 1;
+    handles[index] = handle;
+    indices[handle] = index;
+    mark_dirty(index);
+
+    if (parent_index != invalid_u32) {
+        if (!ranges_stale && parent_index + subtree_sizes[parent_index] == index) {
+            // Appended right behind the parent's subtree, so the order holds. Every ancestor's subtree ended at
+            // the same place.
+            for (u32 i = parent_index; i != invalid_u32; i = parents[i]) {
+                subtree_sizes[i]++;
+            }
+        } else {
+            order_dirty = true;
+            ranges_stale = true;
+        }
+    }
+
+    return handle;
+}
+
+void scene::transform_hierarchy::remove(u32 handle) {
+    if (handle >= capacity || indices[handle] == invalid_u32) {
+        FBERROR("transform_hierarchy::remove: Invalid handle %u.", handle);
+        return;
+    }
+
+    if (ranges_stale) {
+        rebuild_order();
+    }
+
+    // The subtree is a contiguous range. It is left in place and compacted by the next rebuild.
+    u32 index = indices[handle];
+    u32 end = index + subtree_sizes[index];
+    for (u32 i = index; i < end; i++) {
+        if (handles[i] == invalid_u32) {
+            continue;
+        }
+
+        indices[handles[i]] = invalid_u32;
+        free_handles[free_handle_count++] = handles[i];
+        handles[i] = invalid_u32;
+        dead_count++;
+    }
+
+    order_dirty = true;
+}
+
+void scene::transform_hierarchy::set_local(u32 handle, const vec3f& position, const quat& rotation, const vec3f& scale) {
+    u32 index = indices[handle];
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    mark_dirty(index);
+}
+
+void scene::transform_hierarchy::set_position(u32 handle, const vec3f& position) {
+    u32 index = indices[handle];
+    positions[index] = position;
+    mark_dirty(index);
+}
+
+void scene::transform_hierarchy::set_rotation(u32 handle, const quat& rotation) {
+    u32 index = indices[handle];
+    rotations[index] = rotation;
+    mark_dirty(index);
+}
+
+void scene::transform_hierarchy::set_scale(u32 handle, const vec3f& scale) {
+    u32 index = indices[handle];
+    scales[index] = scale;
+    mark_dirty(index);
+}
+
+u32 scene::transform_hierarchy::get_parent(u32 handle) const {
+    u32 parent = parents[indices[handle]];
+    return parent != invalid_u32 ? handles[parent] : invalid_u32;
+}
+
+void scene::transform_hierarchy::rebuild_order() {
+    u32 live = count - dead_count;
+
+    // order, first_child, next_sibling, stack and a scratch buffer for permuting the widest array.
+    u64 scratch_size = sizeof(u32) * 4 * (u64)count + sizeof(affine3) * (u64)live;
+    u32* order = (u32*)memory::fballocate(scratch_size, memory::MEMORY_TAG_SCENE);
+    u32* first_child = order + count;
+    u32* next_sibling = first_child + count;
+    u32* stack = next_sibling + count;
+    void* scratch = stack + count;
+
+    // Parents always come before their children, whether they were added in order or not, so a backwards pass
+    // builds every child list sorted by position.
+    u32 first_root = invalid_u32;
+    for (u32 i = 0; i < count; i++) {
+        first_child[i] = invalid_u32;
+    }
+    for (u32 i = count; i-- > 0;) {
+        if (handles[i] == invalid_u32) {
+            continue;
+        }
+
+        u32& head = parents[i] == invalid_u32 ? first_root : first_child[parents[i]];
+        next_sibling[i] = head;
+        head = i;
+    }
+
+    // Pre-order walk. Siblings are pushed last to first so they pop in order.
+    u32 ordered = 0;
+    u32 stack_size = 0;
+    auto push_list = [&](u32 first) {
+        u32 begin = stack_size;
+        for (u32 i = first; i != invalid_u32; i = next_sibling[i]) {
+            stack[stack_size++] = i;
+        }
+        for (u32 a = begin, b = stack_size; a + 1 < b; a++, b--) {
+            u32 swap = stack[a];
+            stack[a] = stack[b - 1];
+            stack[b - 1] = swap;
+        }
+    };
+
+    push_list(first_root);
+    while (stack_size > 0) {
+        u32 i = stack[--stack_size];
+        order[ordered++] = i;
+        push_list(first_child[i]);
+    }
+
+    // Dirty bits move with their nodes.
+    u32* dirty_flags = first_child;
+    for (u32 i = 0; i < live; i++) {
+        u32 old = order[i];
+        dirty_flags[i] = (dirty[old >> 6] >> (old & 63)) & 1;
+    }
+    memory::fbzero(dirty, sizeof(u64) * word_count(count));
+    for (u32 i = 0; i < live; i++) {
+        if (dirty_flags[i]) {
+            mark_dirty(i);
+        }
+    }
+
+    // Parents are remapped through the new position of every old one.
+    u32* new_index = next_sibling;
+    for (u32 i = 0; i < live; i++) {
+        new_index[order[i]] = i;
+    }
+
+    permute(positions, order, live, scratch);
+    permute(rotations, order, live, scratch);
+    permute(scales, order, live, scratch);
+    permute(worlds, order, live, scratch);
+    permute(parents, order, live, scratch);
+    permute(handles, order, live, scratch);
+
+    for (u32 i = 0; i < live; i++) {
+        parents[i] = parents[i] != invalid_u32 ? new_index[parents[i]] : invalid_u32;
+        indices[handles[i]] = i;
+        subtree_sizes[i] = 1;
+    }
+    for (u32 i = live; i-- > 0;) {
+        if (parents[i] != invalid_u32) {
+            subtree_sizes[parents[i]] += subtree_sizes[i];
+        }
+    }
+
+    memory::fbfree(order, scratch_size, memory::MEMORY_TAG_SCENE);
+
+    count = live;
+    dead_count = 0;
+    order_dirty = false;
+    ranges_stale = false;
+}
+
+void scene::transform_hierarchy::update() {
+    if (order_dirty) {
+        rebuild_order();
+    }
+
+    update_range(0, count);
+    finish_update();
+}
+
+u32 scene::transform_hierarchy::partition(u32 max_ranges, u32* begins, u32* ends) {
+    if (order_dirty) {
+        rebuild_order();
+    }
+
+    if (count == 0 || max_ranges == 0) {
+        return 0;
+    }
+
+    // Cut at the first root boundary past each even share.
+    u32 target = (count + max_ranges - 1) / max_ranges;
+    u32 range_count = 0;
+    u32 begin = 0;
+    for (u32 root = 0; root < count; root += subtree_sizes[root]) {
+        u32 end = root + subtree_sizes[root];
+        if (end - begin >= target || end == count || range_count + 1 == max_ranges) {
+            if (range_count + 1 == max_ranges) {
+                end = count;
+            }
+            begins[range_count] = begin;
+            ends[range_count] = end;
+            range_count++;
+            begin = end;
+            if (end == count) {
+                break;
+            }
+        }
+    }
+
+    return range_count;
+}
+
+void scene::transform_hierarchy::update_range(u32 begin, u32 end) {
+    // Everything below covered has been recomputed already, as part of a dirty ancestor's subtree.
+    u32 covered = begin;
+
+    while (covered < end) {
+        u32 word = covered >> 6;
+        u64 bits = dirty[word] & (~0ull << (covered & 63));
+        if (!bits) {
+            covered = (word + 1) << 6;
+            continue;
+        }
+
+        u32 index = (word << 6) + count_trailing_zeros(bits);
+        if (index >= end) {
+            break;
+        }
+
+        u32 subtree_end = index + subtree_sizes[index];
+        for (u32 i = index; i < subtree_end; i++) {
+            affine3 local = compose(positions[i], rotations[i], scales[i]);
+            worlds[i] = parents[i] != invalid_u32 ? local * worlds[parents[i]] : local;
+        }
+        covered = subtree_end;
+    }
+}
+
+void scene::transform_hierarchy::finish_update() {
+    memory::fbzero(dirty, sizeof(u64) * word_count(count));
+}
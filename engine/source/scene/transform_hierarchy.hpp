@@ -0,0 +1,84 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ftl/affine.hpp"
+
+// NOTE: Nodes are kept in depth-first order in SoA arrays, so every subtree is a contiguous range and parents
+//       come before their children. Updating world transforms is then a forward walk over the dirty ranges only.
+//       Nodes are addressed by handles that stay valid until the node is removed, the position behind a handle
+//       changes whenever the order is rebuilt. Adding a node at the end of its parent's subtree keeps the order
+//       intact; any other add or remove rebuilds it, in O(n), at the next update.
+
+namespace fabric::scene {
+    class FBAPI transform_hierarchy {
+       public:
+        transform_hierarchy() = default;
+        ~transform_hierarchy();
+
+        b8 create(u32 capacity);
+        void destroy();
+
+        // parent is invalid_u32 for a root. Returns invalid_u32 when the hierarchy is full.
+        u32 add(u32 parent, const ftl::vec3f& position = ftl::vec3f(0.0f), const ftl::quat& rotation = ftl::quat(),
+                const ftl::vec3f& scale = ftl::vec3f(1.0f));
+        // Removes the node and everything below it.
+        void remove(u32 handle);
+
+        void set_local(u32 handle, const ftl::vec3f& position, const ftl::quat& rotation, const ftl::vec3f& scale);
+        void set_position(u32 handle, const ftl::vec3f& position);
+        void set_rotation(u32 handle, const ftl::quat& rotation);
+        void set_scale(u32 handle, const ftl::vec3f& scale);
+
+        const ftl::vec3f& get_position(u32 handle) const { return positions[indices[handle]]; }
+        const ftl::quat& get_rotation(u32 handle) const { return rotations[indices[handle]]; }
+        const ftl::vec3f& get_scale(u32 handle) const { return scales[indices[handle]]; }
+        // Only up to date after update.
+        const ftl::affine3& get_world(u32 handle) const { return worlds[indices[handle]]; }
+        ftl::mat4 get_world_matrix(u32 handle) const { return worlds[indices[handle]].to_mat4(); }
+        // invalid_u32 for roots.
+        u32 get_parent(u32 handle) const;
+        u32 get_count() const { return count - dead_count; }
+
+        // Recomputes the world transforms of the changed nodes and their descendants.
+        void update();
+
+        // Multi-threaded update: partition splits the nodes into at most max_ranges ranges of whole root subtrees,
+        // writing their bounds to begins and ends. update_range can then run for each range on its own thread,
+        // and finish_update has to be called once all of them are done.
+        u32 partition(u32 max_ranges, u32* begins, u32* ends);
+        void update_range(u32 begin, u32 end);
+        void finish_update();
+
+       private:
+        void mark_dirty(u32 index) { dirty[index >> 6] |= 1ull << (index & 63); }
+        void rebuild_order();
+
+       private:
+        // Indexed by position in depth-first order.
+        ftl::vec3f* positions = nullptr;
+        ftl::quat* rotations = nullptr;
+        ftl::vec3f* scales = nullptr;
+        ftl::affine3* worlds = nullptr;
+        // Position of the parent, invalid_u32 for roots.
+        u32* parents = nullptr;
+        // Number of nodes in the subtree, the node included.
+        u32* subtree_sizes = nullptr;
+        // invalid_u32 for removed nodes still waiting for the order to be rebuilt.
+        u32* handles = nullptr;
+        u64* dirty = nullptr;
+
+        // Indexed by handle.
+        u32* indices = nullptr;
+        u32* free_handles = nullptr;
+        u32 free_handle_count = 0;
+
+        u32 capacity = 0;
+        // Positions in use, removed nodes included until the next rebuild.
+        u32 count = 0;
+        u32 dead_count = 0;
+        // Removed nodes or nodes added out of order are waiting for a rebuild.
+        b8 order_dirty = false;
+        // Nodes were added out of order, so subtree_sizes no longer cover whole subtrees.
+        b8 ranges_stale = false;
+    };
+}  // namespace fabric::scene